@@ -0,0 +1,205 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "arc_policy.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+void ArcPolicy::GhostList::pushFront(const std::uint64_t key) {
+  keys.push_front(key);
+  index[key] = keys.begin();
+}
+
+void ArcPolicy::GhostList::erase(const std::uint64_t key) {
+  std::unordered_map<std::uint64_t, std::list<std::uint64_t>::iterator>::
+      iterator it = index.find(key);
+  if (it != index.end()) {
+    keys.erase(it->second);
+    index.erase(it);
+  }
+}
+
+void ArcPolicy::GhostList::popBack() {
+  index.erase(keys.back());
+  keys.pop_back();
+}
+
+ArcPolicy::ArcPolicy(const FrameId firstFrame, const std::uint32_t numFrames)
+    : first_frame_(firstFrame),
+      capacity_(numFrames),
+      target_(0),
+      frames_(numFrames),
+      missed_key_(0),
+      missed_in_(NONE) {
+  for (std::uint32_t i = 0; i < numFrames; ++i) {
+    frames_[i].queue = NONE;
+    frames_[i].key = 0;
+    free_.insert(first_frame_ + i);
+  }
+}
+
+void ArcPolicy::onHit(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == T1) {
+    t2_.splice(t2_.begin(), t1_, state.position);
+    state.queue = T2;
+  } else if (state.queue == T2) {
+    t2_.splice(t2_.begin(), t2_, state.position);
+  }
+}
+
+void ArcPolicy::onMiss(const File* file, const PageId pageNo) {
+  missed_key_ = pageKey(file, pageNo);
+  missed_in_ = NONE;
+  if (b1_.contains(missed_key_)) {
+    // T1 was too small to keep the page: grow its target.
+    const std::size_t delta = std::max<std::size_t>(
+        1, b2_.keys.size() / b1_.keys.size());
+    target_ = std::min(capacity_, target_ + delta);
+    missed_in_ = B1;
+  } else if (b2_.contains(missed_key_)) {
+    // T2 was too small to keep the page: shrink the target of T1.
+    const std::size_t delta = std::max<std::size_t>(
+        1, b1_.keys.size() / b2_.keys.size());
+    target_ = target_ > delta ? target_ - delta : 0;
+    missed_in_ = B2;
+  }
+}
+
+bool ArcPolicy::takeFrom(const std::list<FrameId>& list,
+                         const TakeFrame& take, FrameId& frame) {
+  for (std::list<FrameId>::const_reverse_iterator it = list.rbegin();
+       it != list.rend(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ArcPolicy::listFrom(const std::list<FrameId>& list,
+                         const std::uint32_t count, std::vector<FrameId>& frames) {
+  std::uint32_t listed = 0;
+  for (std::list<FrameId>::const_reverse_iterator it = list.rbegin();
+       it != list.rend() && listed < count; ++it, ++listed) {
+    frames.push_back(*it);
+  }
+}
+
+bool ArcPolicy::pickVictim(const TakeFrame& take, FrameId& frame) {
+  for (std::set<FrameId>::const_iterator it = free_.begin();
+       it != free_.end(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+  // REPLACE from the paper; pinned pages are skipped, and if all pages of the
+  // preferred list are pinned the other list is tried.
+  const bool fromT1 = !t1_.empty() &&
+      (t1_.size() > target_ || (missed_in_ == B2 && t1_.size() == target_));
+  if (fromT1) {
+    return takeFrom(t1_, take, frame) || takeFrom(t2_, take, frame);
+  }
+  return takeFrom(t2_, take, frame) || takeFrom(t1_, take, frame);
+}
+
+void ArcPolicy::nextVictims(const std::uint32_t count,
+                            std::vector<FrameId>& frames) const {
+  const std::size_t before = frames.size();
+  if (!t1_.empty() && t1_.size() >= target_) {
+    listFrom(t1_, count, frames);
+    listFrom(t2_, count - (frames.size() - before), frames);
+  } else {
+    listFrom(t2_, count, frames);
+    listFrom(t1_, count - (frames.size() - before), frames);
+  }
+}
+
+void ArcPolicy::onEvict(const FrameId frame) {
+  const FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == T1) {
+    b1_.pushFront(state.key);
+  } else if (state.queue == T2) {
+    b2_.pushFront(state.key);
+  }
+  release(frame);
+}
+
+void ArcPolicy::onLoad(const FrameId frame, const File* file,
+                       const PageId pageNo) {
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  const bool ghostHit = state.key == missed_key_ &&
+      (missed_in_ == B1 || missed_in_ == B2);
+  if (ghostHit) {
+    (missed_in_ == B1 ? b1_ : b2_).erase(state.key);
+    t2_.push_front(frame);
+    state.queue = T2;
+    state.position = t2_.begin();
+  } else {
+    // The page may be in a ghost list if onMiss() was not called for it.
+    b1_.erase(state.key);
+    b2_.erase(state.key);
+    t1_.push_front(frame);
+    state.queue = T1;
+    state.position = t1_.begin();
+  }
+  missed_in_ = NONE;
+  trimGhosts();
+}
+
+void ArcPolicy::onLoadCold(const FrameId frame, const File* file,
+                           const PageId pageNo) {
+  // The back of T1 goes first.
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  b1_.erase(state.key);
+  b2_.erase(state.key);
+  t1_.push_back(frame);
+  state.queue = T1;
+  state.position = --t1_.end();
+  trimGhosts();
+}
+
+void ArcPolicy::trimGhosts() {
+  while (t1_.size() + b1_.keys.size() > capacity_ && !b1_.keys.empty()) {
+    b1_.popBack();
+  }
+  while (t1_.size() + t2_.size() + b1_.keys.size() + b2_.keys.size() >
+         2 * capacity_) {
+    if (!b2_.keys.empty()) {
+      b2_.popBack();
+    } else if (!b1_.keys.empty()) {
+      b1_.popBack();
+    } else {
+      break;
+    }
+  }
+}
+
+void ArcPolicy::onRemove(const FrameId frame) {
+  release(frame);
+}
+
+void ArcPolicy::release(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == T1) {
+    t1_.erase(state.position);
+  } else if (state.queue == T2) {
+    t2_.erase(state.position);
+  }
+  state.queue = NONE;
+  free_.insert(frame);
+}
+
+}
@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Adaptive Replacement Cache (Megiddo and Modha).
+ *
+ * Resident pages are kept in two LRU lists: T1 for pages seen once recently
+ * and T2 for pages seen at least twice.  The keys of pages evicted from them
+ * are remembered in the ghost lists B1 and B2.  A miss on a key in B1 means
+ * T1 was too small, and a miss on a key in B2 means T2 was too small; the
+ * policy moves its target size p for T1 accordingly and evicts from T1 while
+ * T1 is larger than p.  Together the lists remember at most twice as many
+ * pages as there are frames.
+ */
+class ArcPolicy : public ReplacementPolicy {
+ public:
+  ArcPolicy(const FrameId firstFrame, const std::uint32_t numFrames);
+
+  const char* name() const { return "ARC"; }
+  void onHit(const FrameId frame);
+  void onMiss(const File* file, const PageId pageNo);
+  bool pickVictim(const TakeFrame& take, FrameId& frame);
+  void onEvict(const FrameId frame);
+  void onLoad(const FrameId frame, const File* file, const PageId pageNo);
+  void onLoadCold(const FrameId frame, const File* file,
+                  const PageId pageNo);
+  void onRemove(const FrameId frame);
+  void nextVictims(const std::uint32_t count,
+                   std::vector<FrameId>& frames) const;
+
+ private:
+  /**
+   * Lists a page can be in.
+   */
+  enum Queue { NONE, T1, T2, B1, B2 };
+
+  /**
+   * @brief State of one frame.
+   */
+  struct FrameState {
+    Queue queue;
+    std::list<FrameId>::iterator position;
+    std::uint64_t key;
+  };
+
+  /**
+   * @brief Ghost list of keys, most recent first, with an index of its keys.
+   */
+  struct GhostList {
+    std::list<std::uint64_t> keys;
+    std::unordered_map<std::uint64_t, std::list<std::uint64_t>::iterator>
+        index;
+
+    bool contains(const std::uint64_t key) const {
+      return index.find(key) != index.end();
+    }
+    void pushFront(const std::uint64_t key);
+    void erase(const std::uint64_t key);
+    void popBack();
+  };
+
+  /**
+   * Takes the first frame of the list, from its back, that take accepts.
+   */
+  static bool takeFrom(const std::list<FrameId>& list, const TakeFrame& take,
+                       FrameId& frame);
+
+  /**
+   * Appends frames of the list, from its back, until count frames are listed.
+   */
+  static void listFrom(const std::list<FrameId>& list,
+                       const std::uint32_t count, std::vector<FrameId>& frames);
+
+  /**
+   * Forgets the oldest ghosts: T1 and B1 together hold at most c pages, all
+   * four lists at most 2c.
+   */
+  void trimGhosts();
+
+  /**
+   * Unlinks a frame from its list and frees it.
+   */
+  void release(const FrameId frame);
+
+  const FrameId first_frame_;
+
+  /**
+   * Number of frames managed by the policy (c in the paper).
+   */
+  const std::size_t capacity_;
+
+  /**
+   * Target size of T1.
+   */
+  std::size_t target_;
+
+  /**
+   * State of every frame, indexed by frame - first_frame_.
+   */
+  std::vector<FrameState> frames_;
+
+  /**
+   * Frames not holding a page.
+   */
+  std::set<FrameId> free_;
+
+  /**
+   * Resident pages, most recently used first.
+   */
+  std::list<FrameId> t1_;
+  std::list<FrameId> t2_;
+
+  /**
+   * Keys of evicted pages, most recently evicted first.
+   */
+  GhostList b1_;
+  GhostList b2_;
+
+  /**
+   * Key of the page of the last onMiss() and the ghost list it was found in,
+   * or NONE.
+   */
+  std::uint64_t missed_key_;
+  Queue missed_in_;
+};
+
+}
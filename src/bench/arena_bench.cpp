@@ -0,0 +1,92 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares the kinds of memory pages a buffer pool of FRAMES frames can be
+ * mapped with, with and without prefaulting.  For each, the benchmark reports
+ * the kind of pages actually used (huge pages fall back when none are
+ * reserved), the milliseconds to construct the buffer manager, the
+ * milliseconds for the first write to every frame, as the first read of a
+ * page into each frame would do, and million random frame accesses per
+ * second afterwards.
+ */
+
+#include <cstdio>
+#include <iostream>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 1 << 16;
+const std::uint32_t ACCESSES = 1 << 24;
+
+/**
+ * Keeps the accesses from being optimized away.
+ */
+volatile PageId sink;
+
+const char* pagesName(ArenaPages pages) {
+  switch (pages) {
+    case ArenaPages::SMALL:
+      return "small";
+    case ArenaPages::TRANSPARENT_HUGE:
+      return "thp";
+    case ArenaPages::HUGE:
+      return "hugetlb";
+  }
+  return "?";
+}
+
+void run(ArenaPages pages, bool prefault) {
+  Timer constructTimer;
+  BufMgr mgr(FRAMES, 1, PolicyKind::CLOCK, pages, prefault);
+  const double constructSeconds = constructTimer.seconds();
+
+  Timer touchTimer;
+  for (std::uint32_t i = 0; i < FRAMES; ++i) {
+    reinterpret_cast<volatile char*>(&mgr.bufPool[i])[0] = 0;
+  }
+  const double touchSeconds = touchTimer.seconds();
+
+  // Every access reads the header of a random frame, like a lookup of a
+  // random resident page does.  The next frame depends on what was read, so
+  // that accesses do not overlap and their latency shows.
+  Random random(1);
+  PageId sum = 0;
+  Timer accessTimer;
+  for (std::uint32_t i = 0; i < ACCESSES; ++i) {
+    sum += mgr.bufPool[(random.below(FRAMES) + sum) % FRAMES].page_number();
+  }
+  const double accessSeconds = accessTimer.seconds();
+  sink = sum;
+
+  std::printf("%-9s %-8s %-8s %12.1f %14.1f %12.1f\n", pagesName(pages),
+              pagesName(mgr.getPoolPages()), prefault ? "yes" : "no",
+              constructSeconds * 1e3, touchSeconds * 1e3,
+              ACCESSES / accessSeconds / 1e6);
+}
+
+}
+
+int main() {
+  std::printf("%u frames (%u MB), %u accesses\n", FRAMES,
+              static_cast<unsigned>(FRAMES * Page::SIZE >> 20), ACCESSES);
+  std::printf("%-9s %-8s %-8s %12s %14s %12s\n", "requested", "used",
+              "prefault", "construct ms", "first touch ms", "Maccesses/s");
+  const ArenaPages kinds[] = {ArenaPages::SMALL, ArenaPages::TRANSPARENT_HUGE,
+                              ArenaPages::HUGE};
+  for (ArenaPages pages : kinds) {
+    run(pages, false);
+    run(pages, true);
+  }
+  return 0;
+}
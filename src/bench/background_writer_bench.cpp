@@ -0,0 +1,90 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures how much of the write-back of dirty pages the background writer
+ * takes off the threads that read pages.
+ *
+ * Pages are read at random from a file eight times the size of the buffer
+ * pool, and every other page is unpinned dirty.  With and without the
+ * background writer, the benchmark reports thousand page reads per second,
+ * the mean and 99th percentile time of reads that missed, and how many dirty
+ * pages were written by evictions and by the background writer.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 128;
+const std::uint32_t PAGES = FRAMES * 8;
+const std::uint32_t READS = 1 << 17;
+
+void run(File* file, const std::vector<PageId>& pages, const char* name,
+         std::uint32_t cleanFrames) {
+  BufMgr mgr(FRAMES);
+  if (cleanFrames > 0) {
+    mgr.startBackgroundWriter(cleanFrames);
+  }
+  Random random(1);
+  std::vector<double> missMicros;
+  Page* page;
+  Timer timer;
+  for (std::uint32_t i = 0; i < READS; ++i) {
+    const PageId pageNo = pages[random.below(PAGES)];
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    const PageStatus status = mgr.tryReadPage(file, pageNo, page);
+    if (status == PageStatus::MISS) {
+      missMicros.push_back(std::chrono::duration<double, std::micro>(
+          std::chrono::steady_clock::now() - start).count());
+    }
+    mgr.unPinPage(file, pageNo, i % 2 == 0);
+  }
+  const double seconds = timer.seconds();
+  mgr.stopBackgroundWriter();
+
+  double sum = 0;
+  for (std::size_t i = 0; i < missMicros.size(); ++i) {
+    sum += missMicros[i];
+  }
+  std::sort(missMicros.begin(), missMicros.end());
+  const BufStats& stats = mgr.getBufStats();
+  std::printf("%-14s %10.1f %10.2f %10.2f %12d %10d\n", name,
+              READS / seconds / 1e3, sum / missMicros.size(),
+              missMicros[missMicros.size() * 99 / 100],
+              stats.evictwrites.load(), stats.bgwrites.load());
+  mgr.flushFile(file);
+}
+
+}
+
+int main() {
+  ScratchFile scratch("background_writer_bench.db");
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(scratch.get()->allocatePage().page_number());
+  }
+
+  std::printf("%u frames, %u pages, %u reads\n", FRAMES, PAGES, READS);
+  std::printf("%-14s %10s %10s %10s %12s %10s\n", "writer", "Kreads/s",
+              "miss us", "p99 us", "evictwrites", "bgwrites");
+  run(scratch.get(), pages, "off", 0);
+  run(scratch.get(), pages, "clean 16", 16);
+  run(scratch.get(), pages, "clean 64", 64);
+  return 0;
+}
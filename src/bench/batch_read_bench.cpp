@@ -0,0 +1,100 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares BufMgr::readPages() and unPinPages() with a loop of readPage() and
+ * unPinPage() calls over the same batches of pages, in random order:
+ *  - hits: random pages of a file that fits into the buffer pool.
+ *  - misses: pages drawn from a random range of twice the batch size, from a
+ *    file sixteen times the size of the pool, so that most of them miss and
+ *    many are consecutive.
+ * The benchmark reports thousand pages per second for each batch size.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t PAGES = 1024;
+const std::uint32_t PAGES_READ = 1 << 18;
+
+std::vector<PageId> makeBatches(const std::vector<PageId>& pages,
+                                std::uint32_t batch, bool clustered) {
+  Random random(batch);
+  std::vector<PageId> batches;
+  while (batches.size() < PAGES_READ) {
+    const std::uint32_t start = random.below(PAGES - 2 * batch);
+    std::vector<bool> taken(PAGES, false);
+    for (std::uint32_t i = 0; i < batch; ++i) {
+      std::uint32_t p;
+      do {
+        p = clustered ? start + random.below(2 * batch) : random.below(PAGES);
+      } while (taken[p]);
+      taken[p] = true;
+      batches.push_back(pages[p]);
+    }
+  }
+  return batches;
+}
+
+double run(File* file, std::uint32_t frames, const std::vector<PageId>& batches,
+           std::uint32_t batch, bool batched) {
+  BufMgr mgr(frames);
+  std::vector<Page*> out(batch);
+  Page* page;
+  Timer timer;
+  for (std::size_t b = 0; b + batch <= batches.size(); b += batch) {
+    const PageId* pageNos = &batches[b];
+    if (batched) {
+      mgr.readPages(file, pageNos, batch, out.data());
+      mgr.unPinPages(file, pageNos, batch, false);
+    } else {
+      for (std::uint32_t i = 0; i < batch; ++i) {
+        mgr.readPage(file, pageNos[i], page);
+      }
+      for (std::uint32_t i = 0; i < batch; ++i) {
+        mgr.unPinPage(file, pageNos[i], false);
+      }
+    }
+  }
+  return batches.size() / timer.seconds() / 1e3;
+}
+
+}
+
+int main() {
+  ScratchFile scratch("batch_read_bench.db");
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(scratch.get()->allocatePage().page_number());
+  }
+
+  std::printf("%u pages, %u pages read per run, Kpages/s\n", PAGES,
+              PAGES_READ);
+  std::printf("%-7s %6s %12s %12s\n", "reads", "batch", "readPage", "readPages");
+  const std::uint32_t sizes[] = {4, 16, 64};
+  for (int clustered = 0; clustered <= 1; ++clustered) {
+    const std::uint32_t frames = clustered ? PAGES / 16 : PAGES;
+    for (std::uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+      const std::vector<PageId> batches =
+          makeBatches(pages, sizes[s], clustered == 1);
+      const double loop = run(scratch.get(), frames, batches, sizes[s], false);
+      const double batched = run(scratch.get(), frames, batches, sizes[s], true);
+      std::printf("%-7s %6u %12.1f %12.1f\n", clustered ? "misses" : "hits",
+                  sizes[s], loop, batched);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+namespace bench {
+
+/**
+ * @brief Measures wall clock time from its construction.
+ */
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * Returns the seconds elapsed since the timer was constructed.
+   */
+  double seconds() const {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_).count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Database file which is created for a benchmark and removed again
+ *        afterwards.
+ */
+class ScratchFile {
+ public:
+  explicit ScratchFile(const std::string& name)
+      : name_(name),
+        file_(create(name)) {
+  }
+
+  ~ScratchFile() {
+    file_.reset();
+    File::remove(name_);
+  }
+
+  File* get() { return file_.get(); }
+
+ private:
+  static File* create(const std::string& name) {
+    try {
+      File::remove(name);
+    } catch (FileNotFoundException&) {
+    }
+    return new File(File::create(name));
+  }
+
+  std::string name_;
+  std::unique_ptr<File> file_;
+};
+
+/**
+ * @brief Small, fast pseudo random number generator (xorshift64*), so that
+ *        benchmark threads do not share generator state.
+ */
+class Random {
+ public:
+  explicit Random(std::uint64_t seed) : state_(seed * 2685821657736338717ULL + 1) {}
+
+  std::uint64_t next() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 2685821657736338717ULL;
+  }
+
+  /**
+   * Returns a number in [0, bound).
+   */
+  std::uint32_t below(std::uint32_t bound) {
+    return static_cast<std::uint32_t>((next() >> 32) % bound);
+  }
+
+ private:
+  std::uint64_t state_;
+};
+
+/**
+ * Returns the thread counts to run scaling benchmarks with: powers of two up
+ * to the number of hardware threads, plus the number of hardware threads.
+ */
+inline std::vector<unsigned> threadCounts() {
+  unsigned max_threads = std::thread::hardware_concurrency();
+  if (max_threads == 0) {
+    max_threads = 1;
+  }
+  std::vector<unsigned> counts;
+  for (unsigned n = 1; n < max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+/**
+ * Runs body(thread_index) on the given number of threads and returns the
+ * seconds until all of them are done.
+ */
+template <typename Body>
+double runThreads(unsigned num_threads, Body body) {
+  std::vector<std::thread> threads;
+  Timer timer;
+  for (unsigned t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread(body, t));
+  }
+  for (unsigned t = 0; t < num_threads; ++t) {
+    threads[t].join();
+  }
+  return timer.seconds();
+}
+
+/**
+ * Writes a file of num_pages pages, header included, the way File laid files
+ * out before its header carried a format version: a 16-byte header, then page
+ * n at offset 16 + (n - 1) * Page::SIZE.  Every used_every-th page from page
+ * 1 on is used, and the used pages are linked in order; all others are free.
+ * The used pages hold fill after their headers unless fill is 0, in which
+ * case only their headers are written and the file is sparse.  File::open()
+ * migrates the file.
+ */
+inline void writeOriginalLayout(const std::string& name,
+                                const std::uint32_t num_pages,
+                                const std::uint32_t used_every,
+                                const char fill) {
+  const int fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+  const PageId header[4] = {num_pages, 1 /* first_used_page */,
+                            0 /* num_free_pages */, 0 /* first_free_page */};
+  if (::pwrite(fd, header, sizeof(header), 0) != sizeof(header)) {
+    std::perror(name.c_str());
+  }
+  std::vector<char> page(fill != 0 ? Page::SIZE : sizeof(PageHeader), fill);
+  for (PageId p = 1; p < num_pages; p += used_every) {
+    PageHeader page_header;
+    page_header.free_space_lower_bound = 0;
+    page_header.free_space_upper_bound = Page::DATA_SIZE;
+    page_header.num_slots = 0;
+    page_header.num_free_slots = 0;
+    page_header.current_page_number = p;
+    page_header.next_page_number =
+        p + used_every < num_pages ? p + used_every : Page::INVALID_NUMBER;
+    std::memcpy(page.data(), &page_header, sizeof(page_header));
+    const off_t position =
+        sizeof(header) + static_cast<off_t>(p - 1) * Page::SIZE;
+    if (::pwrite(fd, page.data(), page.size(), position) !=
+        static_cast<ssize_t>(page.size())) {
+      std::perror(name.c_str());
+    }
+  }
+  // Extend the file to its last page.
+  if (::ftruncate(fd, sizeof(header) +
+                  static_cast<off_t>(num_pages - 1) * Page::SIZE) != 0) {
+    std::perror(name.c_str());
+  }
+  ::close(fd);
+}
+
+}
+}
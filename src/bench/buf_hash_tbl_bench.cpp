@@ -0,0 +1,228 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares the single-threaded throughput of BufHashTbl with the chained hash
+ * table it replaced, which is reproduced here as ChainedHashTbl.
+ *
+ * Each table is filled the way a buffer pool of the given number of frames
+ * fills it: with consecutive pages of a few files.  Like the File objects in
+ * main.cpp, the files are adjacent in memory.  The benchmark reports million
+ * operations per second for lookups of resident pages, lookups of pages that
+ * are not cached (what every buffer miss does first), and evictions, where an
+ * eviction removes a random resident page and inserts a page that has not been
+ * cached yet.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "bufHashTbl.h"
+#include "exceptions/hash_already_present_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t NUM_FILES = 8;
+const std::uint32_t OPS = 1 << 23;
+
+/**
+ * The chained hash table BufHashTbl used to be: an array of bucket lists
+ * indexed by (file pointer + page number) modulo the table size, with one
+ * allocation per insert.
+ */
+class ChainedHashTbl {
+ public:
+  explicit ChainedHashTbl(std::uint32_t frames)
+      : size_(((((int) (frames * 1.2))*2)/2)+1),
+        ht_(new Bucket*[size_]) {
+    for (int i = 0; i < size_; ++i) {
+      ht_[i] = NULL;
+    }
+  }
+
+  ~ChainedHashTbl() {
+    for (int i = 0; i < size_; ++i) {
+      while (ht_[i]) {
+        Bucket* next = ht_[i]->next;
+        delete ht_[i];
+        ht_[i] = next;
+      }
+    }
+    delete[] ht_;
+  }
+
+  void insert(const File* file, PageId pageNo, FrameId frameNo) {
+    const int index = hash(file, pageNo);
+    for (Bucket* b = ht_[index]; b; b = b->next) {
+      if (b->file == file && b->pageNo == pageNo) {
+        throw HashAlreadyPresentException(file->filename(), pageNo, b->frameNo);
+      }
+    }
+    Bucket* b = new Bucket;
+    b->file = file;
+    b->pageNo = pageNo;
+    b->frameNo = frameNo;
+    b->next = ht_[index];
+    ht_[index] = b;
+  }
+
+  void lookup(const File* file, PageId pageNo, FrameId& frameNo) {
+    for (Bucket* b = ht_[hash(file, pageNo)]; b; b = b->next) {
+      if (b->file == file && b->pageNo == pageNo) {
+        frameNo = b->frameNo;
+        return;
+      }
+    }
+    throw HashNotFoundException(file->filename(), pageNo);
+  }
+
+  // Misses were detected by catching the exception of lookup().
+  bool tryLookup(const File* file, PageId pageNo, FrameId& frameNo) {
+    try {
+      lookup(file, pageNo, frameNo);
+      return true;
+    } catch (HashNotFoundException&) {
+      return false;
+    }
+  }
+
+  void remove(const File* file, PageId pageNo) {
+    const int index = hash(file, pageNo);
+    Bucket* prev = NULL;
+    for (Bucket* b = ht_[index]; b; prev = b, b = b->next) {
+      if (b->file == file && b->pageNo == pageNo) {
+        if (prev) {
+          prev->next = b->next;
+        } else {
+          ht_[index] = b->next;
+        }
+        delete b;
+        return;
+      }
+    }
+    throw HashNotFoundException(file->filename(), pageNo);
+  }
+
+ private:
+  struct Bucket {
+    const File* file;
+    PageId pageNo;
+    FrameId frameNo;
+    Bucket* next;
+  };
+
+  int hash(const File* file, PageId pageNo) const {
+    int tmp = (long) file;
+    return (tmp + pageNo) % size_;
+  }
+
+  int size_;
+  Bucket** ht_;
+};
+
+/**
+ * Page cached in a frame.
+ */
+struct Resident {
+  File* file;
+  PageId pageNo;
+};
+
+template <typename Table>
+void run(const char* name, std::uint32_t frames, std::vector<File>& files) {
+  Table table(frames);
+  std::vector<Resident> residents(frames);
+  std::vector<PageId> nextPage(NUM_FILES, 1);
+  for (FrameId f = 0; f < frames; ++f) {
+    File* file = &files[f % NUM_FILES];
+    residents[f].file = file;
+    residents[f].pageNo = nextPage[f % NUM_FILES]++;
+    table.insert(file, residents[f].pageNo, f);
+  }
+
+  Random random(1);
+  std::vector<FrameId> order(OPS);
+  for (std::uint32_t i = 0; i < OPS; ++i) {
+    order[i] = random.below(frames);
+  }
+
+  FrameId checksum = 0;
+  Timer lookupTimer;
+  for (std::uint32_t i = 0; i < OPS; ++i) {
+    const Resident& r = residents[order[i]];
+    FrameId frameNo;
+    table.lookup(r.file, r.pageNo, frameNo);
+    checksum += frameNo;
+  }
+  const double lookupSeconds = lookupTimer.seconds();
+
+  std::uint32_t misses = 0;
+  Timer missTimer;
+  for (std::uint32_t i = 0; i < OPS; ++i) {
+    const Resident& r = residents[order[i]];
+    FrameId frameNo;
+    if (!table.tryLookup(r.file, r.pageNo + frames, frameNo)) {
+      ++misses;
+    }
+  }
+  const double missSeconds = missTimer.seconds();
+
+  Timer evictTimer;
+  for (std::uint32_t i = 0; i < OPS; ++i) {
+    const FrameId f = order[i];
+    Resident& r = residents[f];
+    table.remove(r.file, r.pageNo);
+    const std::uint32_t fileIndex = i % NUM_FILES;
+    r.file = &files[fileIndex];
+    r.pageNo = nextPage[fileIndex]++;
+    table.insert(r.file, r.pageNo, f);
+  }
+  const double evictSeconds = evictTimer.seconds();
+
+  std::printf("%-16s %8u frames  hit %7.1f  miss %7.1f  evict %7.1f"
+              " Mops/s  (%u, %u)\n",
+              name, frames, OPS / lookupSeconds / 1e6, OPS / missSeconds / 1e6,
+              OPS / evictSeconds / 1e6, checksum, misses);
+}
+
+}
+
+int main() {
+  std::vector<std::string> names;
+  for (std::uint32_t i = 0; i < NUM_FILES; ++i) {
+    names.push_back("bench_hash." + std::to_string(i));
+    try {
+      File::remove(names[i]);
+    } catch (FileNotFoundException&) {
+    }
+  }
+
+  {
+    std::vector<File> files;
+    files.reserve(NUM_FILES);
+    for (std::uint32_t i = 0; i < NUM_FILES; ++i) {
+      files.push_back(File::create(names[i]));
+    }
+
+    const std::uint32_t sizes[] = {1 << 10, 1 << 16, 1 << 20};
+    for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+      run<ChainedHashTbl>("ChainedHashTbl", sizes[s], files);
+      run<BufHashTbl>("BufHashTbl", sizes[s], files);
+    }
+  }
+
+  for (std::uint32_t i = 0; i < NUM_FILES; ++i) {
+    File::remove(names[i]);
+  }
+  return 0;
+}
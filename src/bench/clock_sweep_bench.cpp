@@ -0,0 +1,159 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures how long ClockPolicy takes to pick a victim in a pool of FRAMES
+ * frames, compared with a clock that tests one reference bit at a time (the
+ * sweep ClockPolicy used before it looked at many frames at once).
+ *
+ * Every frame starts out referenced, as after loading a full pool.  Each pick
+ * loads a page into the victim, which references it, and hits a few random
+ * pages of a hot set covering the given share of the pool.  One frame in
+ * every PIN_EVERY is pinned and cannot be taken.  The scalar clock and "simd"
+ * find pinned frames by trying to take them, reading the pin count from a
+ * descriptor of its own per frame, as frame descriptors held it before.
+ * "simd-soa" passes ClockPolicy the pin counts in one dense array, as BufMgr
+ * does, so the sweep skips pinned frames without trying them.  The benchmark
+ * reports the time of the first pick, which sweeps the whole pool, and the
+ * mean nanoseconds per pick.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "clock_policy.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 1 << 20;
+const std::uint32_t PICKS = 1 << 21;
+const std::uint32_t HITS_PER_PICK = 4;
+const std::uint32_t PIN_EVERY = 64;
+
+/**
+ * Frame descriptor holding the pin count next to the other fields of a frame.
+ */
+struct Descriptor {
+  std::atomic<int> pin_count;
+  char other_fields[60];
+};
+
+/**
+ * Clock testing one reference bit at a time.
+ */
+class ScalarClock {
+ public:
+  ScalarClock(FrameId firstFrame, std::uint32_t numFrames,
+              const std::atomic<int>* = NULL)
+      : first_frame_(firstFrame),
+        num_frames_(numFrames),
+        hand_(firstFrame + numFrames - 1),
+        ref_bits_(numFrames) {
+  }
+
+  void onHit(FrameId frame) { ref_bits_[frame - first_frame_] = true; }
+
+  void onLoad(FrameId frame, const File*, PageId) {
+    ref_bits_[frame - first_frame_] = true;
+  }
+
+  bool pickVictim(const ReplacementPolicy::TakeFrame& take, FrameId& frame) {
+    std::uint32_t pinned = 0;
+    while (pinned < num_frames_) {
+      hand_ = hand_ < first_frame_ + num_frames_ - 1 ? hand_ + 1 : first_frame_;
+      if (ref_bits_[hand_ - first_frame_]) {
+        ref_bits_[hand_ - first_frame_] = false;
+        continue;
+      }
+      if (!take(hand_)) {
+        ++pinned;
+        continue;
+      }
+      frame = hand_;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  FrameId first_frame_;
+  std::uint32_t num_frames_;
+  FrameId hand_;
+  std::vector<bool> ref_bits_;
+};
+
+template <typename Clock>
+void run(const char* name, double hotShare, bool densePins) {
+  std::unique_ptr<std::atomic<int>[]> pins(new std::atomic<int>[FRAMES]);
+  std::unique_ptr<Descriptor[]> descriptors(new Descriptor[FRAMES]);
+  for (FrameId f = 0; f < FRAMES; ++f) {
+    pins[f] = f % PIN_EVERY == 0 ? 1 : 0;
+    descriptors[f].pin_count = pins[f].load();
+  }
+  Clock clock(0, FRAMES, densePins ? pins.get() : NULL);
+  for (FrameId f = 0; f < FRAMES; ++f) {
+    clock.onLoad(f, NULL, f + 1);
+  }
+  std::atomic<int>* pinCounts = pins.get();
+  Descriptor* descs = descriptors.get();
+  const ReplacementPolicy::TakeFrame take = densePins
+      ? ReplacementPolicy::TakeFrame([pinCounts](FrameId f) {
+          return pinCounts[f].load(std::memory_order_relaxed) == 0;
+        })
+      : ReplacementPolicy::TakeFrame([descs](FrameId f) {
+          return descs[f].pin_count.load(std::memory_order_relaxed) == 0;
+        });
+  const std::uint32_t hotFrames =
+      std::max<std::uint32_t>(1, static_cast<std::uint32_t>(FRAMES * hotShare));
+
+  Random random(1);
+  double first = 0;
+  double total = 0;
+  for (std::uint32_t i = 0; i < PICKS; ++i) {
+    for (std::uint32_t h = 0; h < HITS_PER_PICK; ++h) {
+      clock.onHit(random.below(hotFrames));
+    }
+    FrameId frame;
+    Timer timer;
+    if (!clock.pickVictim(take, frame)) {
+      std::fprintf(stderr, "no victim found\n");
+      return;
+    }
+    const double seconds = timer.seconds();
+    if (i == 0) {
+      first = seconds;
+    } else {
+      total += seconds;
+    }
+    clock.onLoad(frame, NULL, frame + 1);
+  }
+  std::printf("%-8s %8.0f%% %14.1f %12.1f\n", name, hotShare * 100,
+              first * 1e6, total / (PICKS - 1) * 1e9);
+}
+
+}
+
+int main() {
+  std::printf("%u frames, %u picks, %u hits per pick\n", FRAMES, PICKS,
+              HITS_PER_PICK);
+  std::printf("%-8s %9s %14s %12s\n", "sweep", "hot set", "first pick us",
+              "mean ns");
+  const double hotShares[] = {0.01, 0.5, 0.9};
+  for (double hotShare : hotShares) {
+    run<ScalarClock>("scalar", hotShare, false);
+    run<ClockPolicy>("simd", hotShare, false);
+    run<ClockPolicy>("simd-soa", hotShare, true);
+  }
+  return 0;
+}
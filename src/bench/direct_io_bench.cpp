@@ -0,0 +1,123 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures the memory holding a file's pages and the latency of buffer pool
+ * misses, with the file opened FileMode::BUFFERED and FileMode::DIRECT.
+ *
+ * For each mode the file is first dropped from the page cache.  Then random
+ * pages are read through a buffer pool much smaller than the file, twice, each
+ * time with a new pool: the first pass reads from disk, and in buffered mode
+ * the second one finds the pages in the page cache.  After each pass the
+ * benchmark reports the average time of a miss and how much of the file the
+ * page cache holds, counted with mincore(), next to the size of the pool.
+ * Direct I/O keeps the page cache empty, at the price of going to the disk for
+ * every miss.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 32768;
+const std::uint32_t POOL_FRAMES = 4096;
+const std::uint32_t READS = 20000;
+const char* const FILE_NAME = "direct_io_bench.db";
+
+/**
+ * Writes a file of used pages numbered 1 to FILE_PAGES and migrates it.  The
+ * pages are filled, so that the file takes room in the page cache.
+ */
+void layOut() {
+  writeOriginalLayout(FILE_NAME, FILE_PAGES + 1, 1 /* used_every */,
+                      1 /* fill */);
+  File migrated = File::open(FILE_NAME);
+}
+
+/**
+ * Writes the file back and drops it from the page cache.
+ */
+void dropCache() {
+  const int fd = ::open(FILE_NAME, O_RDONLY);
+  ::fdatasync(fd);
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+/**
+ * Returns the megabytes of the file held by the page cache.
+ */
+double cachedMegabytes() {
+  const int fd = ::open(FILE_NAME, O_RDONLY);
+  struct stat status;
+  ::fstat(fd, &status);
+  const std::size_t block = ::sysconf(_SC_PAGESIZE);
+  const std::size_t blocks = (status.st_size + block - 1) / block;
+  void* mapping = ::mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  std::vector<unsigned char> resident(blocks);
+  ::mincore(mapping, status.st_size, resident.data());
+  std::size_t cached = 0;
+  for (std::size_t i = 0; i < blocks; ++i) {
+    cached += resident[i] & 1;
+  }
+  ::munmap(mapping, status.st_size);
+  ::close(fd);
+  return cached * block / 1048576.0;
+}
+
+void pass(File& file, const char* name, const char* cache) {
+  BufMgr mgr(POOL_FRAMES);
+  Random random(1);
+  Timer timer;
+  for (std::uint32_t i = 0; i < READS; ++i) {
+    const PageId page_number = random.below(FILE_PAGES) + 1;
+    Page* page;
+    mgr.readPage(&file, page_number, page);
+    mgr.unPinPage(&file, page_number, false);
+  }
+  const double seconds = timer.seconds();
+  const std::uint32_t misses = mgr.getBufStats().diskreads;
+  std::printf("%-8s %-5s misses=%-6u miss=%8.1f us  page cache=%7.1f MB  pool=%5.1f MB\n",
+              name, cache, misses, seconds / misses * 1e6, cachedMegabytes(),
+              POOL_FRAMES * Page::SIZE / 1048576.0);
+}
+
+void run(const FileMode mode) {
+  dropCache();
+  File file = File::open(FILE_NAME, mode);
+  const char* name = file.direct() ? "direct" : "buffered";
+  if (mode == FileMode::DIRECT && !file.direct()) {
+    name = "fallback";
+  }
+  pass(file, name, "cold");
+  pass(file, name, "warm");
+}
+
+}
+
+int main() {
+  layOut();
+  std::printf("file=%.1f MB reads=%u\n", FILE_PAGES * Page::SIZE / 1048576.0,
+              READS);
+  run(FileMode::BUFFERED);
+  run(FileMode::DIRECT);
+  File::remove(FILE_NAME);
+  return 0;
+}
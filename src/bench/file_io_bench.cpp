@@ -0,0 +1,128 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures random 8 KB page reads and writes through File, which uses pread()
+ * and pwrite() at the offset of the page, against the same accesses through
+ * one std::fstream shared by all threads, as File did before: a seek and a
+ * buffered read or write (and flush) per access, serialized by a mutex since
+ * the stream has a single position.
+ *
+ * Reads check the file header and then read the page, like
+ * File::tryReadPage(); writes read the header of the page on disk and then
+ * write it, like File::writePage().  Every write follows a read of the page it
+ * writes.  For each number of threads the benchmark reports thousand reads and
+ * thousand read-and-writes per second.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 512;
+const std::uint32_t OPS_PER_THREAD = 1 << 14;
+
+std::streampos position(const PageId page_number) {
+  return static_cast<std::streamoff>(page_number) * Page::SIZE;
+}
+
+/**
+ * Page accesses through a shared stream, the way File used to do them.
+ */
+class StreamFile {
+ public:
+  explicit StreamFile(const std::string& name)
+      : stream_(name, std::fstream::in | std::fstream::out | std::fstream::binary) {
+  }
+
+  bool read(const PageId page_number, Page& page) {
+    std::lock_guard<std::mutex> guard(lock_);
+    FileHeader header;
+    stream_.seekg(0, std::ios::beg);
+    stream_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (page_number >= header.num_pages) {
+      return false;
+    }
+    stream_.seekg(position(page_number), std::ios::beg);
+    stream_.read(reinterpret_cast<char*>(&page), Page::SIZE);
+    return page.page_number() != Page::INVALID_NUMBER;
+  }
+
+  void write(const Page& page) {
+    std::lock_guard<std::mutex> guard(lock_);
+    PageHeader header;
+    stream_.seekg(position(page.page_number()), std::ios::beg);
+    stream_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    stream_.seekp(position(page.page_number()), std::ios::beg);
+    stream_.write(reinterpret_cast<const char*>(&page), Page::SIZE);
+    stream_.flush();
+  }
+
+ private:
+  std::fstream stream_;
+  std::mutex lock_;
+};
+
+template <typename Read, typename Write>
+void run(const char* name, const PageId* pages, Read read, Write write) {
+  const std::vector<unsigned> counts = threadCounts();
+  for (std::size_t c = 0; c < counts.size(); ++c) {
+    const unsigned threads = counts[c];
+    const double read_seconds = runThreads(threads, [&](unsigned t) {
+      Random random(t + 1);
+      Page page;
+      for (std::uint32_t i = 0; i < OPS_PER_THREAD; ++i) {
+        read(pages[random.below(FILE_PAGES)], page);
+      }
+    });
+    const double write_seconds = runThreads(threads, [&](unsigned t) {
+      Random random(t + 1);
+      Page page;
+      for (std::uint32_t i = 0; i < OPS_PER_THREAD; ++i) {
+        // Every thread writes its own pages, so that no page is written by two
+        // threads at once.
+        const std::uint32_t slot = random.below(FILE_PAGES / threads) * threads + t;
+        read(pages[slot], page);
+        write(page);
+      }
+    });
+    std::printf("%-8s threads=%-3u reads=%9.1f K/s  writes=%9.1f K/s\n", name,
+                threads, threads * OPS_PER_THREAD / read_seconds / 1e3,
+                threads * OPS_PER_THREAD / write_seconds / 1e3);
+  }
+}
+
+}
+
+int main() {
+  ScratchFile scratch("file_io_bench.db");
+  File* file = scratch.get();
+  PageId pages[FILE_PAGES];
+  for (std::uint32_t i = 0; i < FILE_PAGES; ++i) {
+    pages[i] = file->allocatePage().page_number();
+  }
+
+  StreamFile stream("file_io_bench.db");
+  run("fstream", pages,
+      [&](PageId page_number, Page& page) { stream.read(page_number, page); },
+      [&](const Page& page) { stream.write(page); });
+  run("pread", pages,
+      [&](PageId page_number, Page& page) { file->tryReadPage(page_number, page); },
+      [&](const Page& page) { file->writePage(page); });
+  return 0;
+}
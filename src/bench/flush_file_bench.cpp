@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures BufMgr::flushFile() on many small files, like closing the files of
+ * a database with hundreds of tables, for buffer pools of growing size.  Each
+ * file has a few pages read into the pool, one of them dirty, and is then
+ * flushed.
+ *
+ * Since flushFile() only looks at the frames holding pages of the file, the
+ * time per flush should not grow with the size of the pool.  The benchmark
+ * reports the average time of a flush for every pool size.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILES = 256;
+const std::uint32_t PAGES_PER_FILE = 4;
+const std::uint32_t ROUNDS = 8;
+const std::uint32_t POOL_SIZES[] = {1024, 8192, 65536};
+
+void run(const std::vector<File*>& files, const std::uint32_t frames) {
+  BufMgr mgr(frames);
+  double seconds = 0;
+  for (std::uint32_t round = 0; round < ROUNDS; ++round) {
+    for (std::size_t f = 0; f < files.size(); ++f) {
+      for (PageId p = 1; p <= PAGES_PER_FILE; ++p) {
+        Page* page;
+        mgr.readPage(files[f], p, page);
+        mgr.unPinPage(files[f], p, p == 1);
+      }
+    }
+    Timer timer;
+    for (std::size_t f = 0; f < files.size(); ++f) {
+      mgr.flushFile(files[f]);
+    }
+    seconds += timer.seconds();
+  }
+  std::printf("frames=%-7u files=%-4u flushFile=%8.2f us\n", frames, FILES,
+              seconds / (ROUNDS * FILES) * 1e6);
+}
+
+}
+
+int main() {
+  std::vector<std::unique_ptr<ScratchFile> > scratch;
+  std::vector<File*> files;
+  for (std::uint32_t f = 0; f < FILES; ++f) {
+    scratch.push_back(std::unique_ptr<ScratchFile>(
+        new ScratchFile("flush_file_bench." + std::to_string(f) + ".db")));
+    files.push_back(scratch.back()->get());
+    for (std::uint32_t p = 0; p < PAGES_PER_FILE; ++p) {
+      files.back()->allocatePage();
+    }
+  }
+  for (std::size_t i = 0; i < sizeof(POOL_SIZES) / sizeof(POOL_SIZES[0]); ++i) {
+    run(files, POOL_SIZES[i]);
+  }
+  return 0;
+}
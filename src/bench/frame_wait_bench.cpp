@@ -0,0 +1,84 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures operations which pin several pages at once on a buffer pool too
+ * small for all threads to hold their pins together, so that requests often
+ * find every frame pinned.  Without frame waiting, an operation that gets
+ * BufferExceededException releases its pins and starts over; with it, the
+ * request waits for another thread to unpin a frame (BufMgr::setFrameWait()).
+ * The pool is large enough for every thread to hold all but one of its pins,
+ * so waiting threads cannot block each other for good.
+ *
+ * The benchmark reports operations per second, operations aborted, and the
+ * waits, average wait and timeouts counted in BufStats.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+#include "exceptions/buffer_exceeded_exception.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 256;
+const std::uint32_t FRAMES = 28;
+const unsigned THREADS = 8;
+const std::uint32_t PINS_PER_OP = 4;
+const std::uint32_t OPS_PER_THREAD = 1 << 13;
+
+void run(const char* name, File* file, const PageId* pages, const std::chrono::microseconds timeout) {
+  BufMgr mgr(FRAMES);
+  mgr.setFrameWait(timeout);
+  std::atomic<std::uint64_t> aborts(0);
+  const double seconds = runThreads(THREADS, [&](unsigned t) {
+    Random random(t + 1);
+    std::uint64_t aborted = 0;
+    for (std::uint32_t op = 0; op < OPS_PER_THREAD; ++op) {
+      for (;;) {
+        try {
+          PageHandle held[PINS_PER_OP];
+          for (std::uint32_t p = 0; p < PINS_PER_OP; ++p) {
+            held[p] = mgr.readPage(file, pages[random.below(FILE_PAGES)]);
+          }
+          break;
+        } catch (BufferExceededException&) {
+          ++aborted;
+          std::this_thread::yield();
+        }
+      }
+    }
+    aborts += aborted;
+  });
+
+  BufStats& stats = mgr.getBufStats();
+  std::printf("%-10s ops=%8.0f/s  aborts=%-8llu waits=%-8d avg wait=%8.1f us  timeouts=%d\n",
+              name, THREADS * OPS_PER_THREAD / seconds,
+              static_cast<unsigned long long>(aborts.load()), stats.framewaits.load(),
+              stats.framewaits ? static_cast<double>(stats.framewaitus) / stats.framewaits : 0.0,
+              stats.frametimeouts.load());
+  mgr.flushFile(file);
+}
+
+}
+
+int main() {
+  ScratchFile scratch("frame_wait_bench.db");
+  PageId pages[FILE_PAGES];
+  for (std::uint32_t i = 0; i < FILE_PAGES; ++i) {
+    pages[i] = scratch.get()->allocatePage().page_number();
+  }
+  run("fail-fast", scratch.get(), pages, std::chrono::microseconds(0));
+  run("wait", scratch.get(), pages, std::chrono::milliseconds(100));
+  return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures the system calls and time of random File::readPage() calls with the
+ * file header kept in memory, against reading the header from disk before
+ * every page, as File did before.  System calls are counted with the syscr and
+ * syscw fields of /proc/self/io.
+ *
+ * The benchmark also reports the writes of File::allocatePage(), which no
+ * longer writes the file header each time.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "bench/bench_util.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 1024;
+const std::uint32_t READS = 1 << 18;
+const std::uint32_t ALLOCATIONS = 256;
+
+/**
+ * System calls made by the process so far.
+ */
+struct SystemCalls {
+  SystemCalls() : reads(0), writes(0) {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    unsigned long long value;
+    while (io >> key >> value) {
+      if (key == "syscr:") {
+        reads = value;
+      } else if (key == "syscw:") {
+        writes = value;
+      }
+    }
+  }
+
+  unsigned long long reads;
+  unsigned long long writes;
+};
+
+template <typename Read>
+void run(const char* name, Read read) {
+  Random random(1);
+  Page page;
+  const SystemCalls before;
+  Timer timer;
+  for (std::uint32_t i = 0; i < READS; ++i) {
+    read(random.below(FILE_PAGES) + 1, page);
+  }
+  const double seconds = timer.seconds();
+  const SystemCalls after;
+  std::printf("%-13s reads/readPage=%5.2f  readPage=%7.0f ns\n", name,
+              static_cast<double>(after.reads - before.reads) / READS,
+              seconds / READS * 1e9);
+}
+
+}
+
+int main() {
+  ScratchFile scratch("header_cache_bench.db");
+  File* file = scratch.get();
+  for (std::uint32_t i = 0; i < FILE_PAGES; ++i) {
+    file->allocatePage();
+  }
+  const int fd = ::open("header_cache_bench.db", O_RDONLY);
+
+  run("header-read", [&](PageId page_number, Page& page) {
+    FileHeader header;
+    if (::pread(fd, &header, sizeof(header), 0) == sizeof(header)) {
+      file->tryReadPage(page_number, page);
+    }
+  });
+  run("header-cached", [&](PageId page_number, Page& page) {
+    file->tryReadPage(page_number, page);
+  });
+
+  const SystemCalls before;
+  for (std::uint32_t i = 0; i < ALLOCATIONS; ++i) {
+    file->allocatePage();
+  }
+  const SystemCalls after;
+  std::printf("allocatePage  writes/allocatePage=%5.2f\n",
+              static_cast<double>(after.writes - before.writes) / ALLOCATIONS);
+  ::close(fd);
+  return 0;
+}
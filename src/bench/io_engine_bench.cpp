@@ -0,0 +1,109 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures random 8 KB reads of a file through IoEngine batches at growing
+ * queue depths, against a loop of blocking pread() calls, one read in flight
+ * at a time, as File does for single pages.
+ *
+ * Every batch holds as many reads as the depth of the engine.  Both the
+ * io_uring engine and the thread pool engine are measured; where the kernel
+ * does not provide io_uring the first falls back to the second, which the
+ * output tells.  Reads mostly hit the page cache unless the file is made
+ * larger than memory, so the gains on a fast device are larger than shown.
+ * The benchmark reports thousand reads per second.
+ */
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "io_engine.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::size_t BLOCK = 8192;
+const std::uint32_t FILE_BLOCKS = 16384;
+const std::uint32_t READS = 1 << 16;
+const unsigned DEPTHS[] = {1, 4, 16, 64, 128};
+const char* const FILE_NAME = "io_engine_bench.db";
+
+void report(const char* name, const unsigned depth, const double seconds) {
+  std::printf("%-12s depth=%-4u reads=%9.1f K/s\n", name, depth,
+              READS / seconds / 1e3);
+}
+
+void runPread(const int fd) {
+  std::vector<char> buffer(BLOCK);
+  Random random(1);
+  Timer timer;
+  for (std::uint32_t i = 0; i < READS; ++i) {
+    const off_t offset = static_cast<off_t>(random.below(FILE_BLOCKS) * BLOCK);
+    if (::pread(fd, buffer.data(), BLOCK, offset) != static_cast<ssize_t>(BLOCK)) {
+      std::perror("pread");
+    }
+  }
+  report("pread", 1, timer.seconds());
+}
+
+void runEngine(const int fd, const IoEngineKind kind, const unsigned depth) {
+  std::unique_ptr<IoEngine> engine(IoEngine::create(kind, depth));
+  std::vector<char> buffers(depth * BLOCK);
+  std::vector<struct iovec> iov(depth);
+  std::vector<IoRequest> requests(depth);
+  Random random(1);
+  Timer timer;
+  for (std::uint32_t done = 0; done < READS; done += depth) {
+    for (unsigned i = 0; i < depth; ++i) {
+      iov[i].iov_base = &buffers[i * BLOCK];
+      iov[i].iov_len = BLOCK;
+      const IoRequest request = {
+          false, fd, &iov[i], 1,
+          static_cast<off_t>(random.below(FILE_BLOCKS) * BLOCK), 0};
+      requests[i] = request;
+    }
+    engine->run(requests.data(), depth);
+  }
+  report(engine->kind() == IoEngineKind::URING ? "io_uring" : "thread-pool",
+         depth, timer.seconds());
+}
+
+}
+
+int main() {
+  const int fd = ::open(FILE_NAME, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    std::perror(FILE_NAME);
+    return 1;
+  }
+  std::vector<char> block(BLOCK, 'x');
+  for (std::uint32_t b = 0; b < FILE_BLOCKS; ++b) {
+    if (::write(fd, block.data(), BLOCK) != static_cast<ssize_t>(BLOCK)) {
+      std::perror(FILE_NAME);
+      return 1;
+    }
+  }
+
+  runPread(fd);
+  for (std::size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); ++d) {
+    runEngine(fd, IoEngineKind::URING, DEPTHS[d]);
+  }
+  for (std::size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); ++d) {
+    runEngine(fd, IoEngineKind::THREAD_POOL, DEPTHS[d]);
+  }
+  ::close(fd);
+  ::unlink(FILE_NAME);
+  return 0;
+}
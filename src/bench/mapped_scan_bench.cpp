@@ -0,0 +1,107 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures full scans of a file with FileIterator, summing every byte of every
+ * page, in GB/s.  The file is scanned opened FileMode::BUFFERED, reading every
+ * page with a system call, and opened FileMode::MAPPED, both copying each page
+ * out of the mapping and viewing it in place.  The file is written in the
+ * original layout and migrated by opening it once before the scans, since a
+ * mapped file cannot be migrated.
+ *
+ * Every scan is run twice: first with the file dropped from the page cache,
+ * then with the file cached.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+
+#include "bench/bench_util.h"
+#include "file_iterator.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 32768;
+const char* const FILE_NAME = "mapped_scan_bench.db";
+
+/**
+ * Writes a file of used pages numbered 1 to FILE_PAGES and migrates it.
+ */
+void layOut() {
+  writeOriginalLayout(FILE_NAME, FILE_PAGES + 1, 1 /* used_every */,
+                      1 /* fill */);
+  File migrated = File::open(FILE_NAME);
+}
+
+/**
+ * Writes the file back and drops it from the page cache.
+ */
+void dropCache() {
+  const int fd = ::open(FILE_NAME, O_RDONLY);
+  ::fdatasync(fd);
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+std::uint64_t sum(const Page& page) {
+  const std::uint64_t* words = reinterpret_cast<const std::uint64_t*>(&page);
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < Page::SIZE / sizeof(std::uint64_t); ++i) {
+    total += words[i];
+  }
+  return total;
+}
+
+template <typename Scan>
+void run(const char* name, const FileMode mode, Scan scan) {
+  dropCache();
+  for (int pass = 0; pass < 2; ++pass) {
+    File file = File::open(FILE_NAME, mode);
+    Timer timer;
+    const std::uint64_t total = scan(file);
+    const double seconds = timer.seconds();
+    std::printf("%-12s %-6s %7.2f GB/s  (sum %llx)\n", name,
+                pass == 0 ? "cold" : "cached",
+                FILE_PAGES * Page::SIZE / seconds / 1e9,
+                static_cast<unsigned long long>(total));
+  }
+}
+
+}
+
+int main() {
+  layOut();
+  run("stream", FileMode::BUFFERED, [](File& file) {
+    std::uint64_t total = 0;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      total += sum(*iter);
+    }
+    return total;
+  });
+  run("mapped-copy", FileMode::MAPPED, [](File& file) {
+    std::uint64_t total = 0;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      total += sum(*iter);
+    }
+    return total;
+  });
+  run("mapped-view", FileMode::MAPPED, [](File& file) {
+    std::uint64_t total = 0;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      total += sum(iter.view());
+    }
+    return total;
+  });
+  File::remove(FILE_NAME);
+  return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures File::allocatePage() and File::deletePage() on files of growing
+ * size, in time and system calls per call.  System calls are counted with the
+ * syscr and syscw fields of /proc/self/io.
+ *
+ * Every file is written in the original layout, before the page directory:
+ * every eighth page is used and linked in a list, all other pages are free.
+ * The benchmark also reports the time File::open() takes to migrate the file
+ * and convert it, walking that list once.  Before the page directory, every
+ * allocation and deletion walked the list, reading one page per used page.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES[] = {1024, 10240, 102400};
+const std::uint32_t USED_EVERY = 8;
+const std::uint32_t OPERATIONS = 1024;
+const char* const FILE_NAME = "page_directory_bench.db";
+
+/**
+ * System calls made by the process so far.
+ */
+struct SystemCalls {
+  SystemCalls() : reads(0), writes(0) {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    unsigned long long value;
+    while (io >> key >> value) {
+      if (key == "syscr:") {
+        reads = value;
+      } else if (key == "syscw:") {
+        writes = value;
+      }
+    }
+  }
+
+  unsigned long long total() const { return reads + writes; }
+
+  unsigned long long reads;
+  unsigned long long writes;
+};
+
+void report(const char* name, const std::uint32_t num_pages,
+            const SystemCalls& before, const SystemCalls& after,
+            const double seconds) {
+  std::printf("pages=%-7u %-12s syscalls/op=%5.2f  op=%8.0f ns\n", num_pages,
+              name, static_cast<double>(after.total() - before.total()) / OPERATIONS,
+              seconds / OPERATIONS * 1e9);
+}
+
+void run(const std::uint32_t num_pages) {
+  // Only the headers of the used pages are written, so the file is sparse.
+  writeOriginalLayout(FILE_NAME, num_pages, USED_EVERY, 0 /* fill */);
+  {
+    Timer open_timer;
+    File file = File::open(FILE_NAME);
+    std::printf("pages=%-7u migrate      %8.2f ms\n", num_pages,
+                open_timer.seconds() * 1e3);
+
+    std::vector<PageId> allocated;
+    const SystemCalls before_allocate;
+    Timer allocate_timer;
+    for (std::uint32_t i = 0; i < OPERATIONS; ++i) {
+      allocated.push_back(file.allocatePage().page_number());
+    }
+    const double allocate_seconds = allocate_timer.seconds();
+    const SystemCalls after_allocate;
+    report("allocatePage", num_pages, before_allocate, after_allocate,
+           allocate_seconds);
+
+    const SystemCalls before_delete;
+    Timer delete_timer;
+    for (std::uint32_t i = 0; i < OPERATIONS; ++i) {
+      file.deletePage(allocated[i]);
+    }
+    const double delete_seconds = delete_timer.seconds();
+    const SystemCalls after_delete;
+    report("deletePage", num_pages, before_delete, after_delete,
+           delete_seconds);
+  }
+  File::remove(FILE_NAME);
+}
+
+}
+
+int main() {
+  for (std::size_t s = 0; s < sizeof(FILE_PAGES) / sizeof(FILE_PAGES[0]); ++s) {
+    run(FILE_PAGES[s]);
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares pinning resident pages with readPage() and unPinPage(), which
+ * looks the page up a second time, against PageHandle, which unpins the frame
+ * it holds.  For one shard and for several, and each thread count, the
+ * benchmark reports million page accesses per second on random pages of a
+ * buffer pool holding all of them.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t PAGES = 512;
+const std::uint32_t ACCESSES_PER_THREAD = 1 << 21;
+
+void run(File* file, const std::vector<PageId>& pages, std::uint32_t shards) {
+  BufMgr mgr(PAGES, shards);
+  Page* page;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    mgr.readPage(file, pages[i], page);
+    mgr.unPinPage(file, pages[i], false);
+  }
+
+  const std::vector<unsigned> counts = threadCounts();
+  for (std::size_t c = 0; c < counts.size(); ++c) {
+    const unsigned num_threads = counts[c];
+    const double pointer_seconds = runThreads(num_threads, [&](unsigned t) {
+      Random random(t + 1);
+      Page* page;
+      for (std::uint32_t i = 0; i < ACCESSES_PER_THREAD; ++i) {
+        const PageId pageNo = pages[random.below(PAGES)];
+        mgr.readPage(file, pageNo, page);
+        mgr.unPinPage(file, pageNo, false);
+      }
+    });
+    const double handle_seconds = runThreads(num_threads, [&](unsigned t) {
+      Random random(t + 1);
+      for (std::uint32_t i = 0; i < ACCESSES_PER_THREAD; ++i) {
+        PageHandle page = mgr.readPage(file, pages[random.below(PAGES)]);
+      }
+    });
+    std::printf("shards=%-3u threads=%-3u unPinPage=%8.2f Mops/s  PageHandle=%8.2f Mops/s\n",
+                shards, num_threads,
+                num_threads * ACCESSES_PER_THREAD / pointer_seconds / 1e6,
+                num_threads * ACCESSES_PER_THREAD / handle_seconds / 1e6);
+  }
+  mgr.flushFile(file);
+}
+
+}
+
+int main() {
+  ScratchFile scratch("page_handle_bench.db");
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(scratch.get()->allocatePage().page_number());
+  }
+  run(scratch.get(), pages, 1);
+  run(scratch.get(), pages, 8);
+  return 0;
+}
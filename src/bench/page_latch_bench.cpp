@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures reads of a small hot set of pages which many threads read and a
+ * few threads modify, like the upper levels of an index.  Readers either pin
+ * each page and take its latch shared, or read it optimistically with
+ * BufMgr::readOptimistic().  Writers pin a page, take its latch exclusive and
+ * rewrite its record, until all readers are done.
+ *
+ * Every record consists of one repeated character, so readers also check
+ * that they never accept a record torn by a concurrent writer.  For each
+ * number of reader threads the benchmark reports million reads per second,
+ * the share of optimistic reads that fell back to a pin, and the writes done
+ * meanwhile.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t HOT_PAGES = 16;
+const std::uint32_t FRAMES = 64;
+const std::uint32_t SHARDS = 4;
+const std::uint32_t WRITERS = 1;
+const std::uint32_t READS_PER_THREAD = 1 << 20;
+const std::size_t RECORD_SIZE = 64;
+
+/**
+ * Returns true if the record is not torn: all its characters are the same.
+ */
+bool consistent(const std::string& record) {
+  return record.size() == RECORD_SIZE &&
+         record.find_first_not_of(record[0]) == std::string::npos;
+}
+
+void run(const char* name, const bool optimistic) {
+  const std::vector<unsigned> counts = threadCounts();
+  for (std::size_t c = 0; c < counts.size(); ++c) {
+    const unsigned num_readers = counts[c];
+    ScratchFile scratch("page_latch_bench.db");
+    File* file = scratch.get();
+    BufMgr mgr(FRAMES, SHARDS);
+    PageId pages[HOT_PAGES];
+    RecordId rids[HOT_PAGES];
+    for (std::uint32_t i = 0; i < HOT_PAGES; ++i) {
+      PageHandle page = mgr.allocPage(file, pages[i]);
+      rids[i] = page->insertRecord(std::string(RECORD_SIZE, 'a'));
+      page.markDirty();
+    }
+
+    std::atomic<unsigned> readers_left(num_readers);
+    std::atomic<std::uint64_t> fallbacks(0);
+    std::atomic<std::uint64_t> torn(0);
+    std::atomic<std::uint64_t> writes(0);
+    const double seconds = runThreads(num_readers + WRITERS, [&](unsigned t) {
+      Random random(t + 1);
+      if (t < WRITERS) {
+        std::uint64_t done = 0;
+        while (readers_left.load(std::memory_order_relaxed) != 0) {
+          const std::uint32_t hot = random.below(HOT_PAGES);
+          PageHandle page = mgr.readPage(file, pages[hot]);
+          page.lockExclusive();
+          page->updateRecord(rids[hot], std::string(RECORD_SIZE, 'a' + done % 26));
+          page.markDirty();
+          page.unlock();
+          ++done;
+          std::this_thread::yield();
+        }
+        writes += done;
+        return;
+      }
+
+      std::uint64_t pinned = 0;
+      std::uint64_t bad = 0;
+      std::string record;
+      for (std::uint32_t i = 0; i < READS_PER_THREAD; ++i) {
+        const std::uint32_t hot = random.below(HOT_PAGES);
+        const PageId pageNo = pages[hot];
+        if (optimistic) {
+          if (!mgr.readOptimistic(file, pageNo, [&](const Page& page) {
+                record = page.getRecord(rids[hot]);
+              })) {
+            ++pinned;
+          }
+        } else {
+          PageHandle page = mgr.readPage(file, pageNo);
+          page.lockShared();
+          record = page->getRecord(rids[hot]);
+        }
+        if (!consistent(record)) {
+          ++bad;
+        }
+      }
+      fallbacks += pinned;
+      torn += bad;
+      readers_left--;
+    });
+
+    std::printf("%-12s readers=%-3u writers=%u reads=%8.2f Mops/s  pinned=%6.3f%%  writes=%llu\n",
+                name, num_readers, WRITERS,
+                num_readers * READS_PER_THREAD / seconds / 1e6,
+                optimistic ? 100.0 * fallbacks / (num_readers * READS_PER_THREAD) : 100.0,
+                static_cast<unsigned long long>(writes.load()));
+    if (torn != 0) {
+      std::fprintf(stderr, "%s: %llu torn records accepted\n", name,
+                   static_cast<unsigned long long>(torn.load()));
+    }
+    mgr.flushFile(file);
+  }
+}
+
+}
+
+int main() {
+  run("shared", false);
+  run("optimistic", true);
+  return 0;
+}
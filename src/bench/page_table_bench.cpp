@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares the throughput of the lock-free PageTable with BufHashTbl.
+ * BufHashTbl is not threadsafe, so it is measured the way a concurrent buffer
+ * manager would have to use it: behind one mutex.
+ *
+ * For each thread count, the benchmark reports million lookups per second on
+ * a table filled with as many pages as a buffer pool of ENTRIES frames holds,
+ * and million insert+remove pairs per second with every thread churning its
+ * own pages.
+ */
+
+#include <cstdio>
+#include <mutex>
+
+#include "bench/bench_util.h"
+#include "bufHashTbl.h"
+#include "page_table.h"
+#include "exceptions/hash_not_found_exception.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t ENTRIES = 1 << 16;
+const std::uint32_t LOOKUPS_PER_THREAD = 1 << 22;
+const std::uint32_t CHURN_PER_THREAD = 1 << 20;
+
+/**
+ * BufHashTbl behind a mutex, with the interface of PageTable.
+ */
+class LockedBufHashTbl {
+ public:
+  explicit LockedBufHashTbl(std::uint32_t capacity)
+      : table_(capacity) {
+  }
+
+  bool lookup(const File* file, PageId pageNo, FrameId& frameNo) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    try {
+      table_.lookup(file, pageNo, frameNo);
+      return true;
+    } catch (HashNotFoundException&) {
+      return false;
+    }
+  }
+
+  void insert(const File* file, PageId pageNo, FrameId frameNo) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    table_.insert(file, pageNo, frameNo);
+  }
+
+  void remove(const File* file, PageId pageNo) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    table_.remove(file, pageNo);
+  }
+
+ private:
+  std::mutex mutex_;
+  BufHashTbl table_;
+};
+
+template <typename Table>
+void run(const char* name, File* file) {
+  const std::vector<unsigned> counts = threadCounts();
+  for (std::size_t c = 0; c < counts.size(); ++c) {
+    const unsigned num_threads = counts[c];
+    Table table(ENTRIES);
+    for (PageId p = 1; p <= ENTRIES; ++p) {
+      table.insert(file, p, p - 1);
+    }
+
+    const double lookup_seconds = runThreads(num_threads, [&](unsigned t) {
+      Random random(t + 1);
+      FrameId frameNo;
+      std::uint32_t misses = 0;
+      for (std::uint32_t i = 0; i < LOOKUPS_PER_THREAD; ++i) {
+        if (!table.lookup(file, random.below(ENTRIES) + 1, frameNo)) {
+          ++misses;
+        }
+      }
+      if (misses != 0) {
+        std::fprintf(stderr, "unexpected misses: %u\n", misses);
+      }
+    });
+
+    // Threads insert and remove pages above the prefilled range, each in a
+    // window of its own, keeping the table at its usual occupancy.
+    const double churn_seconds = runThreads(num_threads, [&](unsigned t) {
+      const PageId base = ENTRIES + 1 + t * 64;
+      for (std::uint32_t i = 0; i < CHURN_PER_THREAD; ++i) {
+        const PageId pageNo = base + (i % 64);
+        if (i >= 64) {
+          table.remove(file, pageNo);
+        }
+        table.insert(file, pageNo, i);
+      }
+    });
+
+    std::printf("%-14s threads=%-3u lookup=%8.2f Mops/s  insert+remove=%8.2f Mops/s\n",
+                name, num_threads,
+                num_threads * LOOKUPS_PER_THREAD / lookup_seconds / 1e6,
+                num_threads * CHURN_PER_THREAD / churn_seconds / 1e6);
+  }
+}
+
+}
+
+int main() {
+  ScratchFile scratch("page_table_bench.db");
+  run<LockedBufHashTbl>("BufHashTbl", scratch.get());
+  run<PageTable>("PageTable", scratch.get());
+  return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures sequential read-ahead on full scans of a file sixteen times the
+ * size of the buffer pool, and on random reads of the same file, which
+ * should not trigger it.  For each, the benchmark reports thousand page reads
+ * per second and how many pages were read ahead, used and wasted.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 64;
+const std::uint32_t PAGES = FRAMES * 16;
+const std::uint32_t SCANS = 16;
+
+void run(File* file, const std::vector<PageId>& pages, const char* name,
+         bool scan, std::uint32_t maxPages) {
+  BufMgr mgr(FRAMES);
+  if (maxPages > 0) {
+    mgr.startReadAhead(maxPages);
+  }
+  Random random(1);
+  Page* page;
+  Timer timer;
+  for (std::uint32_t i = 0; i < SCANS * PAGES; ++i) {
+    const PageId pageNo = scan ? pages[i % PAGES] : pages[random.below(PAGES)];
+    mgr.readPage(file, pageNo, page);
+    mgr.unPinPage(file, pageNo, false);
+  }
+  const double seconds = timer.seconds();
+  mgr.stopReadAhead();
+  const BufStats& stats = mgr.getBufStats();
+  std::printf("%-7s %-10s %10.1f %11d %13d %14d\n", scan ? "scan" : "random",
+              name, SCANS * PAGES / seconds / 1e3, stats.prefetches.load(),
+              stats.prefetchhits.load(), stats.prefetchwaste.load());
+  mgr.flushFile(file);
+}
+
+}
+
+int main() {
+  ScratchFile scratch("read_ahead_bench.db");
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(scratch.get()->allocatePage().page_number());
+  }
+
+  std::printf("%u frames, %u pages, %u reads\n", FRAMES, PAGES,
+              SCANS * PAGES);
+  std::printf("%-7s %-10s %10s %11s %13s %14s\n", "reads", "read-ahead",
+              "Kreads/s", "prefetches", "prefetchhits", "prefetchwaste");
+  for (int scan = 1; scan >= 0; --scan) {
+    run(scratch.get(), pages, "off", scan == 1, 0);
+    run(scratch.get(), pages, "max 8", scan == 1, 8);
+    run(scratch.get(), pages, "max 32", scan == 1, 32);
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Compares the replacement policies of BufMgr on page reference traces which
+ * are known to separate them:
+ *  - scan: a hot set smaller than the pool, read at random, with long
+ *    sequential scans of cold pages in between.
+ *  - zipf: Zipf distributed references (theta = 0.99) over the whole file.
+ *  - loop: the same sequence of pages, one and a half times the size of the
+ *    pool, read over and over.
+ * For every trace and policy the benchmark reports the hit ratio of a single
+ * shard buffer pool and the thousand page reads per second, misses included.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t PAGES = 1024;
+const std::uint32_t FRAMES = 64;
+const std::uint32_t ACCESSES = 1 << 18;
+
+std::vector<PageId> scanTrace(const std::vector<PageId>& pages) {
+  const std::uint32_t hot = FRAMES * 3 / 4;
+  const std::uint32_t scan = FRAMES * 4;
+  Random random(1);
+  std::vector<PageId> trace;
+  std::uint32_t next_cold = hot;
+  while (trace.size() < ACCESSES) {
+    for (std::uint32_t i = 0; i < 2 * scan; ++i) {
+      trace.push_back(pages[random.below(hot)]);
+    }
+    for (std::uint32_t i = 0; i < scan; ++i) {
+      trace.push_back(pages[next_cold]);
+      next_cold = next_cold + 1 < PAGES ? next_cold + 1 : hot;
+    }
+  }
+  trace.resize(ACCESSES);
+  return trace;
+}
+
+std::vector<PageId> zipfTrace(const std::vector<PageId>& pages) {
+  std::vector<double> cdf(PAGES);
+  double sum = 0;
+  for (std::uint32_t rank = 0; rank < PAGES; ++rank) {
+    sum += 1.0 / std::pow(rank + 1.0, 0.99);
+    cdf[rank] = sum;
+  }
+  Random random(2);
+  std::vector<PageId> trace;
+  for (std::uint32_t i = 0; i < ACCESSES; ++i) {
+    const double u = (random.next() >> 11) * (1.0 / 9007199254740992.0) * sum;
+    std::uint32_t low = 0;
+    std::uint32_t high = PAGES - 1;
+    while (low < high) {
+      const std::uint32_t mid = (low + high) / 2;
+      if (cdf[mid] < u) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    // Spread the popular pages over the file.
+    trace.push_back(pages[(low * 7919) % PAGES]);
+  }
+  return trace;
+}
+
+std::vector<PageId> loopTrace(const std::vector<PageId>& pages) {
+  const std::uint32_t loop = FRAMES * 3 / 2;
+  std::vector<PageId> trace;
+  for (std::uint32_t i = 0; i < ACCESSES; ++i) {
+    trace.push_back(pages[i % loop]);
+  }
+  return trace;
+}
+
+void run(File* file, const char* trace_name, const std::vector<PageId>& trace) {
+  const PolicyKind policies[] = {PolicyKind::CLOCK, PolicyKind::LRU_K,
+                                 PolicyKind::TWO_Q, PolicyKind::ARC,
+                                 PolicyKind::CLOCK_PRO};
+  for (PolicyKind policy : policies) {
+    BufMgr mgr(FRAMES, 1, policy);
+    Page* page;
+    Timer timer;
+    for (std::uint32_t i = 0; i < trace.size(); ++i) {
+      mgr.readPage(file, trace[i], page);
+      mgr.unPinPage(file, trace[i], false);
+    }
+    const double seconds = timer.seconds();
+    const BufStats& stats = mgr.getBufStats();
+    std::unique_ptr<ReplacementPolicy> named(
+        ReplacementPolicy::create(policy, 0, 1));
+    std::printf("%-6s %-10s %9.3f %12.1f\n", trace_name, named->name(),
+                1.0 - static_cast<double>(stats.diskreads) / stats.accesses,
+                trace.size() / seconds / 1e3);
+  }
+}
+
+}
+
+int main() {
+  ScratchFile scratch("replacement_bench.db");
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(scratch.get()->allocatePage().page_number());
+  }
+
+  std::printf("%u frames, %u pages, %u reads per trace\n", FRAMES, PAGES,
+              ACCESSES);
+  std::printf("%-6s %-10s %9s %12s\n", "trace", "policy", "hit ratio",
+              "Kreads/s");
+  run(scratch.get(), "scan", scanTrace(pages));
+  run(scratch.get(), "zipf", zipfTrace(pages));
+  run(scratch.get(), "loop", loopTrace(pages));
+  return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures BufMgr::resize() while other threads keep reading pages.  Reader
+ * threads pin and unpin random pages of a file, first with the pool at a
+ * fixed size, then while one more thread keeps shrinking the pool to a
+ * quarter of the file and growing it back to the whole file.
+ *
+ * The benchmark reports million reads per second in both cases, and the
+ * number and average duration of the resizes.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FILE_PAGES = 512;
+const std::uint32_t SHARDS = 4;
+const std::uint32_t READS_PER_THREAD = 1 << 18;
+
+void run(const char* name, File* file, const PageId* pages, const bool resizing) {
+  const std::vector<unsigned> counts = threadCounts();
+  for (std::size_t c = 0; c < counts.size(); ++c) {
+    const unsigned num_readers = counts[c];
+    BufMgr mgr(FILE_PAGES, SHARDS, PolicyKind::CLOCK,
+               ArenaPages::TRANSPARENT_HUGE, false, FILE_PAGES);
+    std::atomic<unsigned> readers_left(num_readers);
+    std::uint32_t resizes = 0;
+    double resize_seconds = 0;
+    const double seconds = runThreads(num_readers + (resizing ? 1 : 0), [&](unsigned t) {
+      if (t == num_readers) {
+        while (readers_left.load() != 0) {
+          Timer timer;
+          mgr.resize(resizes % 2 == 0 ? FILE_PAGES / 4 : FILE_PAGES);
+          resize_seconds += timer.seconds();
+          ++resizes;
+          std::this_thread::yield();
+        }
+        return;
+      }
+      Random random(t + 1);
+      for (std::uint32_t i = 0; i < READS_PER_THREAD; ++i) {
+        PageHandle page = mgr.readPage(file, pages[random.below(FILE_PAGES)]);
+      }
+      readers_left--;
+    });
+
+    std::printf("%-10s readers=%-3u reads=%8.2f Mops/s  resizes=%-6u avg resize=%8.1f us\n",
+                name, num_readers,
+                num_readers * READS_PER_THREAD / seconds / 1e6, resizes,
+                resizes ? resize_seconds / resizes * 1e6 : 0.0);
+  }
+}
+
+}
+
+int main() {
+  ScratchFile scratch("resize_bench.db");
+  PageId pages[FILE_PAGES];
+  for (std::uint32_t i = 0; i < FILE_PAGES; ++i) {
+    pages[i] = scratch.get()->allocatePage().page_number();
+  }
+  run("fixed", scratch.get(), pages, false);
+  run("resizing", scratch.get(), pages, true);
+  return 0;
+}
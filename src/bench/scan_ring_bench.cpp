@@ -0,0 +1,115 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures how full scans affect the hit ratio of a hot set of pages.  One
+ * thread reads random pages of a hot set half the size of the buffer pool
+ * while a second thread scans a file sixteen times the size of the pool over
+ * and over: not at all, with plain reads, and through a ScanRing.  For each
+ * replacement policy, the benchmark reports the hit ratio of the hot reads
+ * and how many scan pages were read per second.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 64;
+const std::uint32_t HOT_PAGES = FRAMES / 2;
+const std::uint32_t SCAN_PAGES = FRAMES * 16;
+const std::uint32_t HOT_READS = 1 << 16;
+
+enum class Scan { NONE, PLAIN, RING };
+
+void run(File* hot, File* cold, const std::vector<PageId>& hotPages,
+         const std::vector<PageId>& scanPages, PolicyKind policy, Scan scan) {
+  BufMgr mgr(FRAMES, 1, policy);
+  std::atomic<bool> done(false);
+  std::uint64_t scanned = 0;
+  Timer timer;
+  std::thread scanner([&]() {
+    if (scan == Scan::NONE) {
+      return;
+    }
+    ScanRing ring;
+    Page* page;
+    while (!done.load()) {
+      for (std::uint32_t i = 0; i < SCAN_PAGES && !done.load(); ++i) {
+        mgr.readPage(cold, scanPages[i], page,
+                     scan == Scan::RING ? &ring : NULL);
+        mgr.unPinPage(cold, scanPages[i], false);
+        ++scanned;
+      }
+    }
+  });
+
+  Random random(1);
+  Page* page;
+  std::uint32_t hits = 0;
+  for (std::uint32_t i = 0; i < HOT_READS; ++i) {
+    const PageId pageNo = hotPages[random.below(HOT_PAGES)];
+    if (mgr.tryReadPage(hot, pageNo, page) == PageStatus::HIT) {
+      ++hits;
+    }
+    mgr.unPinPage(hot, pageNo, false);
+    if (i % 64 == 0) {
+      std::this_thread::yield();  // let the scan make progress on one core
+    }
+  }
+  done = true;
+  scanner.join();
+  const double seconds = timer.seconds();
+
+  const std::unique_ptr<ReplacementPolicy> named(
+      ReplacementPolicy::create(policy, 0, 1));
+  const char* scanName = scan == Scan::NONE ? "none"
+                         : scan == Scan::PLAIN ? "plain" : "ring";
+  std::printf("%-10s %-6s %12.4f %14.1f\n", named->name(), scanName,
+              static_cast<double>(hits) / HOT_READS, scanned / seconds / 1e3);
+  mgr.flushFile(hot);
+  mgr.flushFile(cold);
+}
+
+}
+
+int main() {
+  ScratchFile hot("scan_ring_bench_hot.db");
+  ScratchFile cold("scan_ring_bench_cold.db");
+  std::vector<PageId> hotPages;
+  for (std::uint32_t i = 0; i < HOT_PAGES; ++i) {
+    hotPages.push_back(hot.get()->allocatePage().page_number());
+  }
+  std::vector<PageId> scanPages;
+  for (std::uint32_t i = 0; i < SCAN_PAGES; ++i) {
+    scanPages.push_back(cold.get()->allocatePage().page_number());
+  }
+
+  const PolicyKind policies[] = {PolicyKind::CLOCK, PolicyKind::LRU_K,
+                                 PolicyKind::TWO_Q, PolicyKind::ARC,
+                                 PolicyKind::CLOCK_PRO};
+  std::printf("%u frames, %u hot pages, %u scan pages, %u hot reads\n",
+              FRAMES, HOT_PAGES, SCAN_PAGES, HOT_READS);
+  std::printf("%-10s %-6s %12s %14s\n", "policy", "scan", "hot hit ratio",
+              "Kscanned/s");
+  for (PolicyKind policy : policies) {
+    run(hot.get(), cold.get(), hotPages, scanPages, policy, Scan::NONE);
+    run(hot.get(), cold.get(), hotPages, scanPages, policy, Scan::PLAIN);
+    run(hot.get(), cold.get(), hotPages, scanPages, policy, Scan::RING);
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures writing back a buffer pool full of dirty pages of one file, read in
+ * random order.  The pages are first written one File::writePage() call at a
+ * time in the order of their frames, as flushFile() used to, and then made
+ * dirty again and written by BufMgr::flushFile(), which sorts them and writes
+ * runs of consecutive pages with one vectored write.
+ *
+ * The file is written in the original layout and migrated when it is opened,
+ * which is faster than allocating its pages one at a time.  Flushing 1M pages needs
+ * about 16 GB of memory for the pool and the page cache; add it to
+ * DIRTY_PAGES where that is available.  The benchmark reports the time of
+ * both write-backs and the pages written per second.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t DIRTY_PAGES[] = {10000, 100000};
+const char* const FILE_NAME = "write_back_bench.db";
+
+void run(const std::uint32_t pages) {
+  writeOriginalLayout(FILE_NAME, pages + 1, 1 /* used_every */, 0 /* fill */);
+  {
+    File file = File::open(FILE_NAME);
+    BufMgr mgr(pages);
+    std::vector<PageId> order(pages);
+    for (PageId p = 1; p <= pages; ++p) {
+      order[p - 1] = p;
+    }
+    Random random(pages);
+    for (std::uint32_t i = pages - 1; i > 0; --i) {
+      std::swap(order[i], order[random.below(i + 1)]);
+    }
+    std::vector<Page*> frames(pages);
+    for (std::uint32_t i = 0; i < pages; ++i) {
+      mgr.readPage(&file, order[i], frames[i]);
+    }
+
+    Timer per_page;
+    for (std::uint32_t i = 0; i < pages; ++i) {
+      file.writePage(*frames[i]);
+    }
+    const double per_page_seconds = per_page.seconds();
+
+    for (std::uint32_t i = 0; i < pages; ++i) {
+      mgr.unPinPage(&file, order[i], true);
+    }
+    Timer coalesced;
+    mgr.flushFile(&file);
+    const double coalesced_seconds = coalesced.seconds();
+
+    std::printf("pages=%-8u per-page=%8.3f s (%9.0f pages/s)  coalesced=%8.3f s (%9.0f pages/s)\n",
+                pages, per_page_seconds, pages / per_page_seconds,
+                coalesced_seconds, pages / coalesced_seconds);
+  }
+  File::remove(FILE_NAME);
+}
+
+}
+
+int main() {
+  for (std::size_t i = 0; i < sizeof(DIRTY_PAGES) / sizeof(DIRTY_PAGES[0]); ++i) {
+    run(DIRTY_PAGES[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/**
+ * Measures what a buffer pool miss costs in heap allocations.  Reads of a file
+ * four times the size of the buffer pool, and allocations of new pages, are
+ * done both the way the buffer manager used to do them (into a temporary Page
+ * which is then copied into the frame) and through BufMgr, which has the file
+ * read into the frame itself.  Pages are allocated in fresh files, so that
+ * both ways search used lists of the same length.  The benchmark reports
+ * allocations and kilobytes allocated per page, and thousand pages per
+ * second.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "bench/bench_util.h"
+#include "buffer.h"
+
+namespace {
+
+std::atomic<std::uint64_t> allocations(0);
+std::atomic<std::uint64_t> allocatedBytes(0);
+
+}
+
+// Not inlined, so that the compiler does not pair malloc() and free() with
+// new and delete expressions and warn about a mismatch.
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  ++allocations;
+  allocatedBytes += size;
+  if (void* p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+using namespace badgerdb;
+using namespace badgerdb::bench;
+
+namespace {
+
+const std::uint32_t FRAMES = 64;
+const std::uint32_t PAGES = FRAMES * 4;
+const std::uint32_t READS = PAGES * 16;
+const std::uint32_t ALLOCS = 256;
+
+/**
+ * Counts the allocations made from its construction, and prints them per page
+ * when done.
+ */
+class Meter {
+ public:
+  explicit Meter(const char* name)
+      : name_(name),
+        allocations_(allocations.load()),
+        bytes_(allocatedBytes.load()) {
+  }
+
+  void done(std::uint32_t pages) {
+    const double seconds = timer_.seconds();
+    std::printf("%-22s %12.2f %14.2f %10.1f\n", name_,
+                static_cast<double>(allocations - allocations_) / pages,
+                (allocatedBytes - bytes_) / 1024.0 / pages,
+                pages / seconds / 1e3);
+  }
+
+ private:
+  const char* name_;
+  std::uint64_t allocations_;
+  std::uint64_t bytes_;
+  Timer timer_;
+};
+
+}
+
+int main() {
+  ScratchFile scratch("zero_copy_bench.db");
+  File* file = scratch.get();
+  std::vector<PageId> pages;
+  for (std::uint32_t i = 0; i < PAGES; ++i) {
+    pages.push_back(file->allocatePage().page_number());
+  }
+
+  std::printf("%u frames, %u pages, %u reads, %u allocations\n", FRAMES, PAGES,
+              READS, ALLOCS);
+  std::printf("%-22s %12s %14s %10s\n", "path", "allocs/page", "KB alloc/page",
+              "Kpages/s");
+  {
+    std::unique_ptr<Page[]> frames(new Page[FRAMES]);
+    Meter meter("read, copy into frame");
+    for (std::uint32_t i = 0; i < READS; ++i) {
+      Page temp = file->readPage(pages[i % PAGES]);
+      frames[i % FRAMES] = temp;
+    }
+    meter.done(READS);
+  }
+  {
+    BufMgr mgr(FRAMES);
+    Page* page;
+    Meter meter("read, BufMgr miss");
+    for (std::uint32_t i = 0; i < READS; ++i) {
+      mgr.readPage(file, pages[i % PAGES], page);
+      mgr.unPinPage(file, pages[i % PAGES], false);
+    }
+    meter.done(READS);
+    mgr.flushFile(file);
+  }
+  {
+    ScratchFile allocated("zero_copy_bench_copy.db");
+    std::unique_ptr<Page[]> frames(new Page[FRAMES]);
+    Meter meter("alloc, copy into frame");
+    for (std::uint32_t i = 0; i < ALLOCS; ++i) {
+      Page temp = allocated.get()->allocatePage();
+      frames[i % FRAMES] = temp;
+    }
+    meter.done(ALLOCS);
+  }
+  {
+    ScratchFile allocated("zero_copy_bench_bufmgr.db");
+    BufMgr mgr(FRAMES);
+    PageId pageNo;
+    Page* page;
+    Meter meter("alloc, BufMgr");
+    for (std::uint32_t i = 0; i < ALLOCS; ++i) {
+      mgr.allocPage(allocated.get(), pageNo, page);
+      mgr.unPinPage(allocated.get(), pageNo, false);
+    }
+    meter.done(ALLOCS);
+    mgr.flushFile(allocated.get());
+  }
+  return 0;
+}
@@ -7,108 +7,376 @@
 
 #include <memory>
 #include <iostream>
+#include <cstring>
 #include "buffer.h"
 #include "bufHashTbl.h"
 #include "exceptions/hash_already_present_exception.h"
 #include "exceptions/hash_not_found_exception.h"
-#include "exceptions/hash_table_exception.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File* file, const PageId pageNo)
+namespace {
+
+/**
+ * Control byte of a bucket that has never held an entry since the table was last rehashed
+ */
+const std::int8_t CTRL_EMPTY = -128;
+
+/**
+ * Control byte of a bucket whose entry was removed
+ */
+const std::int8_t CTRL_DELETED = -2;
+
+/**
+ * Returns a mask with bit i set if the i-th control byte of the group equals value
+ */
+inline std::uint32_t matchByte(const std::int8_t* group, const std::int8_t value)
+{
+#ifdef __SSE2__
+  const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return (std::uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+  std::uint32_t mask = 0;
+  for (std::uint32_t i = 0; i < BufHashTbl::GROUP_SIZE; i++)
+    if (group[i] == value)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+/**
+ * Returns a mask with bit i set if the i-th bucket of the group is empty or deleted; both have the sign bit set
+ */
+inline std::uint32_t matchFree(const std::int8_t* group)
+{
+#ifdef __SSE2__
+  return (std::uint32_t) _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+  std::uint32_t mask = 0;
+  for (std::uint32_t i = 0; i < BufHashTbl::GROUP_SIZE; i++)
+    if (group[i] < 0)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+/**
+ * Index of the lowest set bit of a non-zero mask
+ */
+inline std::uint32_t lowestBit(const std::uint32_t mask)
+{
+  return (std::uint32_t) __builtin_ctz(mask);
+}
+
+/**
+ * Number of entries a table of the given number of groups may hold, counting deleted buckets, before it is
+ * rehashed; at most 7/8 of the buckets are ever in use so that a probe finds a free bucket quickly
+ */
+inline std::uint32_t growthLimit(const std::uint32_t groups)
+{
+  return groups * BufHashTbl::GROUP_SIZE / 8 * 7;
+}
+
+/**
+ * Number of entries a table of the given number of groups is sized for; the rest of the growth limit is left to
+ * deleted buckets, so that pages evicted and read back over and over rarely force a rehash
+ */
+inline std::uint32_t maxEntries(const std::uint32_t groups)
+{
+  return growthLimit(groups) / 4 * 3;
+}
+
+}
+
+std::uint64_t BufHashTbl::hash(const File* file, const PageId pageNo)
 {
-  int tmp, value;
-  tmp = (long)file;  // cast of pointer to the file object to an integer
-  value = (tmp + pageNo) % HTSIZE;
-  return value;
+  /// file objects are at least 16 byte aligned, so the low bits of the pointer carry no information;
+  /// the multiply spreads the pointer over all bits before the splitmix64 finalizer mixes in the page number
+  std::uint64_t h = ((std::uint64_t) (std::uintptr_t) file >> 4) * 0x9E3779B97F4A7C15ULL + pageNo;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  return h ^ (h >> 31);
 }
 
+const std::uint32_t BufHashTbl::MIGRATE_GROUPS;
+
 BufHashTbl::BufHashTbl(int htSize)
-	: HTSIZE(htSize)
+	: numEntries(0), numDeleted(0), oldHt(NULL), oldNumGroups(0), migrated(0), oldEntries(0)
 {
-  // allocate an array of pointers to hashBuckets
-  ht = new hashBucket* [htSize];
-  for(int i=0; i < HTSIZE; i++)
-    ht[i] = NULL;
+  if (htSize < 1)
+    htSize = 1;
+  numGroups = 1;
+  while (maxEntries(numGroups) < (std::uint32_t) htSize)
+    numGroups <<= 1;
+  ht = allocate(numGroups);
+  spareHt = allocate(numGroups);
 }
 
 BufHashTbl::~BufHashTbl()
 {
-  for(int i = 0; i < HTSIZE; i++) {
-    hashBucket* tmpBuf = ht[i];
-    while (ht[i]) {
-      tmpBuf = ht[i];
-      ht[i] = ht[i]->next;
-      delete tmpBuf;
-    }
-  }
   delete [] ht;
+  delete [] spareHt;
+  delete [] oldHt;
 }
 
-void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
+hashGroup* BufHashTbl::allocate(const std::uint32_t groups)
 {
-  int index = hash(file, pageNo);
+  hashGroup* table = new hashGroup[groups];
+  for (std::uint32_t g = 0; g < groups; g++)
+    std::memset(table[g].ctrl, CTRL_EMPTY, GROUP_SIZE);
+  return table;
+}
 
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-  		throw HashAlreadyPresentException(tmpBuc->file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
-    tmpBuc = tmpBuc->next;
-  }
+bool BufHashTbl::find(const File* file, const PageId pageNo, hashGroup*& group, std::uint32_t& slot) const
+{
+  if (findIn(ht, numGroups, file, pageNo, group, slot))
+    return true;
+  return oldHt && findIn(oldHt, oldNumGroups, file, pageNo, group, slot);
+}
 
-  tmpBuc = new hashBucket;
-  if (!tmpBuc)
-  	throw HashTableException();
+bool BufHashTbl::findIn(hashGroup* table, const std::uint32_t groups, const File* file, const PageId pageNo,
+                        hashGroup*& group, std::uint32_t& slot)
+{
+  const std::uint64_t h = hash(file, pageNo);
+  const std::int8_t h2 = (std::int8_t) (h & 0x7F);
+  const std::uint32_t groupMask = groups - 1;
+  std::uint32_t index = (std::uint32_t) (h >> 7) & groupMask;
 
-  tmpBuc->file = (File*) file;
-  tmpBuc->pageNo = pageNo;
-  tmpBuc->frameNo = frameNo;
-  tmpBuc->next = ht[index];
-  ht[index] = tmpBuc;
+  /// triangular probing visits every group once when the number of groups is a power of two
+  for (std::uint32_t probe = 1; probe <= groups; probe++)
+  {
+    hashGroup& g = table[index];
+    std::uint32_t candidates = matchByte(g.ctrl, h2);
+    while (candidates)
+    {
+      const std::uint32_t i = lowestBit(candidates);
+      if (g.buckets[i].file == file && g.buckets[i].pageNo == pageNo)
+      {
+        group = &g;
+        slot = i;
+        return true;
+      }
+      candidates &= candidates - 1;
+    }
+    /// an insert only moves on to the next group if this one is full, so an empty bucket ends the probe
+    if (matchByte(g.ctrl, CTRL_EMPTY))
+      return false;
+    index = (index + probe) & groupMask;
+  }
+  return false;
 }
 
-void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
+void BufHashTbl::place(const File* file, const PageId pageNo, const FrameId frameNo)
 {
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
+  const std::uint64_t h = hash(file, pageNo);
+  const std::uint32_t groupMask = numGroups - 1;
+  std::uint32_t index = (std::uint32_t) (h >> 7) & groupMask;
+
+  for (std::uint32_t probe = 1; ; probe++)
+  {
+    hashGroup& g = ht[index];
+    const std::uint32_t free = matchFree(g.ctrl);
+    if (free)
     {
-      frameNo = tmpBuc->frameNo; // return frameNo by reference
+      fill(g, lowestBit(free), (std::int8_t) (h & 0x7F), file, pageNo, frameNo);
       return;
     }
-    tmpBuc = tmpBuc->next;
+    index = (index + probe) & groupMask;
   }
+}
 
-  throw HashNotFoundException(file->filename(), pageNo);
+void BufHashTbl::fill(hashGroup& group, const std::uint32_t slot, const std::int8_t h2,
+                      const File* file, const PageId pageNo, const FrameId frameNo)
+{
+  if (group.ctrl[slot] == CTRL_DELETED)
+    numDeleted--;
+  group.ctrl[slot] = h2;
+  group.buckets[slot].file = (File*) file;
+  group.buckets[slot].pageNo = pageNo;
+  group.buckets[slot].frameNo = frameNo;
+  numEntries++;
 }
 
-void BufHashTbl::remove(const File* file, const PageId pageNo) {
+void BufHashTbl::rehash(const std::uint32_t newNumGroups)
+{
+  hashGroup* oldHt = ht;
+  const std::uint32_t oldNumGroups = numGroups;
 
-  int index = hash(file, pageNo);
-  hashBucket* tmpBuc = ht[index];
-  hashBucket* prevBuc = NULL;
+  if (newNumGroups == numGroups)
+  {
+    /// reuse the spare array, so that purging deleted buckets does not allocate
+    ht = spareHt;
+    for (std::uint32_t g = 0; g < numGroups; g++)
+      std::memset(ht[g].ctrl, CTRL_EMPTY, GROUP_SIZE);
+    spareHt = oldHt;
+  }
+  else
+  {
+    delete [] spareHt;
+    ht = allocate(newNumGroups);
+    spareHt = allocate(newNumGroups);
+  }
 
-  while (tmpBuc)
-	{
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-		{
-      if(prevBuc) 
-				prevBuc->next = tmpBuc->next;
-      else
-				ht[index] = tmpBuc->next;
+  numGroups = newNumGroups;
+  numEntries = 0;
+  numDeleted = 0;
+  for (std::uint32_t g = 0; g < oldNumGroups; g++)
+    for (std::uint32_t i = 0; i < GROUP_SIZE; i++)
+      if (oldHt[g].ctrl[i] >= 0)
+        place(oldHt[g].buckets[i].file, oldHt[g].buckets[i].pageNo, oldHt[g].buckets[i].frameNo);
 
-      delete tmpBuc;
-      return;
+  if (oldHt != spareHt)
+    delete [] oldHt;
+}
+
+void BufHashTbl::grow(const std::uint32_t newNumGroups)
+{
+  migrate(oldNumGroups);
+  delete [] spareHt;
+  oldHt = ht;
+  oldNumGroups = numGroups;
+  oldEntries = numEntries;
+  migrated = 0;
+  ht = allocate(newNumGroups);
+  spareHt = allocate(newNumGroups);
+  numGroups = newNumGroups;
+  numDeleted = 0;
+}
+
+void BufHashTbl::migrate(const std::uint32_t count)
+{
+  if (!oldHt)
+    return;
+  for (std::uint32_t moved = 0; moved < count && migrated < oldNumGroups; moved++, migrated++)
+  {
+    hashGroup& g = oldHt[migrated];
+    for (std::uint32_t i = 0; i < GROUP_SIZE; i++)
+    {
+      if (g.ctrl[i] < 0)
+        continue;
+      /// place() counts the entry again
+      oldEntries--;
+      numEntries--;
+      place(g.buckets[i].file, g.buckets[i].pageNo, g.buckets[i].frameNo);
     }
-		else
-		{
-      prevBuc = tmpBuc;
-      tmpBuc = tmpBuc->next;
+    /// deleted rather than empty, so that probes for entries not moved yet still walk over the group
+    std::memset(g.ctrl, CTRL_DELETED, GROUP_SIZE);
+  }
+  if (migrated == oldNumGroups)
+  {
+    delete [] oldHt;
+    oldHt = NULL;
+  }
+}
+
+void BufHashTbl::reserve(const std::uint32_t entries)
+{
+  std::uint32_t groups = numGroups;
+  while (maxEntries(groups) < entries)
+    groups <<= 1;
+  if (groups != numGroups)
+    grow(groups);
+}
+
+void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
+{
+  if (oldHt)
+  {
+    hashGroup* group;
+    std::uint32_t slot;
+    if (findIn(oldHt, oldNumGroups, file, pageNo, group, slot))
+      throw HashAlreadyPresentException(file->filename(), pageNo, group->buckets[slot].frameNo);
+    migrate(MIGRATE_GROUPS);
+  }
+
+  const std::uint64_t h = hash(file, pageNo);
+  const std::int8_t h2 = (std::int8_t) (h & 0x7F);
+  const std::uint32_t groupMask = numGroups - 1;
+  std::uint32_t index = (std::uint32_t) (h >> 7) & groupMask;
+  hashGroup* freeGroup = NULL;
+  std::uint32_t freeSlot = 0;
+
+  /// look for the page and for the first free bucket in the same probe
+  for (std::uint32_t probe = 1; probe <= numGroups; probe++)
+  {
+    hashGroup& g = ht[index];
+    std::uint32_t candidates = matchByte(g.ctrl, h2);
+    while (candidates)
+    {
+      const std::uint32_t i = lowestBit(candidates);
+      if (g.buckets[i].file == file && g.buckets[i].pageNo == pageNo)
+        throw HashAlreadyPresentException(file->filename(), pageNo, g.buckets[i].frameNo);
+      candidates &= candidates - 1;
     }
+    const std::uint32_t free = matchFree(g.ctrl);
+    if (!freeGroup && free)
+    {
+      freeGroup = &g;
+      freeSlot = lowestBit(free);
+    }
+    if (matchByte(g.ctrl, CTRL_EMPTY))
+      break;
+    index = (index + probe) & groupMask;
   }
 
-  throw HashNotFoundException(file->filename(), pageNo);
+  if (numEntries - oldEntries + numDeleted + 1 > growthLimit(numGroups))
+  {
+    /// grow only if the table holds more entries than it was sized for, otherwise just purge deleted buckets;
+    /// either way, a growth still in progress is finished first
+    migrate(oldNumGroups);
+    if (numEntries + 1 > maxEntries(numGroups))
+      grow(numGroups * 2);
+    else
+      rehash(numGroups);
+    place(file, pageNo, frameNo);
+    return;
+  }
+
+  fill(*freeGroup, freeSlot, h2, file, pageNo, frameNo);
+}
+
+void BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo)
+{
+  if (!tryLookup(file, pageNo, frameNo))
+    throw HashNotFoundException(file->filename(), pageNo);
+}
+
+bool BufHashTbl::tryLookup(const File* file, const PageId pageNo, FrameId &frameNo) const
+{
+  hashGroup* group;
+  std::uint32_t slot;
+  if (!find(file, pageNo, group, slot))
+    return false;
+  frameNo = group->buckets[slot].frameNo; // return frameNo by reference
+  return true;
+}
+
+void BufHashTbl::remove(const File* file, const PageId pageNo) {
+
+  hashGroup* group;
+  std::uint32_t slot;
+  if (!find(file, pageNo, group, slot))
+    throw HashNotFoundException(file->filename(), pageNo);
+
+  /// a group that still has an empty bucket has never been full, so no probe continued past it and the bucket
+  /// can become empty again; otherwise later probes must keep walking over it
+  const bool old = oldHt && group >= oldHt && group < oldHt + oldNumGroups;
+  if (matchByte(group->ctrl, CTRL_EMPTY))
+    group->ctrl[slot] = CTRL_EMPTY;
+  else
+  {
+    group->ctrl[slot] = CTRL_DELETED;
+    if (!old)
+      numDeleted++;
+  }
+  numEntries--;
+  if (old)
+    oldEntries--;
+  migrate(MIGRATE_GROUPS);
 }
 
 }
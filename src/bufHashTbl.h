@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "file.h"
 
 namespace badgerdb {
@@ -29,43 +31,173 @@ struct hashBucket {
 	 * frame number of page in the buffer pool
 	 */
 	FrameId frameNo;
+};
 
+/**
+* @brief Group of hashBuckets probed together, preceded by their control bytes so that a probe of the group
+* usually touches the cache lines of one group only
+*/
+struct hashGroup {
 	/**
-	 * Next node in the hash table
+	 * One control byte per bucket: EMPTY, DELETED, or the low 7 bits of the hash of the entry in the bucket
 	 */
-	hashBucket*   next;
+	std::int8_t ctrl[16];
+
+	/**
+	 * Entries of the group
+	 */
+	hashBucket buckets[16];
 };
 
 
 /**
 * @brief Hash table class to keep track of pages in the buffer pool
 *
+* The table is a flat open-addressing table in the style of a Swiss table: one array of hashGroups, each holding
+* GROUP_SIZE buckets and one control byte per bucket.  The control bytes of a group are compared against 7 bits of
+* the hash in one SSE2 instruction, so a lookup reads the entries of a group only for the few candidates whose hash
+* bits match.  The array is allocated when the table is constructed; inserting and removing entries never allocates
+* as long as the table holds no more entries than it was sized for.
+*
+* When the table grows, its entries are moved to the larger array incrementally: every insert and remove moves
+* MIGRATE_GROUPS groups of the old array, and lookups probe the old array too until it is empty.  No single call
+* pays for rehashing the whole table.
+*
 * @warning This class is not threadsafe.
 */
 class BufHashTbl
 {
+ public:
+	/**
+	 * Number of buckets probed at once
+	 */
+  static const std::uint32_t GROUP_SIZE = 16;
+
+	/**
+	 * Number of groups of the old array moved by every insert and remove while the table grows
+	 */
+  static const std::uint32_t MIGRATE_GROUPS = 8;
+
  private:
 	/**
-	 *	Size of Hash Table
+	 * Number of groups; always a power of two
+	 */
+  std::uint32_t numGroups;
+
+	/**
+	 * Number of entries in the table
+	 */
+  std::uint32_t numEntries;
+
+	/**
+	 * Number of buckets holding a deleted entry
 	 */
-  int HTSIZE;
+  std::uint32_t numDeleted;
+
 	/**
 	 * Actual Hash table object
 	 */
-  hashBucket**  ht;
+  hashGroup*  ht;
+
+	/**
+	 * Array of the same number of groups, used when the table is rehashed in place to purge deleted buckets
+	 */
+  hashGroup*  spareHt;
+
+	/**
+	 * Array the table is growing out of, whose entries have not all been moved to ht yet; NULL if the table is not
+	 * growing
+	 */
+  hashGroup*  oldHt;
+
+	/**
+	 * Number of groups of oldHt
+	 */
+  std::uint32_t oldNumGroups;
 
 	/**
-	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+	 * Number of groups of oldHt moved to ht so far
+	 */
+  std::uint32_t migrated;
+
+	/**
+	 * Number of entries still in oldHt (included in numEntries)
+	 */
+  std::uint32_t oldEntries;
+
+	/**
+	 * Finds the bucket holding (file, pageNo).
 	 *
 	 * @param file   	File object
 	 * @param pageNo  Page number in the file
-	 * @return  			Hash value.
+	 * @param group   Set to the group holding the page
+	 * @param slot    Set to the index of the bucket within the group
+	 * @return  			false if the page is not in the table
 	 */
-  int	 hash(const File* file, const PageId pageNo);
+  bool find(const File* file, const PageId pageNo, hashGroup*& group, std::uint32_t& slot) const;
+
+	/**
+	 * Finds the bucket holding (file, pageNo) in one array of groups.
+	 *
+	 * @param table   Array to search
+	 * @param groups  Number of groups of the array
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param group   Set to the group holding the page
+	 * @param slot    Set to the index of the bucket within the group
+	 * @return  			false if the page is not in the array
+	 */
+  static bool findIn(hashGroup* table, const std::uint32_t groups, const File* file, const PageId pageNo,
+                     hashGroup*& group, std::uint32_t& slot);
+
+	/**
+	 * Places an entry known not to be in the table into the first free bucket on its probe sequence.
+	 */
+  void place(const File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * Stores an entry in a free bucket of a group.
+	 */
+  void fill(hashGroup& group, const std::uint32_t slot, const std::int8_t h2,
+            const File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * Moves all entries into fresh arrays of the given number of groups, dropping deleted buckets.
+	 */
+  void rehash(const std::uint32_t newNumGroups);
+
+	/**
+	 * Starts growing the table to the given number of groups.  Entries move to the new array with later inserts
+	 * and removes (see migrate()).
+	 */
+  void grow(const std::uint32_t newNumGroups);
+
+	/**
+	 * Moves up to count groups of the array the table is growing out of to the current one, and frees the old
+	 * array once it is empty.
+	 */
+  void migrate(const std::uint32_t count);
+
+	/**
+	 * Allocates the given number of groups, with all buckets empty.
+	 */
+  static hashGroup* allocate(const std::uint32_t groups);
 
  public:
 	/**
+	 * Returns a well-mixed 64-bit hash of file and pageNo.  Pages of one file and pages of files allocated next to
+	 * each other spread over the whole range.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return  			Hash value.
+	 */
+  static std::uint64_t hash(const File* file, const PageId pageNo);
+
+	/**
    * Constructor of BufHashTbl class
+	 *
+	 * @param htSize	Number of entries the table has to hold without growing, normally the number of frames
 	 */
 	BufHashTbl(const int htSize);  // constructor
 
@@ -73,7 +205,7 @@ class BufHashTbl
    * Destructor of BufHashTbl class
 	 */
   ~BufHashTbl(); // destructor
-	
+
 	/**
    * Insert entry into hash table mapping (file, pageNo) to frameNo.
 	 *
@@ -81,7 +213,6 @@ class BufHashTbl
 	 * @param pageNo 	Page number in the file
 	 * @param frameNo Frame number assigned to that page of the file
    * @throws  HashAlreadyPresentException	if the corresponding page already exists in the hash table
-   * @throws  HashTableException (optional) if could not create a new bucket as running of memory
 	 */
   void insert(const File* file, const PageId pageNo, const FrameId frameNo);
 
@@ -92,18 +223,38 @@ class BufHashTbl
 	 * @param file  	File object
 	 * @param pageNo	Page number in the file
 	 * @param frameNo Frame number reference
-   * @throws HashNotFoundException if the page entry is not found in the hash table 
+   * @throws HashNotFoundException if the page entry is not found in the hash table
 	 */
   void lookup(const File* file, const PageId pageNo, FrameId &frameNo);
 
+	/**
+   * Check if (file, pageNo) is currently in the buffer pool (ie. in
+   * the hash table) without throwing if it is not.  Every buffer miss goes
+   * through here, so a miss must not cost an exception.
+	 *
+	 * @param file  	File object
+	 * @param pageNo	Page number in the file
+	 * @param frameNo Frame number reference, only set if the page is found
+	 * @return 				True if the page entry is in the hash table
+	 */
+  bool tryLookup(const File* file, const PageId pageNo, FrameId &frameNo) const;
+
 	/**
    * Delete entry (file,pageNo) from hash table.
 	 *
 	 * @param file   	File object
 	 * @param pageNo  Page number in the file
-   * @throws HashNotFoundException if the page entry is not found in the hash table 
+   * @throws HashNotFoundException if the page entry is not found in the hash table
+	 */
+  void remove(const File* file, const PageId pageNo);
+
+	/**
+	 * Makes the table hold at least the given number of entries without growing again.  If it has to grow, its
+	 * entries are moved incrementally by the following inserts and removes.
+	 *
+	 * @param entries Number of entries the table has to hold
 	 */
-  void remove(const File* file, const PageId pageNo);  
+  void reserve(const std::uint32_t entries);
 };
 
 }
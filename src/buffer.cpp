@@ -14,131 +14,635 @@
  *
  */
 
+#include <algorithm>
 #include <memory>
+#include <new>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
+#include "exceptions/invalid_page_exception.h"
 
 namespace badgerdb { 
 
-BufMgr::BufMgr(std::uint32_t bufs)
-	: numBufs(bufs) {
-	bufDescTable = new BufDesc[bufs];
+const std::uint32_t BufMgr::READ_AHEAD_MIN;
+const std::uint32_t BufMgr::OPTIMISTIC_ATTEMPTS;
 
-  for (FrameId i = 0; i < bufs; i++) 
+namespace {
+
+/**
+ * Frees a replacement policy retired through the EpochManager
+ */
+void deletePolicy(void* policy)
+{
+  delete static_cast<ReplacementPolicy*>(policy);
+}
+
+/**
+ * @brief Wakes the threads waiting for a frame of the shard.
+ */
+void wakeFrameWaiters(BufShard& shard)
+{
+  std::lock_guard<std::mutex> waitGuard(shard.waitLatch);
+  shard.frameReleases++;
+  shard.frameReleased.notify_all();
+}
+
+/**
+ * @brief Place of a request in the queue of threads waiting for a frame of a shard.
+ *
+ * Must only be used with the latch of the shard held, including when it is destroyed, which takes the request out
+ * of the queue and counts its waiting time.
+ */
+class FrameWait
+{
+ public:
+  FrameWait(BufShard& shard, const long long timeoutMicros)
+    : shard(shard), timeout(timeoutMicros), ticket(0), releases(0), queued(false)
+  {
+  }
+
+  ~FrameWait()
+  {
+    if (!queued)
+      return;
+    const bool first = shard.frameWaiters.front() == ticket;
+    shard.frameWaiters.erase(std::find(shard.frameWaiters.begin(), shard.frameWaiters.end(), ticket));
+    shard.frameWaiting.fetch_sub(1);
+    shard.stats.framewaitus += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    /// the next waiter may take a frame now
+    if (first && !shard.frameWaiters.empty())
+      wakeFrameWaiters(shard);
+  }
+
+	/**
+	 * Returns true if the request may take a frame: no other request waits ahead of it, or it does not wait at all.
+	 */
+  bool mayTake() const
+  {
+    if (queued)
+      return shard.frameWaiters.front() == ticket;
+    return timeout == 0 || shard.frameWaiters.empty();
+  }
+
+	/**
+	 * Waits until a frame may have become available.  The first call only queues the request, so that it tries
+	 * again once it is sure to be woken by any frame unpinned from then on.
+	 *
+	 * @param guard   Guard holding the latch of the shard, released while waiting
+	 * @return  False if waiting is off or the timeout has passed
+	 */
+  bool wait(std::unique_lock<std::mutex>& guard)
+  {
+    if (timeout == 0)
+      return false;
+    if (!queued)
+    {
+      queued = true;
+      ticket = shard.nextTicket++;
+      shard.frameWaiters.push_back(ticket);
+      shard.frameWaiting.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      start = std::chrono::steady_clock::now();
+      shard.stats.framewaits++;
+      std::lock_guard<std::mutex> waitGuard(shard.waitLatch);
+      releases = shard.frameReleases;
+      return true;
+    }
+    /// frames are released without the latch of the shard: only waitLatch makes sure that no release between
+    /// the last try and going to sleep is missed
+    std::unique_lock<std::mutex> waitGuard(shard.waitLatch);
+    std::cv_status status = std::cv_status::no_timeout;
+    if (shard.frameReleases == releases)
+    {
+      guard.unlock();
+      status = shard.frameReleased.wait_until(waitGuard, start + std::chrono::microseconds(timeout));
+    }
+    releases = shard.frameReleases;
+    waitGuard.unlock();
+    if (!guard.owns_lock())
+      guard.lock();
+    if (status == std::cv_status::timeout)
+    {
+      shard.stats.frametimeouts++;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  BufShard& shard;
+  const long long timeout;
+  std::uint64_t ticket;
+  std::uint64_t releases;
+  bool queued;
+  std::chrono::steady_clock::time_point start;
+};
+
+}
+
+BufMgr::BufMgr(std::uint32_t bufs, std::uint32_t shardCount, PolicyKind policy, ArenaPages pages, bool prefault,
+               std::uint32_t maxBufs)
+	: numBufs(bufs), maxBufs(std::max(bufs, maxBufs)), policyKind(policy),
+	  writerStop(true), writerCleanFrames(0), writerBatch(0), writerInterval(0),
+	  readAheadMax(0), prefetchStop(true), frameWaitMicros(0) {
+  /// frames and descriptors share one arena; the frames come first, so they start at a huge page boundary.
+  /// The pin counts, dirty and valid flags of the descriptors follow them in dense arrays.
+  /// Room is made for all frames the pool may grow to, and all their descriptors are constructed
+  const std::size_t poolBytes = (std::size_t) this->maxBufs * Page::SIZE;
+  const std::size_t descBytes = (std::size_t) this->maxBufs * sizeof(BufDesc);
+  const std::size_t pinBytes = (std::size_t) this->maxBufs * sizeof(std::atomic<int>);
+  const std::size_t dirtyBytes = (std::size_t) this->maxBufs * sizeof(std::atomic<bool>);
+  arena = new PageArena(poolBytes + descBytes + pinBytes + dirtyBytes + (std::size_t) this->maxBufs * sizeof(bool),
+                        pages, prefault);
+
+  /// frames are not constructed: the arena is zero-filled, and a page is always read or allocated into a frame
+  /// before the frame is used
+  char* memory = static_cast<char*>(arena->data());
+  bufPool = reinterpret_cast<Page*>(memory);
+	bufDescTable = reinterpret_cast<BufDesc*>(memory + poolBytes);
+  pinCounts = reinterpret_cast<std::atomic<int>*>(memory + poolBytes + descBytes);
+  dirtyFlags = reinterpret_cast<std::atomic<bool>*>(memory + poolBytes + descBytes + pinBytes);
+  validFlags = reinterpret_cast<bool*>(memory + poolBytes + descBytes + pinBytes + dirtyBytes);
+
+  for (FrameId i = 0; i < this->maxBufs; i++) 
   {
+    new (&pinCounts[i]) std::atomic<int>(0);
+    new (&dirtyFlags[i]) std::atomic<bool>(false);
+    new (&bufDescTable[i]) BufDesc(pinCounts[i], dirtyFlags[i], validFlags[i]);
   	bufDescTable[i].frameNo = i;
   	bufDescTable[i].valid = false;
   }
 
-  bufPool = new Page[bufs];
+  /// every shard needs at least one frame
+  numShards = shardCount;
+  if (numShards > bufs)
+    numShards = bufs;
+  if (numShards == 0)
+    numShards = 1;
+  shards = new BufShard[numShards];
+
+  /// reserve contiguous ranges of frames, the first (maxBufs % numShards) shards get one extra frame; every
+  /// shard uses the first frames of its range, likewise its share of bufs
+  FrameId first = 0;
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    BufShard& shard = shards[s];
+    shard.firstFrame = first;
+    shard.maxFrames = this->maxBufs / numShards + (s < this->maxBufs % numShards ? 1 : 0);
+    shard.numFrames = bufs / numShards + (s < bufs % numShards ? 1 : 0);
+    first += shard.maxFrames;
 
-	int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
-  hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
+    /// a concurrent buffer manager looks up resident pages without latching the shard
+    shard.hashTable = NULL;
+    shard.pageTable = NULL;
+    if (numShards > 1)
+      shard.pageTable = new PageTable(shard.numFrames);
+    else
+      shard.hashTable = new BufHashTbl (shard.numFrames);  // allocate the buffer hash table of the shard
 
-  clockHand = bufs - 1;
+    shard.policy = ReplacementPolicy::create(policy, shard.firstFrame, shard.numFrames, pinCounts);
+    shard.latchFree = shard.policy.load()->isLatchFree();
+    shard.nextTicket = 0;
+    shard.frameWaiting = 0;
+    shard.frameReleases = 0;
+  }
 }
 
 
 BufMgr::~BufMgr() {
+  stopReadAhead();
+  stopBackgroundWriter();
+
   /// Flush out all dirty pages to disk, remove all page entries from hashTable
   /// (do not need to clear bufPool entry, if no page entry in hashTable)
   /// and deallocate buffer pool and bufDesc table array object.
-  for (FrameId i = 0; i < this->numBufs; i++)
+  std::vector<FrameId> dirtyFrames;
+  for (FrameId i = 0; i < this->maxBufs; i++)
   { 
     if (this->bufDescTable[i].dirty)
     {
       if (File::isOpen(this->bufDescTable[i].file->filename())) 
-      {
-        this->bufDescTable[i].file->writePage(this->bufPool[i]);
-        this->bufDescTable[i].dirty = false;  
-      }
-      
+        dirtyFrames.push_back(i);
     }
   }
-  delete[] bufDescTable;
-  delete[] bufPool; 
+  /// a destructor must not throw: report the error, like File::close(), and free everything anyway
+  try
+  {
+    writeBack(dirtyFrames);
+  }
+  catch (const BadgerDbException& e)
+  {
+    std::cerr << e.message() << std::endl;
+  }
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    delete shards[s].hashTable;
+    delete shards[s].pageTable;
+    delete shards[s].policy.load();
+  }
+  delete[] shards;
+  for (FrameId i = 0; i < this->maxBufs; i++)
+    bufDescTable[i].~BufDesc();
+  delete arena;
+  arena = NULL;
+  shards = NULL;
   bufDescTable = NULL;
+  pinCounts = NULL;
+  dirtyFlags = NULL;
+  validFlags = NULL;
   bufPool = NULL;
 }
 
-void BufMgr::advanceClock()
+BufShard& BufMgr::shardFor(const File* file, const PageId pageNo)
 {
-  /**
-   * Increment clockHand if it is less than the highest buffer page index.
-   * If equal to the highest buffer frame index, set clockHand to 0.
-   */
-  if (this->clockHand < numBufs - 1) 
-	  this->clockHand++;
-  else if (this->clockHand == numBufs - 1)
-	  this->clockHand = 0;
+  if (numShards == 1)
+    return shards[0];
+  /// consecutive pages of a file are spread over all shards; the high bits of the hash pick the shard,
+  /// since the tables index their buckets with the low bits
+  return shards[(BufHashTbl::hash(file, pageNo) >> 32) % numShards];
 }
 
-void BufMgr::allocBuf(FrameId & frame) 
+bool BufMgr::lookupFrame(BufShard& shard, const File* file, const PageId pageNo, FrameId& frameNo)
+{
+  if (shard.pageTable)
+    return shard.pageTable->lookup(file, pageNo, frameNo);
+  return shard.hashTable->tryLookup(file, pageNo, frameNo);
+}
+
+bool BufMgr::lookupActive(BufShard& shard, std::unique_lock<std::mutex>& guard, const File* file,
+                          const PageId pageNo, FrameId& frameNo)
+{
+  while (lookupFrame(shard, file, pageNo, frameNo))
+  {
+    if (!removing(shard, frameNo))
+      return true;
+    /// resize() notifies once it evicted pages of frames it takes away
+    shard.frameFreed.wait(guard);
+  }
+  return false;
+}
+
+bool BufMgr::pinResident(BufShard& shard, const File* file, const PageId pageNo, FrameId& frameNo)
+{
+  if (!shard.pageTable || !shard.pageTable->lookup(file, pageNo, frameNo))
+    return false;
+  /// the table entry may be stale by now: pin the frame so that it cannot be reassigned,
+  /// then make sure it still holds the page
+  BufDesc& desc = bufDescTable[frameNo];
+  if (!desc.TryPin())
+    return false;
+  if (!desc.valid || desc.file != file || desc.pageNo != pageNo || removing(shard, frameNo))
+  {
+    desc.pinCnt.fetch_sub(1, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+void BufMgr::insertFrame(BufShard& shard, const File* file, const PageId pageNo, const FrameId frameNo)
+{
+  if (shard.pageTable)
+    shard.pageTable->insert(file, pageNo, frameNo);
+  else
+    shard.hashTable->insert(file, pageNo, frameNo);
+
+  /// link the frame in front of the list of its file
+  std::pair<std::unordered_map<const File*, FrameId>::iterator, bool> head =
+    shard.fileFrames.insert(std::make_pair(file, frameNo));
+  BufDesc& desc = bufDescTable[frameNo];
+  desc.filePrev = BufDesc::NO_FRAME;
+  desc.fileNext = BufDesc::NO_FRAME;
+  if (!head.second)
+  {
+    desc.fileNext = head.first->second;
+    bufDescTable[head.first->second].filePrev = frameNo;
+    head.first->second = frameNo;
+  }
+}
+
+void BufMgr::removeFrame(BufShard& shard, const File* file, const PageId pageNo, const FrameId frameNo)
+{
+  if (shard.pageTable)
+    shard.pageTable->remove(file, pageNo);
+  else
+    shard.hashTable->remove(file, pageNo);
+
+  BufDesc& desc = bufDescTable[frameNo];
+  if (desc.filePrev != BufDesc::NO_FRAME)
+    bufDescTable[desc.filePrev].fileNext = desc.fileNext;
+  else if (desc.fileNext != BufDesc::NO_FRAME)
+    shard.fileFrames[file] = desc.fileNext;
+  else
+    shard.fileFrames.erase(file);
+  if (desc.fileNext != BufDesc::NO_FRAME)
+    bufDescTable[desc.fileNext].filePrev = desc.filePrev;
+  desc.fileNext = BufDesc::NO_FRAME;
+  desc.filePrev = BufDesc::NO_FRAME;
+}
+
+void BufMgr::framesOfFile(const BufShard& shard, const File* file, std::vector<FrameId>& frames) const
+{
+  std::unordered_map<const File*, FrameId>::const_iterator head = shard.fileFrames.find(file);
+  if (head == shard.fileFrames.end())
+    return;
+  for (FrameId f = head->second; f != BufDesc::NO_FRAME; f = bufDescTable[f].fileNext)
+    frames.push_back(f);
+}
+
+bool BufMgr::allocBuf(BufShard& shard, FrameId & frame) 
 {
-    int flag = 0;
-    std::uint32_t  pinned = 0;
     /**
-     * Loop through the frames till a unpinned frame is found 
-     * or no unpinned frame exists (throw BufferExceededException)
+     * Let the policy of the shard choose a free frame or a victim,
+     * or find that all frames are pinned (return false).
+     * Frames are locked before they are taken, so that no lock-free reader can pin them meanwhile.
      */
-    while(pinned < this->numBufs)
-    {
-      BufMgr::advanceClock();  //Advance the clock
-      /// if frame is valid and
-      ///   if refbit set, unset refbit and continue
-      ///   else if frame pinned, continue
-      ///   else if frame dirty, flush the page and unset the dirty flag
-      /// else
+    BufDesc* descs = this->bufDescTable;
+    if (!shard.policy.load()->pickVictim([descs](FrameId f) { return descs[f].TryLock(); }, frame))
+      return false;
 
-      if(bufDescTable[frame].valid)
-      {
-        if (bufDescTable[frame].refbit)
-        {
-          bufDescTable[frame].refbit = false;
-          continue;
-        }
-        else if (bufDescTable[frame].pinCnt > 0)
+    if (bufDescTable[frame].valid)
+      evictFrame(shard, frame);
+    return true;
+}
+
+void BufMgr::evictFrame(BufShard& shard, const FrameId frame)
+{
+    dropPage(shard, frame);
+    shard.policy.load()->onEvict(frame);
+}
+
+void BufMgr::dropPage(BufShard& shard, const FrameId frame)
+{
+    /// flush the page if it is dirty and unset the dirty flag,
+    /// and remove the page from the hashTable
+    if (this->bufDescTable[frame].dirty) //Check if the dirty bit is set 
+    {
+        /// if yes, write the page in desc, along with its dirty neighbours in the file
+        std::vector<FrameId> cluster(1, frame);
+        clusterDirty(shard, frame, cluster);
+        try
         {
-          pinned++;
-          continue;
+          writeBack(cluster);
         }
-        else if (this->bufDescTable[frame].dirty) //Check if the dirty bit is set 
+        catch (...)
         {
-            this->bufDescTable[frame].file->writePage(bufPool[frame]); //If yes, write the page in desc
-            this->bufDescTable[frame].dirty = false;
+          unlockCluster(cluster, frame);
+          throw;
         }
-        // remove the page from the hashTable
-        this->hashTable->remove(this->bufDescTable[frame].file, this->bufDescTable[frame].pageNo);
-        this->bufDescTable[frame].Clear();
+        unlockCluster(cluster, frame);
+        shard.stats.evictwrites += cluster.size();
+        writerWake.notify_one();  // the background writer, if any, fell behind
+    }
+    if (this->bufDescTable[frame].prefetched)
+    {
+      /// read ahead, but nobody asked for it
+      shard.stats.prefetchwaste++;
+      adjustReadAhead(this->bufDescTable[frame].file, false);
+    }
+    removeFrame(shard, this->bufDescTable[frame].file, this->bufDescTable[frame].pageNo, frame);
+    this->bufDescTable[frame].valid = false;
+}
+
+void BufMgr::clusterDirty(BufShard& shard, const FrameId frame, std::vector<FrameId>& cluster)
+{
+  const File* file = bufDescTable[frame].file;
+  const PageId pageNo = bufDescTable[frame].pageNo;
+  for (int step = -1; step <= 1; step += 2)
+  {
+    for (PageId p = pageNo + step; cluster.size() < WRITE_CLUSTER && p != 0 && p != Page::INVALID_NUMBER; p += step)
+    {
+      /// the table of another shard can only be searched without its latch if it is lock-free
+      BufShard& other = shardFor(file, p);
+      FrameId f;
+      if ((&other != &shard && !other.pageTable) || !lookupFrame(other, file, p, f))
+        break;
+      /// like the background writer, lock the frame before writing its page; its entry may be stale by now
+      BufDesc& desc = bufDescTable[f];
+      if (!desc.dirty || !desc.TryLock())
+        break;
+      if (!desc.valid || desc.file != file || desc.pageNo != p || !desc.dirty)
+      {
+        desc.Unlock();
+        break;
       }
-      flag = 1;
-      break;
+      cluster.push_back(f);
+    }
+  }
+}
+
+void BufMgr::unlockCluster(const std::vector<FrameId>& cluster, const FrameId frame)
+{
+  std::vector<BufShard*> released;
+  for (std::size_t i = 0; i < cluster.size(); i++)
+  {
+    if (cluster[i] == frame)
+      continue;
+    BufDesc& desc = bufDescTable[cluster[i]];
+    BufShard* shard = &shardFor(desc.file, desc.pageNo);
+    desc.Unlock();
+    if (std::find(released.begin(), released.end(), shard) == released.end())
+      released.push_back(shard);
+  }
+  /// requests of any of these shards may have found every other frame pinned while the cluster was written
+  for (std::size_t i = 0; i < released.size(); i++)
+    notifyFrameWaiters(*released[i]);
+}
+
+void BufMgr::writeBack(std::vector<FrameId>& frames)
+{
+  BufDesc* descs = this->bufDescTable;
+  std::sort(frames.begin(), frames.end(), [descs](FrameId a, FrameId b)
+  {
+    if (descs[a].file != descs[b].file)
+      return std::less<File*>()(descs[a].file, descs[b].file);
+    return descs[a].pageNo < descs[b].pageNo;
+  });
+  std::vector<const Page*> pages;
+  for (std::size_t first = 0; first < frames.size();)
+  {
+    File* file = descs[frames[first]].file;
+    std::size_t end = first;
+    pages.clear();
+    for (; end < frames.size() && descs[frames[end]].file == file; end++)
+      pages.push_back(&bufPool[frames[end]]);
+    file->writePages(pages.data(), pages.size());
+    for (std::size_t i = first; i < end; i++)
+    {
+      descs[frames[i]].dirty = false;
+      shardFor(file, descs[frames[i]].pageNo).stats.diskwrites++;
+    }
+    first = end;
+  }
+}
+
+bool BufMgr::allocRingBuf(BufShard& shard, ScanRing& ring, FrameId& frame)
+{
+  /// the ring holds up to its share of frames of every shard; once it has them,
+  /// the oldest one of this shard is reused
+  std::uint32_t share = std::max(ring.size / numShards, (std::uint32_t) 1);
+  std::uint32_t held = 0;
+  std::size_t oldest = ring.slots.size();
+  for (std::size_t i = 0; i < ring.slots.size(); i++)
+  {
+    if (ring.slots[i].shard != &shard)
+      continue;
+    if (held++ == 0)
+      oldest = i;
+  }
+  if (held >= share)
+  {
+    FrameId reused = ring.slots[oldest].frame;
+    ring.slots.erase(ring.slots.begin() + oldest);
+    BufDesc& desc = bufDescTable[reused];
+    /// a frame that is pinned, or whose page has been requested without the ring, leaves the ring, and so does
+    /// a frame resize() took away
+    if (!removing(shard, reused) && desc.TryLock())
+    {
+      if (!desc.valid || desc.inRing)
+      {
+        if (desc.valid)
+          evictFrame(shard, reused);
+        frame = reused;
+        ring.slots.push_back(ScanRing::Slot(&shard, frame));
+        return true;
+      }
+      desc.Unlock();
     }
-    if (!flag)
-        throw BufferExceededException();
+  }
+
+  if (!this->allocBuf(shard, frame))
+    return false;
+  ring.slots.push_back(ScanRing::Slot(&shard, frame));
+  return true;
 }
 	
-void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+void BufMgr::readPage(File* file, const PageId pageNo, Page*& page, ScanRing* ring)
+{
+  switch (tryReadPage(file, pageNo, page, ring))
+  {
+    case PageStatus::INVALID_PAGE:
+      throw InvalidPageException(pageNo, file->filename());
+    case PageStatus::BUFFER_EXCEEDED:
+      throw BufferExceededException();
+    default:
+      break;
+  }
+}
+
+PageStatus BufMgr::tryReadPage(File* file, const PageId pageNo, Page*& page, ScanRing* ring)
+{
+  BufShard* shard;
+  FrameId frameNo;
+  PageStatus status = pinFrame(file, pageNo, ring, shard, frameNo);
+  if (status == PageStatus::HIT || status == PageStatus::MISS)
+    page = &bufPool[frameNo];
+  return status;
+}
+
+PageHandle BufMgr::readPage(File* file, const PageId pageNo, ScanRing* ring)
+{
+  BufShard* shard;
+  FrameId frameNo;
+  switch (pinFrame(file, pageNo, ring, shard, frameNo))
+  {
+    case PageStatus::INVALID_PAGE:
+      throw InvalidPageException(pageNo, file->filename());
+    case PageStatus::BUFFER_EXCEEDED:
+      throw BufferExceededException();
+    default:
+      return PageHandle(this, shard, frameNo);
+  }
+}
+
+bool BufMgr::readOptimistic(File* file, const PageId pageNo, const std::function<void(const Page&)>& read)
+{
+  BufShard& shard = shardFor(file, pageNo);
+  FrameId frameNo;
+  for (std::uint32_t attempt = 0; attempt < OPTIMISTIC_ATTEMPTS; attempt++)
+  {
+    if (!shard.pageTable || !shard.pageTable->lookup(file, pageNo, frameNo))
+      break;
+    /// the frame may be given to another page at any time: check it after taking the version, which changes
+    /// whenever the frame is locked
+    const BufDesc& desc = bufDescTable[frameNo];
+    const std::uint64_t version = desc.latch.version();
+    if (!desc.valid || desc.file != file || desc.pageNo != pageNo || !desc.latch.validate(version))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    try
+    {
+      read(bufPool[frameNo]);
+    }
+    catch (...)
+    {
+      if (desc.latch.validate(version))
+        throw;
+      continue;
+    }
+    if (desc.latch.validate(version))
+      return true;
+  }
+
+  PageHandle handle = readPage(file, pageNo);
+  handle.lockShared();
+  read(*handle);
+  return false;
+}
+
+PageStatus BufMgr::pinFrame(File* file, const PageId pageNo, ScanRing* ring, BufShard*& shardOf, FrameId& frameNo)
 {
-    FrameId frameNo = 69; 
-    try 
+    if (readAheadMax.load(std::memory_order_relaxed) != 0)
+      noteAccess(file, pageNo);
+    BufShard& shard = shardFor(file, pageNo);
+    shardOf = &shard;
+    shard.stats.accesses.fetch_add(1, std::memory_order_relaxed);
+    if (shard.latchFree && pinResident(shard, file, pageNo, frameNo))
+    {
+      /// hit in a concurrent buffer manager, found and pinned without the latch
+      noteHit(shard, frameNo, ring);
+      return PageStatus::HIT;
+    }
+
+    std::unique_lock<std::mutex> guard(shard.latch);
+    bool resident = lookupActive(shard, guard, file, pageNo, frameNo);
+    if (!resident)
+    {
+      shard.policy.load()->onMiss(file, pageNo);
+      /// allocate the buffer frame chosen by the replacement policy for the page, or one of the ring; if all are
+      /// pinned, wait for one and look the page up again, since another thread may have read it meanwhile
+      FrameWait wait(shard, frameWaitMicros.load(std::memory_order_relaxed));
+      while (!wait.mayTake() || !(ring ? allocRingBuf(shard, *ring, frameNo) : this->allocBuf(shard, frameNo)))
+      {
+        if (!wait.wait(guard))
+          return PageStatus::BUFFER_EXCEEDED;
+        if ((resident = lookupActive(shard, guard, file, pageNo, frameNo)))
+          break;
+      }
+    }
+
+    if (resident)
     {
       /**
        * Case 2: Page is in the buffer pool.
-     	 * Update the refbit and increment the pin count
+     	 * Increment the pin count and tell the replacement policy about the hit
     	 * return a pointer to the buffer frame that references the page
     	 */
-    	hashTable->lookup(file, pageNo, frameNo); // Look for the page in the pool
-     	bufDescTable[frameNo].refbit = true;
-    	bufDescTable[frameNo].pinCnt++;
-    	page = &bufPool[frameNo];	 
+    	/// the background writer may have locked the frame while it writes the page out
+    	while (!bufDescTable[frameNo].TryPin())
+    	  std::this_thread::yield();
+      noteHit(shard, frameNo, ring);
+      return PageStatus::HIT;
     } 
-    catch (HashNotFoundException& e) 
+    else
     {
       /**
        * Case 1: Page is NOT in the buffer pool.
@@ -148,118 +652,503 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
        * and call Set() to set the page. 
        * Reference argument page will return a pointer to the frame where the page is pinned
        */
-    	this->allocBuf(this->clockHand); // allocate the buffer frame pointed to by clockHand for the page
-    	Page temp = file->readPage(pageNo); // read the page in from memory
-      this->bufPool[this->clockHand] = temp; // set the page in the buffer pool
-    	this->hashTable->insert(file, pageNo, this->clockHand); // place the page into the buffer frame	
-    	this->bufDescTable[this->clockHand].Set(file, pageNo); // call to set the BufDesc properly	
-      page = &(this->bufPool[this->clockHand]);
+      /// read the page straight into the frame, which nobody else can see while it is locked
+      if (!file->tryReadPage(pageNo, this->bufPool[frameNo]))
+      {
+        this->bufDescTable[frameNo].Clear(); // give the locked frame back
+        return PageStatus::INVALID_PAGE;
+      }
+      shard.stats.diskreads++;
+    	insertFrame(shard, file, pageNo, frameNo); // place the page into the buffer frame	
+    	this->bufDescTable[frameNo].Set(file, pageNo); // call to set the BufDesc properly	
+      if (ring)
+      {
+        /// pages of a scan are evicted first, unless somebody else requests them
+        this->bufDescTable[frameNo].inRing = true;
+        shard.policy.load()->onLoadCold(frameNo, file, pageNo);
+      }
+      else
+        shard.policy.load()->onLoad(frameNo, file, pageNo);
+      shard.policy.load()->onPin(frameNo);
+      return PageStatus::MISS;
     }
 }
 
 void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) 
 {
-  /// if frame containing page (file, pageNo) is pinned, throw exception,
-  /// else decrement pinCnt of the frame 
-  /// and set the dirty flag is the provided argument, dirty, is true
+  /// (the pin held by the caller keeps the frame from being reassigned,
+  /// so a concurrent buffer manager does not need the latch here
+  /// unless its replacement policy does)
+  BufShard& shard = shardFor(file, pageNo);
+  std::unique_lock<std::mutex> guard(shard.latch, std::defer_lock);
+  if (!shard.pageTable || !shard.latchFree)
+    guard.lock();
   FrameId frameNo;
-  try
+  if (!unPinFrame(shard, file, pageNo, dirty, frameNo))
+    throw PageNotPinnedException(file->filename(), pageNo, frameNo);
+  notifyFrameWaiters(shard);
+}
+
+void BufMgr::unPinPages(File* file, const PageId* pageNos, const std::uint32_t count, const bool dirty)
+{
+  /// visit the pages shard by shard, so that each latch is taken once
+  std::vector<std::uint32_t> order;
+  std::vector<BufShard*> shardOf;
+  groupByShard(file, pageNos, count, order, shardOf);
+
+  bool failed = false;
+  PageId failedPage = Page::INVALID_NUMBER;
+  FrameId failedFrame = 0;
+  for (std::uint32_t begin = 0, end = 0; begin < count; begin = end)
   {
-    this->hashTable->lookup(file, pageNo, frameNo);
-    if (this->bufDescTable[frameNo].pinCnt == 0)
+    BufShard& shard = *shardOf[order[begin]];
+    for (end = begin; end < count && shardOf[order[end]] == &shard; end++)
+      ;
+    std::unique_lock<std::mutex> guard(shard.latch, std::defer_lock);
+    if (!shard.pageTable || !shard.latchFree)
+      guard.lock();
+    for (std::uint32_t k = begin; k < end; k++)
     {
-      throw PageNotPinnedException(file->filename(), pageNo, frameNo);
+      FrameId frameNo;
+      if (!unPinFrame(shard, file, pageNos[order[k]], dirty, frameNo) && !failed)
+      {
+        failed = true;
+        failedPage = pageNos[order[k]];
+        failedFrame = frameNo;
+      }
     }
-    this->bufDescTable[frameNo].pinCnt--;
-    if (dirty == true)
-      this->bufDescTable[frameNo].dirty = true;
+    notifyFrameWaiters(shard);
   }
-  catch (HashNotFoundException& e)
+  if (failed)
+    throw PageNotPinnedException(file->filename(), failedPage, failedFrame);
+}
+
+bool BufMgr::unPinFrame(BufShard& shard, File* file, const PageId pageNo, const bool dirty, FrameId& frameNo)
+{
+  /// if frame containing page (file, pageNo) is pinned, fail,
+  /// else decrement pinCnt of the frame 
+  /// and set the dirty flag is the provided argument, dirty, is true
+  if (!lookupFrame(shard, file, pageNo, frameNo))
   {
     /**
      * do nothing
      */
+    return true;
+  }
+  return releasePin(shard, frameNo, dirty);
+}
+
+bool BufMgr::releasePin(BufShard& shard, const FrameId frameNo, const bool dirty)
+{
+  BufDesc& desc = this->bufDescTable[frameNo];
+  int pins = desc.pinCnt.load();
+  if (pins <= 0)
+    return false;
+  /// mark the page dirty before giving up the pin, so that whoever evicts it sees the flag
+  if (dirty == true)
+    desc.dirty = true;
+  while (!desc.pinCnt.compare_exchange_weak(pins, pins - 1, std::memory_order_release))
+  {
+    if (pins <= 0)
+      return false;
+  }
+  EpochGuard epoch;
+  shard.policy.load()->onUnpin(frameNo, pins == 1);
+  return true;
+}
+
+bool BufMgr::unPinHandle(BufShard& shard, const FrameId frameNo)
+{
+  std::unique_lock<std::mutex> guard(shard.latch, std::defer_lock);
+  if (!shard.pageTable || !shard.latchFree)
+    guard.lock();
+  if (!releasePin(shard, frameNo, false))
+    return false;
+  notifyFrameWaiters(shard);
+  return true;
+}
+
+void BufMgr::notifyFrameWaiters(BufShard& shard)
+{
+  /// pairs with the fence of a waiter between queueing up and trying to take a frame: either it sees the frame
+  /// that was just released, or this sees it waiting
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (shard.frameWaiting.load(std::memory_order_relaxed) == 0)
+    return;
+  wakeFrameWaiters(shard);
+}
+
+void BufMgr::groupByShard(const File* file, const PageId* pageNos, const std::uint32_t count,
+                          std::vector<std::uint32_t>& order, std::vector<BufShard*>& shardOf)
+{
+  shardOf.resize(count);
+  order.resize(count);
+  for (std::uint32_t i = 0; i < count; i++)
+  {
+    shardOf[i] = &shardFor(file, pageNos[i]);
+    order[i] = i;
+  }
+  if (numShards > 1)
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+      return shardOf[a] != shardOf[b] ? shardOf[a] < shardOf[b] : a < b;
+    });
+}
+
+void BufMgr::readPages(File* file, const PageId* pageNos, const std::uint32_t count, Page** pages)
+{
+  std::vector<PageStatus> statuses(count);
+  tryReadPages(file, pageNos, count, pages, statuses.data());
+  for (std::uint32_t i = 0; i < count; i++)
+  {
+    if (statuses[i] != PageStatus::INVALID_PAGE && statuses[i] != PageStatus::BUFFER_EXCEEDED)
+      continue;
+    /// all or nothing: give back the pages that were read
+    for (std::uint32_t j = 0; j < count; j++)
+    {
+      if (pages[j])
+      {
+        unPinPage(file, pageNos[j], false);
+        pages[j] = NULL;
+      }
+    }
+    if (statuses[i] == PageStatus::INVALID_PAGE)
+      throw InvalidPageException(pageNos[i], file->filename());
+    throw BufferExceededException();
+  }
+}
+
+void BufMgr::tryReadPages(File* file, const PageId* pageNos, const std::uint32_t count, Page** pages,
+                          PageStatus* statuses)
+{
+  /// visit the pages shard by shard
+  std::vector<std::uint32_t> order;
+  std::vector<BufShard*> shardOf;
+  groupByShard(file, pageNos, count, order, shardOf);
+  for (std::uint32_t i = 0; i < count; i++)
+    pages[i] = NULL;
+
+  std::vector<std::uint32_t> misses;
+  for (std::uint32_t begin = 0, end = 0; begin < count; begin = end)
+  {
+    BufShard& shard = *shardOf[order[begin]];
+    for (end = begin; end < count && shardOf[order[end]] == &shard; end++)
+      ;
+    shard.stats.accesses.fetch_add(end - begin, std::memory_order_relaxed);
+
+    /// hits in a concurrent buffer manager are pinned without the latch
+    if (shard.latchFree)
+    {
+      for (std::uint32_t k = begin; k < end; k++)
+      {
+        std::uint32_t i = order[k];
+        FrameId frameNo;
+        if (pinResident(shard, file, pageNos[i], frameNo))
+        {
+          noteHit(shard, frameNo, NULL);
+          pages[i] = &bufPool[frameNo];
+          statuses[i] = PageStatus::HIT;
+        }
+      }
+    }
+
+    std::unique_lock<std::mutex> guard(shard.latch);
+    misses.clear();
+    for (std::uint32_t k = begin; k < end; k++)
+    {
+      std::uint32_t i = order[k];
+      FrameId frameNo;
+      if (pages[i])
+        continue;
+      if (!lookupActive(shard, guard, file, pageNos[i], frameNo))
+      {
+        misses.push_back(i);
+        continue;
+      }
+      /// the background writer may have locked the frame while it writes the page out
+      while (!bufDescTable[frameNo].TryPin())
+        std::this_thread::yield();
+      noteHit(shard, frameNo, NULL);
+      pages[i] = &bufPool[frameNo];
+      statuses[i] = PageStatus::HIT;
+    }
+    if (misses.empty())
+      continue;
+    std::sort(misses.begin(), misses.end(), [&](std::uint32_t a, std::uint32_t b) {
+      return pageNos[a] != pageNos[b] ? pageNos[a] < pageNos[b] : a < b;
+    });
+    readMisses(shard, file, pageNos, misses, pages, statuses);
+  }
+}
+
+void BufMgr::readMisses(BufShard& shard, File* file, const PageId* pageNos, const std::vector<std::uint32_t>& misses,
+                        Page** pages, PageStatus* statuses)
+{
+  /// take a frame for every distinct page first; a page requested more than once shares the frame
+  /// of its first request, which comes right before it
+  std::vector<FrameId> frames(misses.size());
+  std::size_t allocated = 0;
+  for (; allocated < misses.size(); allocated++)
+  {
+    PageId pageNo = pageNos[misses[allocated]];
+    if (allocated > 0 && pageNos[misses[allocated - 1]] == pageNo)
+    {
+      frames[allocated] = frames[allocated - 1];
+      continue;
+    }
+    shard.policy.load()->onMiss(file, pageNo);
+    if (!this->allocBuf(shard, frames[allocated]))
+      break;
+  }
+  for (std::size_t m = allocated; m < misses.size(); m++)
+    statuses[misses[m]] = PageStatus::BUFFER_EXCEEDED;
+
+  /// then read the distinct pages straight into the locked frames, each run of consecutive pages with a single
+  /// request and all runs at once
+  std::vector<PageId> distinct;
+  std::vector<Page*> targets;
+  std::vector<std::size_t> firstMisses;
+  for (std::size_t m = 0; m < allocated; m++)
+  {
+    if (m > 0 && pageNos[misses[m - 1]] == pageNos[misses[m]])
+      continue;
+    distinct.push_back(pageNos[misses[m]]);
+    targets.push_back(&bufPool[frames[m]]);
+    firstMisses.push_back(m);
+  }
+  std::unique_ptr<bool[]> found(new bool[distinct.size() + 1]);
+  file->tryReadPages(distinct.data(), distinct.size(), targets.data(), found.get());
+
+  for (std::size_t j = 0; j < firstMisses.size(); j++)
+  {
+    std::size_t firstMiss = firstMisses[j];
+    std::size_t lastMiss = j + 1 < firstMisses.size() ? firstMisses[j + 1] : allocated;
+    FrameId frameNo = frames[firstMiss];
+    PageId pageNo = distinct[j];
+    if (!found[j])
+    {
+      this->bufDescTable[frameNo].Clear(); // give the locked frame back
+      for (std::size_t d = firstMiss; d < lastMiss; d++)
+        statuses[misses[d]] = PageStatus::INVALID_PAGE;
+      continue;
+    }
+    shard.stats.diskreads++;
+    insertFrame(shard, file, pageNo, frameNo);
+    this->bufDescTable[frameNo].Set(file, pageNo);
+    shard.policy.load()->onLoad(frameNo, file, pageNo);
+    shard.policy.load()->onPin(frameNo);
+    pages[misses[firstMiss]] = &bufPool[frameNo];
+    statuses[misses[firstMiss]] = PageStatus::MISS;
+    /// further requests for the same page pin it again
+    for (std::size_t d = firstMiss + 1; d < lastMiss; d++)
+    {
+      this->bufDescTable[frameNo].pinCnt++;
+      shard.policy.load()->onHit(frameNo);
+      shard.policy.load()->onPin(frameNo);
+      pages[misses[d]] = &bufPool[frameNo];
+      statuses[misses[d]] = PageStatus::HIT;
+    }
   }
 }
 
 void BufMgr::flushFile(const File* file) 
 {
-  /**
-   * scan bufDesc Table for pages belonging to file
-   * and check for existence of pinned and invalid pages belonging to the file
-   */
-  for (FrameId i = 0; i < this->numBufs-1; i++)
+  /// drop the pages of the file waiting to be read ahead, and wait for a read ahead in flight
   {
-    if (bufDescTable[i].file == file)
+    std::lock_guard<std::mutex> queueGuard(prefetchQueueLatch);
+    for (std::deque<std::pair<File*, PageId> >::iterator it = prefetchQueue.begin(); it != prefetchQueue.end();)
     {
-      /// for the found page of the given file,
-      /// check if it is pinned or invalid and throw corresponding exception, if it is
-      if (bufDescTable[i].pinCnt > 0)
-        throw PagePinnedException(file->filename(), bufDescTable[i].pageNo, i);
-      if (bufDescTable[i].valid == false)
-        throw BadBufferException(i, bufDescTable[i].dirty, bufDescTable[i].valid, bufDescTable[i].refbit);
+      if (it->first == file)
+        it = prefetchQueue.erase(it);
+      else
+        ++it;
     }
+    std::lock_guard<std::mutex> busyGuard(prefetchLatch);
   }
+  {
+    std::lock_guard<std::mutex> readAheadGuard(readAheadLatch);
+    readAheadStates.erase(file->id());
+  }
+
+  /// hold the latches of all shards, always taken in shard order,
+  /// so that no page of the file can be read in meanwhile,
+  /// and keep the background writer from locking frames meanwhile
+  std::lock_guard<std::mutex> writerGuard(writerLatch);
+  std::vector<std::unique_lock<std::mutex> > guards;
+  for (std::uint32_t s = 0; s < numShards; s++)
+    guards.push_back(std::unique_lock<std::mutex>(shards[s].latch));
+
+  /// only the frames holding pages of the file are looked at
+  std::vector<FrameId> frames;
+  for (std::uint32_t s = 0; s < numShards; s++)
+    framesOfFile(shards[s], file, frames);
+
   /**
-   * scan bufDesc Table again for the pages belonging to the file
-   * if page is dirty, flush to disk and unset dirty flag
-   * remove the page entry from hashTable and clear frame description
+   * lock every frame of the file, so that no lock-free reader can pin it any more,
+   * and check for pinned and invalid pages belonging to the file;
+   * if there is one, unlock the frames again and throw the corresponding exception
    */
-  for (FrameId i = 0; i < this->numBufs-1; i++)
+  for (std::size_t i = 0; i < frames.size(); i++)
   {
-    if (bufDescTable[i].file == file)
+    BufDesc& desc = bufDescTable[frames[i]];
+    if (!desc.valid || !desc.TryLock())
     {
-      /// if the page is not pinned or invalid,
-      /// flush page to disk, if page is dirty
-      if (bufDescTable[i].dirty)
-      {
-        bufDescTable[i].file->writePage(this->bufPool[i]);
-        bufDescTable[i].dirty = false;
-      }
-      /// remove page entry from hashTable
-      /// (do not need to clear bufPool entry, if no page entry in hashTable)
-      /// and clear description for the page buf frame
-      this->hashTable->remove(file, bufDescTable[i].pageNo);
-      this->bufDescTable[i].Clear();
+      for (std::size_t j = 0; j < i; j++)
+        bufDescTable[frames[j]].Unlock();
+      if (!desc.valid)
+        throw BadBufferException(frames[i], desc.dirty, desc.valid, false);  // reference state is kept by the policy
+      throw PagePinnedException(file->filename(), desc.pageNo, frames[i]);
     }
   }
+
+  /**
+   * flush the dirty pages to disk in the order of their page numbers, consecutive pages with one write,
+   * and unset their dirty flag
+   */
+  std::vector<FrameId> dirtyFrames;
+  for (std::size_t i = 0; i < frames.size(); i++)
+  {
+    if (bufDescTable[frames[i]].dirty)
+      dirtyFrames.push_back(frames[i]);
+  }
+  try
+  {
+    writeBack(dirtyFrames);
+  }
+  catch (...)
+  {
+    for (std::size_t i = 0; i < frames.size(); i++)
+      bufDescTable[frames[i]].Unlock();
+    throw;
+  }
+
+  /// remove the page entries from hashTable and clear the frame descriptions
+  std::vector<BufShard*> released;
+  for (std::size_t i = 0; i < frames.size(); i++)
+  {
+    FrameId frameNo = frames[i];
+    BufDesc& desc = bufDescTable[frameNo];
+    BufShard& shard = shardFor(file, desc.pageNo);
+    /// (do not need to clear bufPool entry, if no page entry in hashTable)
+    if (desc.prefetched)
+      shard.stats.prefetchwaste++;
+    removeFrame(shard, file, desc.pageNo, frameNo);
+    shard.policy.load()->onRemove(frameNo);
+    desc.Clear();
+    if (std::find(released.begin(), released.end(), &shard) == released.end())
+      released.push_back(&shard);
+  }
+  /// the cleared frames are free for requests which found every frame of their shard pinned
+  for (std::size_t i = 0; i < released.size(); i++)
+    notifyFrameWaiters(*released[i]);
 }
 
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
-  /// allocate an empty page in file
-  /// and obtain buffer pool frame
-  Page temp = file->allocatePage();
-  pageNo = temp.page_number();
+  BufShard* shard;
   FrameId frameNo;
-  this->allocBuf(this->clockHand);
-  frameNo = this->clockHand;
-  // TODO: Should the RHS of assignment be page or *page?
-  this->bufPool[frameNo] = temp;
+  allocFrame(file, pageNo, shard, frameNo);
+  page = &(this->bufPool[frameNo]);
+}
+
+PageHandle BufMgr::allocPage(File* file, PageId& pageNo)
+{
+  BufShard* shard;
+  FrameId frameNo;
+  allocFrame(file, pageNo, shard, frameNo);
+  return PageHandle(this, shard, frameNo);
+}
+
+void BufMgr::allocFrame(File* file, PageId& pageNo, BufShard*& shardOf, FrameId& frameNo)
+{
+  if (numShards > 1)
+  {
+    /// the shard, and so the frame, depends on the number the file gives the page; allocate the page first
+    /// and copy it into the frame
+    Page temp = file->allocatePage();
+    pageNo = temp.page_number();
+    BufShard& shard = shardFor(file, pageNo);
+    shardOf = &shard;
+    std::unique_lock<std::mutex> guard(shard.latch);
+    shard.stats.accesses++;
+    shard.stats.diskreads++;
+    shard.policy.load()->onMiss(file, pageNo);
+    takeFrame(shard, guard, frameNo);
+    this->bufPool[frameNo] = temp;
+    loadAllocated(shard, file, pageNo, frameNo);
+    return;
+  }
+
+  /// obtain a buffer pool frame, then allocate an empty page in file right into it; the frame stays locked
+  /// and out of the hashTable meanwhile, so the latch need not be held while the file is searched
+  BufShard& shard = shards[0];
+  shardOf = &shard;
+  {
+    std::unique_lock<std::mutex> guard(shard.latch);
+    shard.stats.accesses++;
+    takeFrame(shard, guard, frameNo);
+  }
+  try
+  {
+    file->allocatePage(this->bufPool[frameNo]);
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> guard(shard.latch);
+    this->bufDescTable[frameNo].Clear();
+    throw;
+  }
+  pageNo = this->bufPool[frameNo].page_number();
+  std::lock_guard<std::mutex> guard(shard.latch);
+  shard.stats.diskreads++;
+  /// the policy is not told about the miss, since the page only got its number after the frame was chosen
+  loadAllocated(shard, file, pageNo, frameNo);
+}
+
+void BufMgr::takeFrame(BufShard& shard, std::unique_lock<std::mutex>& guard, FrameId& frameNo)
+{
+  FrameWait wait(shard, frameWaitMicros.load(std::memory_order_relaxed));
+  while (!wait.mayTake() || !this->allocBuf(shard, frameNo))
+  {
+    if (!wait.wait(guard))
+      throw BufferExceededException();
+  }
+}
+
+void BufMgr::loadAllocated(BufShard& shard, File* file, const PageId pageNo, const FrameId frameNo)
+{
   /// insert an entry into hashTable
   /// set the frame description
-  this->hashTable->insert(file, pageNo, frameNo);
+  insertFrame(shard, file, pageNo, frameNo);
   this->bufDescTable[frameNo].Set(file, pageNo);
-  page = &(this->bufPool[frameNo]);
+  shard.policy.load()->onLoad(frameNo, file, pageNo);
+  shard.policy.load()->onPin(frameNo);
 }
 
 void BufMgr::disposePage(File* file, const PageId pageNo)
 {
+  BufShard& shard = shardFor(file, pageNo);
+  std::lock_guard<std::mutex> writerGuard(writerLatch);
+  std::lock_guard<std::mutex> guard(shard.latch);
   FrameId frameNo;
   /// find page buf frame's frameNo corresponding to given file and pageNo.
   /// not handling HashNotFoundException as according to Minh Le 
   /// on piazza @342, caller can catch and handle it.
-  this->hashTable->lookup(file, pageNo, frameNo);
+  if (!lookupFrame(shard, file, pageNo, frameNo))
+    throw HashNotFoundException(file->filename(), pageNo);
   /// if frame is pinned
   ///   throw PagePinnedException (as per Xiuting Wang [piazza @347])
   /// else
   ///   clear description for page buf frame,
   ///   remove hashTable entry for file and pageNo
   ///   and delete page from bufPool
-  if (this->bufDescTable[frameNo].pinCnt > 0)
+  if (!this->bufDescTable[frameNo].TryLock())
     throw PagePinnedException(file->filename(), pageNo, frameNo);  
-  this->hashTable->remove(file, pageNo);
+  if (this->bufDescTable[frameNo].prefetched)
+    shard.stats.prefetchwaste++;
+  removeFrame(shard, file, pageNo, frameNo);
+  shard.policy.load()->onRemove(frameNo);
   this->bufDescTable[frameNo].Clear();
+  notifyFrameWaiters(shard);
   // TODO: do we need to set the page entry in bufPool to NULL explicitly?
   // this->bufPool[frameNo] = NULL;
   /** 
@@ -272,8 +1161,11 @@ void BufMgr::printSelf(void)
 {
   BufDesc* tmpbuf;
 	int validFrames = 0;
+  std::vector<std::unique_lock<std::mutex> > guards;
+  for (std::uint32_t s = 0; s < numShards; s++)
+    guards.push_back(std::unique_lock<std::mutex>(shards[s].latch));
   
-  for (std::uint32_t i = 0; i < numBufs; i++)
+  for (std::uint32_t i = 0; i < maxBufs; i++)
 	{
   	tmpbuf = &(bufDescTable[i]);
 		std::cout << "FrameNo:" << i << " ";
@@ -286,4 +1178,499 @@ void BufMgr::printSelf(void)
 	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
 }
 
+void BufMgr::startBackgroundWriter(std::uint32_t cleanFrames, std::uint32_t batchSize, std::uint32_t intervalMs)
+{
+  stopBackgroundWriter();
+  writerCleanFrames = cleanFrames;
+  writerBatch = batchSize;
+  writerInterval = std::chrono::milliseconds(intervalMs);
+  writerStop = false;
+  writerThread = std::thread(&BufMgr::runWriter, this);
+}
+
+void BufMgr::stopBackgroundWriter()
+{
+  if (!writerThread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> wait(writerWaitLatch);
+    writerStop = true;
+  }
+  writerWake.notify_one();
+  writerThread.join();
+}
+
+void BufMgr::runWriter()
+{
+  std::vector<FrameId> frames;
+  std::unique_lock<std::mutex> wait(writerWaitLatch);
+  while (!writerStop)
+  {
+    wait.unlock();
+    try
+    {
+      std::lock_guard<std::mutex> writerGuard(writerLatch);
+      for (std::uint32_t s = 0; s < numShards; s++)
+        writeBehind(shards[s], frames);
+    }
+    catch (const BadgerDbException& e)
+    {
+      /// nothing waits for the writer to report to; a failed pass must not end it
+      std::cerr << e.message() << std::endl;
+    }
+    wait.lock();
+    if (!writerStop)
+      writerWake.wait_for(wait, writerInterval);
+  }
+}
+
+void BufMgr::writeBehind(BufShard& shard, std::vector<FrameId>& frames)
+{
+  /// every shard keeps its share of the clean frames
+  std::uint32_t count = (std::uint32_t) (((std::uint64_t) writerCleanFrames * shard.numFrames + numBufs - 1) / numBufs);
+  frames.clear();
+  {
+    std::lock_guard<std::mutex> guard(shard.latch);
+    shard.policy.load()->nextVictims(count, frames);
+  }
+
+  int dirtyFrames = 0;
+  std::uint32_t written = 0;
+  for (std::size_t i = 0; i < frames.size(); i++)
+  {
+    BufDesc& desc = bufDescTable[frames[i]];
+    if (!desc.dirty)
+      continue;
+    dirtyFrames++;
+    /// skip pinned frames, and frames being assigned to another page under the latch
+    if (written == writerBatch || !desc.TryLock())
+      continue;
+    /// the frame may have changed between nextVictims() and locking it
+    if (desc.valid && desc.dirty)
+    {
+      try
+      {
+        desc.file->writePage(bufPool[frames[i]]);
+        desc.dirty = false;
+        shard.stats.diskwrites++;
+        shard.stats.bgwrites++;
+        written++;
+      }
+      catch (const BadgerDbException&)
+      {
+        /// a failed write (FileIoException): the page stays dirty, for the next pass or the thread evicting it
+        shard.stats.bgwriteerrors++;
+      }
+    }
+    desc.Unlock();
+    /// a request may have found every other frame pinned while this one was locked
+    notifyFrameWaiters(shard);
+  }
+  shard.stats.bglag = dirtyFrames;
+}
+
+void BufMgr::setFrameWait(std::chrono::microseconds timeout)
+{
+  frameWaitMicros.store(timeout.count() > 0 ? timeout.count() : 0);
+  /// waiters keep the timeout they started with
+}
+
+std::uint32_t BufMgr::resize(std::uint32_t newBufs)
+{
+  std::lock_guard<std::mutex> resizeGuard(resizeLatch);
+  newBufs = std::min(std::max(newBufs, numShards), maxBufs);
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    std::unique_lock<std::mutex> guard(shards[s].latch);
+    resizeShard(shards[s], guard, newBufs / numShards + (s < newBufs % numShards ? 1 : 0));
+  }
+  numBufs = newBufs;
+  return newBufs;
+}
+
+void BufMgr::resizeShard(BufShard& shard, std::unique_lock<std::mutex>& guard, const std::uint32_t frames)
+{
+  const std::uint32_t oldFrames = shard.numFrames;
+  if (frames == oldFrames)
+    return;
+  /// the table of a single shard grows incrementally; a lock-free page table grows by itself
+  if (frames > oldFrames && shard.hashTable)
+    shard.hashTable->reserve(frames);
+
+  /// from now on, pages in frames taken away are not pinned again, and the new policy only hands out the frames
+  /// in use.  It starts out knowing the pages cached in them
+  shard.numFrames = frames;
+  ReplacementPolicy* policy = ReplacementPolicy::create(policyKind, shard.firstFrame, frames, pinCounts);
+  for (FrameId f = shard.firstFrame; f < shard.firstFrame + std::min(frames, oldFrames); f++)
+  {
+    BufDesc& desc = bufDescTable[f];
+    if (!desc.valid)
+      continue;
+    if (desc.prefetched || desc.inRing)
+      policy->onLoadCold(f, desc.file, desc.pageNo);
+    else
+      policy->onLoad(f, desc.file, desc.pageNo);
+    if (desc.pinCnt.load() > 0)
+      policy->onPin(f);
+  }
+  EpochManager::instance().retire(shard.policy.exchange(policy), deletePolicy);
+
+  /// evict the pages of the frames taken away, waiting for pinned ones to be unpinned; the latch is released
+  /// meanwhile, so that everything else goes on
+  std::vector<FrameId> left;
+  for (FrameId f = shard.firstFrame + frames; f < shard.firstFrame + oldFrames; f++)
+    left.push_back(f);
+  while (!left.empty())
+  {
+    std::size_t pinned = 0;
+    for (std::size_t i = 0; i < left.size(); i++)
+    {
+      BufDesc& desc = bufDescTable[left[i]];
+      if (!desc.TryLock())
+      {
+        left[pinned++] = left[i];
+        continue;
+      }
+      if (desc.valid)
+        dropPage(shard, left[i]);
+      desc.Clear();
+    }
+    left.resize(pinned);
+    /// requests for evicted pages may read them again, and new frames may be taken
+    shard.frameFreed.notify_all();
+    notifyFrameWaiters(shard);
+    if (!left.empty())
+    {
+      guard.unlock();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      guard.lock();
+    }
+  }
+  shard.frameFreed.notify_all();
+  if (frames < oldFrames)
+    arena->discard((std::size_t) (shard.firstFrame + frames) * Page::SIZE,
+                   (std::size_t) (oldFrames - frames) * Page::SIZE);
+}
+
+void BufMgr::startReadAhead(std::uint32_t maxPages)
+{
+  stopReadAhead();
+  if (maxPages == 0)
+    return;
+  prefetchStop = false;
+  prefetchThread = std::thread(&BufMgr::runPrefetcher, this);
+  readAheadMax = maxPages;
+}
+
+void BufMgr::stopReadAhead()
+{
+  readAheadMax = 0;
+  if (!prefetchThread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> queueGuard(prefetchQueueLatch);
+    prefetchStop = true;
+    prefetchQueue.clear();
+  }
+  prefetchWake.notify_one();
+  prefetchThread.join();
+  std::lock_guard<std::mutex> readAheadGuard(readAheadLatch);
+  readAheadStates.clear();
+}
+
+void BufMgr::noteAccess(File* file, const PageId pageNo)
+{
+  /// a request continues a sequential run if it is for the page after the previous one,
+  /// or skips ahead to a page that has been read ahead already
+  PageId from, to;
+  {
+    std::lock_guard<std::mutex> readAheadGuard(readAheadLatch);
+    std::unordered_map<std::uint32_t, ReadAheadState>::iterator it = readAheadStates.find(file->id());
+    if (it == readAheadStates.end())
+    {
+      ReadAheadState state = {pageNo, pageNo, std::min(READ_AHEAD_MIN, readAheadMax.load())};
+      readAheadStates[file->id()] = state;
+      return;
+    }
+    ReadAheadState& state = it->second;
+    bool sequential = pageNo == state.last + 1 || (pageNo > state.last && pageNo <= state.ahead);
+    state.last = pageNo;
+    if (!sequential)
+    {
+      state.ahead = pageNo;
+      return;
+    }
+    from = std::max(state.ahead, pageNo) + 1;
+    to = pageNo + state.window;
+    if (from > to)
+      return;
+    state.ahead = to;
+  }
+
+  {
+    std::lock_guard<std::mutex> queueGuard(prefetchQueueLatch);
+    for (PageId p = from; p <= to; p++)
+      prefetchQueue.push_back(std::make_pair(file, p));
+  }
+  prefetchWake.notify_one();
+}
+
+void BufMgr::noteHit(BufShard& shard, const FrameId frameNo, const ScanRing* ring)
+{
+  {
+    /// without the latch, the policy may be replaced by resize() meanwhile
+    EpochGuard epoch;
+    ReplacementPolicy* policy = shard.policy.load();
+    policy->onHit(frameNo);
+    policy->onPin(frameNo);
+  }
+  BufDesc& desc = bufDescTable[frameNo];
+  if (!ring && desc.inRing.load(std::memory_order_relaxed))
+    desc.inRing = false;
+  if (desc.prefetched.load(std::memory_order_relaxed) && desc.prefetched.exchange(false))
+  {
+    shard.stats.prefetchhits++;
+    adjustReadAhead(desc.file, true);
+  }
+}
+
+void BufMgr::adjustReadAhead(const File* file, const bool used)
+{
+  std::lock_guard<std::mutex> readAheadGuard(readAheadLatch);
+  std::unordered_map<std::uint32_t, ReadAheadState>::iterator it = readAheadStates.find(file->id());
+  if (it == readAheadStates.end())
+    return;
+  std::uint32_t& window = it->second.window;
+  if (used)
+    window = std::min(window + 1, readAheadMax.load());
+  else
+    window = std::max(window / 2, (std::uint32_t) 1);
+}
+
+void BufMgr::runPrefetcher()
+{
+  std::unique_lock<std::mutex> queueGuard(prefetchQueueLatch);
+  while (true)
+  {
+    while (!prefetchStop && prefetchQueue.empty())
+      prefetchWake.wait(queueGuard);
+    if (prefetchStop)
+      return;
+    /// read the pages queued for the same file together
+    File* file = prefetchQueue.front().first;
+    std::vector<PageId> pageNos;
+    while (!prefetchQueue.empty() && prefetchQueue.front().first == file && pageNos.size() < PREFETCH_BATCH)
+    {
+      pageNos.push_back(prefetchQueue.front().second);
+      prefetchQueue.pop_front();
+    }
+    /// flushFile() waits on prefetchLatch for pages of its file taken off the queue
+    std::unique_lock<std::mutex> busyGuard(prefetchLatch);
+    queueGuard.unlock();
+    prefetchPages(file, pageNos);
+    busyGuard.unlock();
+    queueGuard.lock();
+  }
+}
+
+void BufMgr::prefetchPages(File* file, std::vector<PageId>& pageNos)
+{
+  /// the reader may have overtaken the prefetcher, or left the run
+  {
+    std::lock_guard<std::mutex> readAheadGuard(readAheadLatch);
+    std::unordered_map<std::uint32_t, ReadAheadState>::iterator it = readAheadStates.find(file->id());
+    if (it == readAheadStates.end())
+      return;
+    const ReadAheadState& state = it->second;
+    pageNos.erase(std::remove_if(pageNos.begin(), pageNos.end(),
+                                 [&state](PageId p) { return p <= state.last || p > state.ahead; }),
+                  pageNos.end());
+  }
+  std::sort(pageNos.begin(), pageNos.end());
+  pageNos.erase(std::unique(pageNos.begin(), pageNos.end()), pageNos.end());
+
+  /// take a frame for every page which is not in the buffer pool yet.  The frames stay locked and out of the
+  /// tables while all pages are read at once, so the latches need not be held meanwhile
+  std::vector<PageId> toRead;
+  std::vector<FrameId> frames;
+  std::vector<Page*> targets;
+  for (std::size_t i = 0; i < pageNos.size(); i++)
+  {
+    BufShard& shard = shardFor(file, pageNos[i]);
+    std::lock_guard<std::mutex> guard(shard.latch);
+    FrameId frameNo;
+    if (lookupFrame(shard, file, pageNos[i], frameNo) || !this->allocBuf(shard, frameNo))
+      continue;
+    toRead.push_back(pageNos[i]);
+    frames.push_back(frameNo);
+    targets.push_back(&bufPool[frameNo]);
+  }
+  if (toRead.empty())
+    return;
+  std::unique_ptr<bool[]> found(new bool[toRead.size()]);
+  file->tryReadPages(toRead.data(), toRead.size(), targets.data(), found.get());
+
+  for (std::size_t i = 0; i < toRead.size(); i++)
+  {
+    BufShard& shard = shardFor(file, toRead[i]);
+    std::unique_lock<std::mutex> guard(shard.latch);
+    FrameId frameNo = frames[i];
+    FrameId other;
+    /// past the end of the file or a free page, read by a request meanwhile, or the frame is being taken away
+    if (!found[i] || lookupFrame(shard, file, toRead[i], other) || removing(shard, frameNo))
+    {
+      this->bufDescTable[frameNo].Clear();
+    }
+    else
+    {
+      shard.stats.diskreads++;
+      shard.stats.prefetches++;
+      insertFrame(shard, file, toRead[i], frameNo);
+      this->bufDescTable[frameNo].Set(file, toRead[i], true);
+      shard.policy.load()->onLoadCold(frameNo, file, toRead[i]);
+    }
+    /// the frame is unpinned either way
+    notifyFrameWaiters(shard);
+  }
+}
+
+std::uint32_t BufMgr::getFilePages(const File* file, std::uint32_t& dirty)
+{
+  std::uint32_t pages = 0;
+  dirty = 0;
+  std::vector<FrameId> frames;
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    std::lock_guard<std::mutex> guard(shards[s].latch);
+    frames.clear();
+    framesOfFile(shards[s], file, frames);
+    pages += frames.size();
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+      if (bufDescTable[frames[i]].dirty)
+        dirty++;
+    }
+  }
+  return pages;
+}
+
+BufStats & BufMgr::getBufStats()
+{
+  std::lock_guard<std::mutex> statsGuard(statsLatch);
+  bufStats.clear();
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    std::lock_guard<std::mutex> guard(shards[s].latch);
+    bufStats.add(shards[s].stats);
+  }
+  return bufStats;
+}
+
+void BufMgr::clearBufStats()
+{
+  std::lock_guard<std::mutex> statsGuard(statsLatch);
+  for (std::uint32_t s = 0; s < numShards; s++)
+  {
+    std::lock_guard<std::mutex> guard(shards[s].latch);
+    shards[s].stats.clear();
+  }
+  bufStats.clear();
+}
+
+PageHandle::PageHandle(BufMgr* mgr, BufShard* shard, const FrameId frameNo)
+  : mgr(mgr), shard(shard), frameNo(frameNo), latchMode(LatchMode::NONE)
+{
+}
+
+PageHandle::PageHandle(PageHandle&& other)
+  : mgr(other.mgr), shard(other.shard), frameNo(other.frameNo), latchMode(other.latchMode)
+{
+  other.mgr = NULL;
+  other.latchMode = LatchMode::NONE;
+}
+
+PageHandle::~PageHandle()
+{
+  unpin();
+}
+
+PageHandle& PageHandle::operator=(PageHandle&& other)
+{
+  if (this != &other)
+  {
+    unpin();
+    mgr = other.mgr;
+    shard = other.shard;
+    frameNo = other.frameNo;
+    latchMode = other.latchMode;
+    other.mgr = NULL;
+    other.latchMode = LatchMode::NONE;
+  }
+  return *this;
+}
+
+Page* PageHandle::get() const
+{
+  return mgr ? &mgr->bufPool[frameNo] : NULL;
+}
+
+PageId PageHandle::pageNo() const
+{
+  return mgr->bufDescTable[frameNo].pageNo;
+}
+
+void PageHandle::markDirty()
+{
+  mgr->bufDescTable[frameNo].dirty = true;
+}
+
+void PageHandle::release()
+{
+  BufMgr* owner = mgr;
+  if (!unpin())
+    throw PageNotPinnedException(owner->bufDescTable[frameNo].file->filename(), owner->bufDescTable[frameNo].pageNo,
+                                 frameNo);
+}
+
+void PageHandle::lockShared()
+{
+  mgr->bufDescTable[frameNo].latch.lockShared();
+  latchMode = LatchMode::SHARED;
+}
+
+void PageHandle::lockExclusive()
+{
+  mgr->bufDescTable[frameNo].latch.lockExclusive();
+  latchMode = LatchMode::EXCLUSIVE;
+}
+
+void PageHandle::unlock()
+{
+  if (latchMode == LatchMode::SHARED)
+    mgr->bufDescTable[frameNo].latch.unlockShared();
+  else if (latchMode == LatchMode::EXCLUSIVE)
+    mgr->bufDescTable[frameNo].latch.unlockExclusive();
+  latchMode = LatchMode::NONE;
+}
+
+std::uint64_t PageHandle::readVersion() const
+{
+  return mgr->bufDescTable[frameNo].latch.version();
+}
+
+bool PageHandle::validate(const std::uint64_t version) const
+{
+  return mgr->bufDescTable[frameNo].latch.validate(version);
+}
+
+bool PageHandle::unpin()
+{
+  if (!mgr)
+    return true;
+  unlock();
+  BufMgr* owner = mgr;
+  mgr = NULL;
+  return owner->unPinHandle(*shard, frameNo);
+}
+
 }
@@ -7,8 +7,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "file.h"
 #include "bufHashTbl.h"
+#include "epoch_manager.h"
+#include "frame_latch.h"
+#include "page_arena.h"
+#include "page_table.h"
+#include "replacement_policy.h"
 
 namespace badgerdb {
 
@@ -19,10 +34,15 @@ class BufMgr;
 
 /**
 * @brief Class for maintaining information about buffer pool frames
+*
+* The pin count, dirty and valid flags of a frame are not stored in its descriptor but in dense arrays of the
+* buffer manager, one entry per frame (see BufMgr::pinCounts), which the descriptor refers to.  The clock sweep
+* thereby reads the pin counts of many frames at a time without touching their descriptors.
 */
 class BufDesc {
 
 	friend class BufMgr;
+	friend class PageHandle;
 
  private:
 	/**
@@ -41,36 +61,109 @@ class BufDesc {
   FrameId	frameNo;
 
 	/**
-   * Number of times this page has been pinned
+   * Number of times this page has been pinned, or LOCKED while the frame is being assigned to another page.
+   * Atomic so that resident pages can be pinned without holding the latch of their shard.  Entry of
+   * BufMgr::pinCounts.
 	 */
-  int pinCnt;
+  std::atomic<int>& pinCnt;
 
 	/**
-   * True if page is dirty;  false otherwise
+   * True if page is dirty;  false otherwise.  Entry of BufMgr::dirtyFlags.
 	 */
-  bool dirty;
+  std::atomic<bool>& dirty;
 
 	/**
-   * True if page is valid
+   * True if page is valid.  Entry of BufMgr::validFlags.
 	 */
-  bool valid;
+  bool& valid;
 
 	/**
-   * Has this buffer frame been reference recently
+   * True if the page was read ahead and has not been requested since
 	 */
-  bool refbit;
+  std::atomic<bool> prefetched;
 
 	/**
-   * Initialize buffer frame for a new user
+   * True if the page was read through a ScanRing and has not been requested without it since
+	 */
+  std::atomic<bool> inRing;
+
+	/**
+   * Latch on the contents of the frame, see PageHandle::lockShared().  Its version also changes while the frame is
+   * locked, so that optimistic readers notice when the frame is given to another page.
+	 */
+  FrameLatch latch;
+
+	/**
+   * Next and previous frame in the list of frames of the shard holding pages of the same file (see
+   * BufShard::fileFrames), or NO_FRAME at either end.  Only accessed under the latch of the shard.
+	 */
+  FrameId fileNext;
+  FrameId filePrev;
+
+	/**
+   * Value of pinCnt while the frame is locked
+	 */
+  static const int LOCKED = -1;
+
+	/**
+   * End of a list of frames
+	 */
+  static const FrameId NO_FRAME = ~(FrameId) 0;
+
+	/**
+	 * Lock an unpinned frame so that it cannot be pinned until Clear() or Set() is called.  Every change of the
+	 * page held by a frame happens while the frame is locked, so a thread which managed to pin a frame can read
+	 * file, pageNo and valid without holding the latch of the shard.
+	 *
+	 * @return True if the frame was unpinned and is now locked
+	 */
+  bool TryLock()
+	{
+    int unpinned = 0;
+    if (!pinCnt.compare_exchange_strong(unpinned, LOCKED, std::memory_order_acquire))
+      return false;
+    latch.beginChange();
+    return true;
+  }
+
+	/**
+	 * Pin the frame unless it is locked.
+	 *
+	 * @return True if the frame was pinned
+	 */
+  bool TryPin()
+	{
+    int pins = pinCnt.load(std::memory_order_relaxed);
+    do
+    {
+      if (pins == LOCKED)
+        return false;
+    } while (!pinCnt.compare_exchange_weak(pins, pins + 1, std::memory_order_acquire));
+    return true;
+  }
+
+	/**
+   * Unlock a locked frame without changing the page it holds
+	 */
+  void Unlock()
+	{
+    latch.endChange();
+    pinCnt.store(0, std::memory_order_release);
+  }
+
+	/**
+   * Initialize buffer frame for a new user and unlock it
 	 */
   void Clear()
 	{
-    pinCnt = 0;
 		file = NULL;
 		pageNo = Page::INVALID_NUMBER;
     dirty = false;
-    refbit = false;
 		valid = false;
+    prefetched = false;
+    inRing = false;
+    latch.endChange();
+    pinCnt.store(0, std::memory_order_release);
   };
 
 	/**
@@ -79,15 +172,18 @@ class BufDesc {
 	 *
 	 * @param filePtr	File object
 	 * @param pageNum	Page number in the file
+	 * @param prefetch	True if the page was read ahead; the frame is then left unpinned instead of pinned once
 	 */
-  void Set(File* filePtr, PageId pageNum)
+  void Set(File* filePtr, PageId pageNum, bool prefetch = false)
 	{ 
 		file = filePtr;
     pageNo = pageNum;
-    pinCnt = 1;
     dirty = false;
     valid = true;
-    refbit = true;
+    prefetched = prefetch;
+    inRing = false;
+    latch.endChange();
+    pinCnt.store(prefetch ? 0 : 1, std::memory_order_release);
   }
 
   void Print()
@@ -101,15 +197,19 @@ class BufDesc {
 			std::cout << "file:NULL ";
 
 		std::cout << "valid:" << valid << " ";
-		std::cout << "pinCnt:" << pinCnt << " ";
-		std::cout << "dirty:" << dirty << " ";
-		std::cout << "refbit:" << refbit << "\n";
+		std::cout << "pinCnt:" << pinCnt.load() << " ";
+		std::cout << "dirty:" << dirty.load() << "\n";
   }
 
 	/**
    * Constructor of BufDesc class 
+   *
+   * @param pins       Entry of the frame in BufMgr::pinCounts
+   * @param dirtyFlag  Entry of the frame in BufMgr::dirtyFlags
+   * @param validFlag  Entry of the frame in BufMgr::validFlags
 	 */
-  BufDesc()
+  BufDesc(std::atomic<int>& pins, std::atomic<bool>& dirtyFlag, bool& validFlag)
+    : pinCnt(pins), dirty(dirtyFlag), valid(validFlag), fileNext(NO_FRAME), filePrev(NO_FRAME)
 	{
   	Clear();
   }
@@ -124,17 +224,68 @@ struct BufStats
 	/**
    * Total number of accesses to buffer pool
 	 */
-  int accesses;
+  std::atomic<int> accesses;
 
 	/**
    * Number of pages read from disk (including allocs)
 	 */
-  int diskreads;
+  std::atomic<int> diskreads;
 
 	/**
    * Number of pages written back to disk
 	 */
-  int diskwrites;
+  std::atomic<int> diskwrites;
+
+	/**
+   * Number of pages written back to disk by the background writer (included in diskwrites)
+	 */
+  std::atomic<int> bgwrites;
+
+	/**
+   * Number of pages the background writer failed to write back; they stay dirty and are tried again
+	 */
+  std::atomic<int> bgwriteerrors;
+
+	/**
+   * Number of dirty pages written back by the thread evicting them (included in diskwrites).  While the
+   * background writer runs, these are the evictions it did not get ahead of.
+	 */
+  std::atomic<int> evictwrites;
+
+	/**
+   * Number of dirty pages the background writer found among the next victims at the start of its last pass
+	 */
+  std::atomic<int> bglag;
+
+	/**
+   * Number of pages read ahead of any request (included in diskreads)
+	 */
+  std::atomic<int> prefetches;
+
+	/**
+   * Number of pages read ahead which were requested afterwards
+	 */
+  std::atomic<int> prefetchhits;
+
+	/**
+   * Number of pages read ahead which left the buffer pool without being requested
+	 */
+  std::atomic<int> prefetchwaste;
+
+	/**
+   * Number of requests which found every frame pinned and waited for one (see BufMgr::setFrameWait())
+	 */
+  std::atomic<int> framewaits;
+
+	/**
+   * Total microseconds requests spent waiting for a frame
+	 */
+  std::atomic<long long> framewaitus;
+
+	/**
+   * Number of requests which waited for a frame until their timeout and failed (included in framewaits)
+	 */
+  std::atomic<int> frametimeouts;
 
 	/**
    * Clear all values 
@@ -142,6 +293,30 @@ struct BufStats
   void clear()
   {
 		accesses = diskreads = diskwrites = 0;
+		bgwrites = bgwriteerrors = evictwrites = bglag = 0;
+		prefetches = prefetchhits = prefetchwaste = 0;
+		framewaits = frametimeouts = 0;
+		framewaitus = 0;
+  }
+
+	/**
+   * Add the values of another set of statistics to this one
+	 */
+  void add(const BufStats& other)
+  {
+		accesses += other.accesses;
+		diskreads += other.diskreads;
+		diskwrites += other.diskwrites;
+		bgwrites += other.bgwrites;
+		bgwriteerrors += other.bgwriteerrors;
+		evictwrites += other.evictwrites;
+		bglag += other.bglag;
+		prefetches += other.prefetches;
+		prefetchhits += other.prefetchhits;
+		prefetchwaste += other.prefetchwaste;
+		framewaits += other.framewaits;
+		framewaitus += other.framewaitus;
+		frametimeouts += other.frametimeouts;
   }
       
 	/**
@@ -155,136 +330,1121 @@ struct BufStats
 
 
 /**
-* @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+* @brief Outcome of BufMgr::tryReadPage()
 */
-class BufMgr 
+enum class PageStatus
 {
- private:
 	/**
-   * Current position of clockhand in our buffer pool
+   * The page was already in the buffer pool
 	 */
-  FrameId clockHand;
+  HIT,
 
 	/**
-   * Number of frames in the buffer pool
+   * The page was read from its file into a free frame
 	 */
-  std::uint32_t numBufs;
-	
+  MISS,
+
+	/**
+   * The page does not exist in the file or is not in use
+	 */
+  INVALID_PAGE,
+
+	/**
+   * The page is not in the buffer pool and every frame it could be read into is pinned
+	 */
+  BUFFER_EXCEEDED
+};
+
+
+/**
+* @brief A partition of the buffer pool.
+*
+* Each shard owns a contiguous range of frames together with the hash table, replacement policy and statistics for the
+* pages that map to it.  A page is always cached in a frame of the shard selected by BufMgr::shardFor(), so all
+* state of a shard is protected by its own latch and operations on pages of different shards never contend.
+*/
+struct BufShard
+{
+	/**
+   * Latch protecting every member of the shard and the descriptors of its frames
+	 */
+  std::mutex latch;
+
+	/**
+   * First frame of the buffer pool owned by this shard
+	 */
+  FrameId firstFrame;
+
+	/**
+   * Number of frames in use by this shard, the first of the frames reserved for it.  Changed under the latch by
+   * BufMgr::resize(); read without it by lock-free readers, which must not pin frames beyond it.
+	 */
+  std::atomic<std::uint32_t> numFrames;
+
+	/**
+   * Number of frames reserved for this shard, which numFrames may grow to
+	 */
+  std::uint32_t maxFrames;
+
 	/**
-   * Hash table mapping (File, page) to frame
+   * Replacement policy choosing which frame of this shard is reused for a missing page.  Replaced under the latch
+   * when the shard is resized; a replaced policy is freed through the EpochManager, since a latch-free policy may
+   * still be in use by threads which did not take the latch.
+	 */
+  std::atomic<ReplacementPolicy*> policy;
+
+	/**
+   * True if the policy of the shard is latch-free (see ReplacementPolicy::isLatchFree())
+	 */
+  bool latchFree;
+
+	/**
+   * Hash table mapping (File, page) to frame for the pages of this shard, only accessed under the latch.
+   * NULL if the buffer manager uses lock-free page tables.
 	 */
   BufHashTbl *hashTable;
 
 	/**
-   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+   * Lock-free table mapping (File, page) to frame for the pages of this shard.  Only modified under the latch,
+   * but resident pages are looked up and pinned without taking it.  NULL unless the buffer manager is concurrent.
 	 */
-  BufDesc *bufDescTable;
+  PageTable *pageTable;
 
 	/**
-   * Maintains Buffer pool usage statistics 
+   * First frame of the list of frames holding pages of each file in this shard, linked through BufDesc::fileNext,
+   * so that the pages of one file are found without scanning the pool.  Files without pages in the shard have
+   * no entry.  Only accessed under the latch.
 	 */
-  BufStats bufStats;
+  std::unordered_map<const File*, FrameId> fileFrames;
+
+	/**
+   * Buffer pool usage statistics of this shard.  Counters are atomic since hits on resident pages are counted
+   * without holding the latch.
+	 */
+  BufStats stats;
+
+	/**
+   * Notified, under the latch, once resize() evicted the pages of the frames it takes away
+	 */
+  std::condition_variable frameFreed;
+
+	/**
+   * Guards frameReleases and frameReleased.  Never held while taking another latch, so that frames may be released
+   * by threads holding the latch of any shard.
+	 */
+  std::mutex waitLatch;
+
+	/**
+   * Notified, under waitLatch, when a frame of the shard may have become available to threads waiting for one
+	 */
+  std::condition_variable frameReleased;
+
+	/**
+   * Number of times frameReleased was notified, so that a waiter knows whether a frame was released since it
+   * last tried to take one
+	 */
+  std::uint64_t frameReleases;
+
+	/**
+   * Tickets of the threads waiting for a frame of the shard, in the order they started waiting.  Only the first of
+   * them may take a frame, and threads which find others waiting queue up behind them.
+	 */
+  std::deque<std::uint64_t> frameWaiters;
+
+	/**
+   * Ticket given to the next thread that waits for a frame
+	 */
+  std::uint64_t nextTicket;
+
+	/**
+   * Number of threads in frameWaiters, read without the latch by threads giving up pins
+	 */
+  std::atomic<std::uint32_t> frameWaiting;
 
 	/**
-   * Advance clock to next frame in the buffer pool
+   * Keeps the latches of neighbouring shards on separate cache lines
 	 */
-  void advanceClock();
+  char padding[64];
+};
+
+
+/**
+* @brief Bulk access strategy for large sequential scans, like the ring buffers of PostgreSQL.
+*
+* Pages that a scan reads through a ScanRing (see BufMgr::readPage()) and which are not in the buffer pool yet
+* are read into a small ring of frames that the scan keeps reusing, rather than into frames chosen by the
+* replacement policy, and the policy is told that they are cold (see ReplacementPolicy::onLoadCold()).  A scan of
+* any length thus evicts about size pages of the rest of the pool.  A page of the ring that is requested without
+* the ring, or whose frame is still pinned when it comes up for reuse, leaves the ring.
+*
+* A ScanRing must only be used by one thread at a time, and with one buffer manager.
+*/
+class ScanRing
+{
+	friend class BufMgr;
 
+ public:
 	/**
-	 * Allocate a free frame.  
+   * Constructor of ScanRing class
 	 *
-	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
-	 * @throws BufferExceededException If no such buffer is found which can be allocated
+	 * @param ringSize  Number of frames the scan reuses, spread over the shards of the buffer manager
+	 */
+  explicit ScanRing(std::uint32_t ringSize = 16)
+    : size(ringSize) {
+  }
+
+ private:
+	/**
+   * @brief A frame of the ring together with the shard owning it
+	 */
+  struct Slot
+  {
+    BufShard* shard;
+    FrameId frame;
+
+    Slot(BufShard* shardPtr, FrameId frameNo) : shard(shardPtr), frame(frameNo) {}
+  };
+
+	/**
+   * Number of frames the scan reuses
+	 */
+  std::uint32_t size;
+
+	/**
+   * Frames of the ring, least recently filled first
+	 */
+  std::vector<Slot> slots;
+};
+
+
+/**
+* @brief Sequential read-ahead state of one File
+*/
+struct ReadAheadState
+{
+	/**
+   * Last page requested from the file
 	 */
-  void allocBuf(FrameId & frame);
+  PageId last;
+
+	/**
+   * Last page read ahead (or queued for it) in the current sequential run
+	 */
+  PageId ahead;
+
+	/**
+   * Number of pages to keep read ahead of the last page requested
+	 */
+  std::uint32_t window;
+};
+
+
+/**
+* @brief Ways a PageHandle may hold the latch on the contents of its page
+*/
+enum class LatchMode
+{
+	/**
+   * The latch is not held
+	 */
+  NONE,
+
+	/**
+   * The latch is held shared, so no other thread modifies the page
+	 */
+  SHARED,
+
+	/**
+   * The latch is held exclusive, so no other thread reads the page through a latch or an optimistic read
+	 */
+  EXCLUSIVE
+};
+
+
+/**
+* @brief Pin on a page in the buffer pool, released when the handle is destroyed.
+*
+* Handles are returned by BufMgr::readPage() and BufMgr::allocPage().  A handle remembers the frame it pinned, so
+* releasing the pin does not look the page up again, unlike BufMgr::unPinPage(), and markDirty() only sets the
+* dirty flag of the frame.  Handles can be moved but not copied; a handle that was moved from holds no pin.
+*
+* A handle must be released before its buffer manager is destroyed, and before the file of its page is flushed.
+*
+* A pin only keeps the page in its frame.  Threads sharing a page modify it under the exclusive latch of the frame
+* (lockExclusive()) and read it under the shared latch (lockShared()) or optimistically: remember readVersion(),
+* read, and accept what was read only if validate() succeeds.  Optimistic reads do not write to any shared cache
+* line, which suits pages nearly every operation reads and few modify, such as index roots.  The latch is released
+* together with the pin.
+*/
+class PageHandle
+{
+	friend class BufMgr;
 
  public:
 	/**
-   * Actual buffer pool from which frames are allocated
+   * Constructs a handle holding no pin
 	 */
-  Page* bufPool;
+  PageHandle() : mgr(NULL), shard(NULL), frameNo(0), latchMode(LatchMode::NONE) {}
+
+  PageHandle(PageHandle&& other);
+  PageHandle& operator=(PageHandle&& other);
 
 	/**
-   * Constructor of BufMgr class
+   * Unpins the page.  A pin given up through BufMgr::unPinPage() meanwhile is ignored here, unlike in release().
 	 */
-  BufMgr(std::uint32_t bufs);
-	
+  ~PageHandle();
+
 	/**
-   * Destructor of BufMgr class
+   * Returns the pinned page, or NULL if the handle holds no pin
 	 */
-  ~BufMgr();
+  Page* get() const;
+
+  Page* operator->() const { return get(); }
+  Page& operator*() const { return *get(); }
 
 	/**
-	 * Reads the given page from the file into a frame and returns the pointer to page.
-	 * If the requested page is already present in the buffer pool pointer to that frame is returned
-	 * otherwise a new frame is allocated from the buffer pool for reading the page.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number in the file to be read
-	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * Returns true if the handle holds a pin
 	 */
-  void readPage(File* file, const PageId PageNo, Page*& page);
+  explicit operator bool() const { return mgr != NULL; }
 
 	/**
-	 * Unpin a page from memory since it is no longer required for it to remain in memory.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number
-	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
-   * @throws  PageNotPinnedException If the page is not already pinned
+   * Returns the number of the pinned page in its file.  The handle must hold a pin.
 	 */
-  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+  PageId pageNo() const;
 
 	/**
-	 * Allocates a new, empty page in the file and returns the Page object.
-	 * The newly allocated page is also assigned a frame in the buffer pool.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
-	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+   * Marks the pinned page dirty, so that it is written back before its frame is reused.  The handle must hold a pin.
 	 */
-  void allocPage(File* file, PageId &PageNo, Page*& page); 
+  void markDirty();
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
-	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
-	 * Otherwise Error returned.
-	 *
-	 * @param file   	File object
-   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
-   * @throws BadBufferException If any frame allocated to the file is found to be invalid
+   * Unpins the page now rather than when the handle is destroyed.  Does nothing if the handle holds no pin.
+   *
+   * @throws  PageNotPinnedException If the pin was given up through BufMgr::unPinPage() meanwhile
 	 */
-  void flushFile(const File* file);
+  void release();
 
 	/**
-	 * Delete page from file and also from buffer pool if present.
-	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
-	 *
-	 * @param file   	File object
-	 * @param PageNo  Page number
+   * Takes the latch of the page shared, waiting for a writer holding it.  The handle must hold a pin and no latch.
 	 */
-  void disposePage(File* file, const PageId PageNo);
+  void lockShared();
 
 	/**
-   * Print member variable values. 
+   * Takes the latch of the page exclusive, waiting for the threads holding it.  The handle must hold a pin and no
+   * latch.
 	 */
-  void  printSelf();
+  void lockExclusive();
 
 	/**
-   * Get buffer pool usage statistics
+   * Releases the latch held by the handle, if any.  Releasing an exclusive latch fails the optimistic reads of the
+   * page that overlapped with it.
 	 */
-  BufStats & getBufStats()
-  {
-		return bufStats;
-  }
+  void unlock();
 
 	/**
-   * Clear buffer pool usage statistics
+   * Returns the way the handle holds the latch of its page
 	 */
-  void clearBufStats() 
-  {
-		bufStats.clear();
-  }
+  LatchMode latched() const { return latchMode; }
+
+	/**
+   * Starts an optimistic read of the pinned page, without taking its latch.
+   *
+   * @return  Version to pass to validate() once the read is done
+	 */
+  std::uint64_t readVersion() const;
+
+	/**
+   * Finishes an optimistic read.  What was read since readVersion() returned version may be torn by a concurrent
+   * writer unless this returns true; the read then has to be repeated or done under the shared latch.
+   *
+   * @param version Version returned by readVersion() before the read
+   * @return  True if no writer held the exclusive latch during the read
+	 */
+  bool validate(const std::uint64_t version) const;
+
+ private:
+  PageHandle(BufMgr* mgr, BufShard* shard, const FrameId frameNo);
+  PageHandle(const PageHandle&);
+  PageHandle& operator=(const PageHandle&);
+
+	/**
+   * Gives up the pin if the handle holds one.
+   *
+   * @return  False if the frame was not pinned anymore
+	 */
+  bool unpin();
+
+	/**
+   * Buffer manager holding the pin, NULL if the handle holds none
+	 */
+  BufMgr* mgr;
+
+	/**
+   * Shard owning the pinned frame
+	 */
+  BufShard* shard;
+
+	/**
+   * Pinned frame
+	 */
+  FrameId frameNo;
+
+	/**
+   * Way the handle holds the latch of the frame
+	 */
+  LatchMode latchMode;
+};
+
+
+/**
+* @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The buffer pool may be split into several shards (see BufShard) so that threads working on different pages can
+* read, allocate and unpin pages concurrently.  All public methods are threadsafe.
+*
+* A buffer manager with more than one shard is concurrent: it maps pages to frames with lock-free PageTables, so
+* readPage() on a resident page and unPinPage() only take a latch when they miss or fail, or when the replacement
+* policy has to be updated under the latch.  With a single shard
+* a BufHashTbl is used and every call takes the latch of the shard.
+*/
+class BufMgr 
+{
+	friend class PageHandle;
+
+ private:
+	/**
+   * Number of frames in the buffer pool
+	 */
+  std::atomic<std::uint32_t> numBufs;
+
+	/**
+   * Number of frames reserved for the buffer pool, which resize() may grow it to
+	 */
+  std::uint32_t maxBufs;
+
+	/**
+   * Replacement policy every shard is built with
+	 */
+  PolicyKind policyKind;
+
+	/**
+   * Serializes calls to resize()
+	 */
+  std::mutex resizeLatch;
+
+	/**
+   * Number of shards the buffer pool is partitioned into
+	 */
+  std::uint32_t numShards;
+
+	/**
+   * Array of shards, each owning a range of frames
+	 */
+  BufShard *shards;
+
+	/**
+   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+	 */
+  BufDesc *bufDescTable;
+
+	/**
+   * Pin count of every frame (see BufDesc::pinCnt), dense so that the replacement policy can scan it
+	 */
+  std::atomic<int> *pinCounts;
+
+	/**
+   * Dirty flag of every frame (see BufDesc::dirty)
+	 */
+  std::atomic<bool> *dirtyFlags;
+
+	/**
+   * Valid flag of every frame (see BufDesc::valid)
+	 */
+  bool *validFlags;
+
+	/**
+   * Memory holding bufPool, followed by bufDescTable, pinCounts, dirtyFlags and validFlags
+	 */
+  PageArena* arena;
+
+	/**
+   * Buffer pool usage statistics, summed up over all shards by getBufStats()
+	 */
+  BufStats bufStats;
+
+	/**
+   * Protects bufStats while it is being summed up
+	 */
+  std::mutex statsLatch;
+
+	/**
+   * Background writer thread, not joinable unless the writer runs
+	 */
+  std::thread writerThread;
+
+	/**
+   * Held by the background writer while it may have frames locked for writing.  Taken before any shard latch
+   * by operations that must not find frames locked by the writer (flushFile(), disposePage()).
+	 */
+  std::mutex writerLatch;
+
+	/**
+   * Protects writerStop; the writer sleeps on writerWake between passes
+	 */
+  std::mutex writerWaitLatch;
+  std::condition_variable writerWake;
+  bool writerStop;
+
+	/**
+   * Number of frames the background writer keeps clean ahead of eviction, over all shards
+	 */
+  std::uint32_t writerCleanFrames;
+
+	/**
+   * Maximum number of pages of one shard the background writer writes per pass
+	 */
+  std::uint32_t writerBatch;
+
+	/**
+   * Time the background writer sleeps between passes unless an eviction had to write a dirty page
+	 */
+  std::chrono::milliseconds writerInterval;
+
+	/**
+   * Maximum read-ahead window in pages, 0 if read-ahead is off
+	 */
+  std::atomic<std::uint32_t> readAheadMax;
+
+	/**
+   * Read-ahead state by File::id(), protected by readAheadLatch
+	 */
+  std::unordered_map<std::uint32_t, ReadAheadState> readAheadStates;
+  std::mutex readAheadLatch;
+
+	/**
+   * Pages waiting to be read ahead by prefetchThread, protected by prefetchQueueLatch.  The prefetcher sleeps on
+   * prefetchWake while the queue is empty.
+	 */
+  std::deque<std::pair<File*, PageId> > prefetchQueue;
+  std::mutex prefetchQueueLatch;
+  std::condition_variable prefetchWake;
+  bool prefetchStop;
+
+	/**
+   * Held by the prefetcher while it reads a page it took from the queue.  Taken after prefetchQueueLatch and
+   * before any shard latch.
+	 */
+  std::mutex prefetchLatch;
+
+	/**
+   * Thread reading pages ahead, not joinable unless read-ahead is on
+	 */
+  std::thread prefetchThread;
+
+	/**
+   * Read-ahead window of a file at the start of a sequential run
+	 */
+  static const std::uint32_t READ_AHEAD_MIN = 4;
+
+	/**
+   * Most queued pages of one file the prefetch thread reads together
+	 */
+  static const std::uint32_t PREFETCH_BATCH = 32;
+
+	/**
+   * Microseconds readPage() and allocPage() wait for a frame when all are pinned, 0 if they fail at once
+	 */
+  std::atomic<long long> frameWaitMicros;
+
+	/**
+   * Optimistic reads of a page tried by readOptimistic() before it falls back to the shared latch
+	 */
+  static const std::uint32_t OPTIMISTIC_ATTEMPTS = 8;
+
+	/**
+   * Most pages written back together when a dirty page is evicted, see clusterDirty()
+	 */
+  static const std::uint32_t WRITE_CLUSTER = 32;
+
+	/**
+	 * Returns the shard responsible for caching the given page.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @return 				Shard owning the page
+	 */
+  BufShard& shardFor(const File* file, const PageId pageNo);
+
+	/**
+	 * Looks up the frame holding a page in the table of its shard.  Unless the shard uses a lock-free page table
+	 * the latch of the shard must be held by the caller.
+	 *
+	 * @param shard   Shard owning the page
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param frameNo Frame number of the page, returned via this reference
+	 * @return 				True if the page is in the buffer pool
+	 */
+  bool lookupFrame(BufShard& shard, const File* file, const PageId pageNo, FrameId& frameNo);
+
+	/**
+	 * Pins the frame holding a page without taking the latch of its shard, using the lock-free page table.
+	 *
+	 * @param shard   Shard owning the page
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param frameNo Frame number of the pinned page, returned via this reference
+	 * @return 				True if the page was resident and has been pinned; false if the caller must retry under the latch
+	 */
+  bool pinResident(BufShard& shard, const File* file, const PageId pageNo, FrameId& frameNo);
+
+	/**
+	 * Inserts a page into the table of its shard and the list of frames of its file.  The latch of the shard must
+	 * be held by the caller.
+	 */
+  void insertFrame(BufShard& shard, const File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * Removes a page from the table of its shard and the list of frames of its file.  The latch of the shard must
+	 * be held by the caller.
+	 */
+  void removeFrame(BufShard& shard, const File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * Appends the frames of a shard holding pages of the file to frames.  The latch of the shard must be held by
+	 * the caller.
+	 */
+  void framesOfFile(const BufShard& shard, const File* file, std::vector<FrameId>& frames) const;
+
+	/**
+	 * Allocate a free frame from the given shard, evicting the page chosen by the replacement policy of the shard
+	 * if there is no free one.  The latch of the shard must be held by the caller.
+	 * The frame is returned locked (see BufDesc::TryLock()) and has to be released with BufDesc::Set() or
+	 * BufDesc::Clear().
+	 *
+	 * @param shard   Shard to allocate the frame from
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @return 				False if no such buffer is found which can be allocated
+	 */
+  bool allocBuf(BufShard& shard, FrameId & frame);
+
+	/**
+	 * Returns true if a frame is beyond the frames in use by its shard, because resize() is taking it away.  Pages
+	 * in such a frame must not be pinned again.
+	 */
+  bool removing(const BufShard& shard, const FrameId frameNo) const
+  {
+    return frameNo >= shard.firstFrame + shard.numFrames.load();
+  }
+
+	/**
+	 * Looks up the frame holding a page like lookupFrame(), but if the frame is being taken away by resize(), waits
+	 * until the page has left it.  The latch of the shard must be held through guard, and is released while waiting.
+	 *
+	 * @return 				True if the page is in a frame in use
+	 */
+  bool lookupActive(BufShard& shard, std::unique_lock<std::mutex>& guard, const File* file, const PageId pageNo,
+                    FrameId& frameNo);
+
+	/**
+	 * Gives a shard the given number of frames, evicting the pages of frames taken away, and builds a new replacement
+	 * policy for them.  The latch of the shard must be held through guard; it is released while pages pinned in
+	 * frames taken away are waited for.
+	 */
+  void resizeShard(BufShard& shard, std::unique_lock<std::mutex>& guard, const std::uint32_t frames);
+
+	/**
+	 * Writes back the page held by a locked, valid frame if it is dirty and takes it out of the table of its shard,
+	 * without telling the replacement policy.  The latch of the shard must be held by the caller.
+	 * Dirty unpinned pages next to a dirty page in the file are written back along with it.
+	 */
+  void dropPage(BufShard& shard, const FrameId frame);
+
+	/**
+	 * Locks the frames holding the dirty, unpinned pages of the file which directly precede and follow the page of a
+	 * locked frame, up to WRITE_CLUSTER pages in all, and adds them to cluster.  Pages of other shards are only
+	 * found if those use lock-free page tables.  The latch of the shard must be held by the caller.
+	 */
+  void clusterDirty(BufShard& shard, const FrameId frame, std::vector<FrameId>& cluster);
+
+	/**
+	 * Unlocks the frames clusterDirty() added to cluster, all but frame, and wakes the threads waiting for frames of
+	 * their shards
+	 */
+  void unlockCluster(const std::vector<FrameId>& cluster, const FrameId frame);
+
+	/**
+	 * Writes out the dirty pages of frames which the caller keeps from changing, such as locked frames, with one
+	 * File::writePages() call per file, and unsets their dirty flags.  Sorts frames by file and page number.
+	 */
+  void writeBack(std::vector<FrameId>& frames);
+
+	/**
+	 * Evicts the page held by a locked, valid frame, writing it back if it is dirty.  The latch of the shard must
+	 * be held by the caller.
+	 *
+	 * @param shard   Shard owning the frame
+	 * @param frame   Frame to evict
+	 */
+  void evictFrame(BufShard& shard, const FrameId frame);
+
+	/**
+	 * Allocate a frame of the given shard for a scan: reuse the oldest frame of the ring in the shard once the
+	 * ring holds its share of frames of the shard, otherwise take one with allocBuf() and add it to the ring.
+	 * The latch of the shard must be held by the caller, and the frame is returned locked like by allocBuf().
+	 *
+	 * @param shard   Shard to allocate the frame from
+	 * @param ring    Ring of the scan
+	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+	 * @return 				False if no such buffer is found which can be allocated
+	 */
+  bool allocRingBuf(BufShard& shard, ScanRing& ring, FrameId& frame);
+
+	/**
+	 * Takes a frame of the shard for a new page like allocBuf(), waiting for one as set by setFrameWait() if all
+	 * are pinned.  The latch of the shard must be held through guard, and is released while waiting.
+	 *
+	 * @param shard   Shard to take the frame from
+	 * @param guard   Guard holding the latch of the shard
+	 * @param frameNo Locked frame, returned via this reference
+   * @throws  BufferExceededException If no frame became available in time
+	 */
+  void takeFrame(BufShard& shard, std::unique_lock<std::mutex>& guard, FrameId& frameNo);
+
+	/**
+	 * Makes a page just allocated in a file into a locked frame of the shard resident and pinned.  The latch of the
+	 * shard must be held by the caller.
+	 *
+	 * @param shard   Shard owning the frame
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 * @param frameNo Frame holding the page
+	 */
+  void loadAllocated(BufShard& shard, File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * Unpins the frame holding a page, if the page is in the buffer pool.  Unless the shard uses a lock-free page
+	 * table and a latch-free policy the latch of the shard must be held by the caller.
+	 *
+	 * @param shard   Shard owning the page
+	 * @param file   	File object
+	 * @param pageNo  Page number
+	 * @param dirty		True if the page needs to be marked dirty
+	 * @param frameNo Frame number of the page, returned via this reference
+	 * @return 				False if the page is in the buffer pool but not pinned
+	 */
+  bool unPinFrame(BufShard& shard, File* file, const PageId pageNo, const bool dirty, FrameId& frameNo);
+
+	/**
+	 * Gives up one pin on a frame.  Unless the shard uses a lock-free page table and a latch-free policy the latch
+	 * of the shard must be held by the caller.
+	 *
+	 * @param shard   Shard owning the frame
+	 * @param frameNo Frame to unpin
+	 * @param dirty		True if the page needs to be marked dirty
+	 * @return 				False if the frame is not pinned
+	 */
+  bool releasePin(BufShard& shard, const FrameId frameNo, const bool dirty);
+
+	/**
+	 * Gives up the pin of a PageHandle, taking the latch of the shard if needed.
+	 *
+	 * @param shard   Shard owning the frame
+	 * @param frameNo Frame to unpin
+	 * @return 				False if the frame is not pinned
+	 */
+  bool unPinHandle(BufShard& shard, const FrameId frameNo);
+
+	/**
+	 * Wakes the threads waiting for a frame of the shard, if there are any, after a frame was unpinned, unlocked or
+	 * cleared.  Does not need the latch of the shard, so it may be called holding the latch of any shard.
+	 *
+	 * @param shard   Shard the frame belongs to
+	 */
+  void notifyFrameWaiters(BufShard& shard);
+
+	/**
+	 * Pins the frame holding a page, reading the page into a frame first if it is not in the buffer pool.  This is
+	 * tryReadPage() without the pointer to the page.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file to be read
+	 * @param ring  	Access strategy of a large scan, or NULL
+	 * @param shardOf Shard owning the frame, returned via this reference
+	 * @param frameNo Frame holding the page on HIT or MISS, returned via this reference
+	 * @return 				HIT or MISS on success, INVALID_PAGE or BUFFER_EXCEEDED on failure
+	 */
+  PageStatus pinFrame(File* file, const PageId pageNo, ScanRing* ring, BufShard*& shardOf, FrameId& frameNo);
+
+	/**
+	 * Allocates a new page in the file into a pinned frame.  This is allocPage() without the pointer to the page.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  The number assigned to the page in the file is returned via this reference
+	 * @param shardOf Shard owning the frame, returned via this reference
+	 * @param frameNo Frame holding the page, returned via this reference
+	 * @throws  BufferExceededException If no frame can be allocated for the page
+	 */
+  void allocFrame(File* file, PageId& pageNo, BufShard*& shardOf, FrameId& frameNo);
+
+	/**
+	 * Orders the pages of a batch by shard, keeping their order within each shard.
+	 *
+	 * @param file   	File object
+	 * @param pageNos Page numbers of the batch
+	 * @param count   Number of pages in the batch
+	 * @param order   Indexes into pageNos in the order to visit them, returned via this reference
+	 * @param shardOf Shard of every page of the batch, returned via this reference
+	 */
+  void groupByShard(const File* file, const PageId* pageNos, const std::uint32_t count,
+                    std::vector<std::uint32_t>& order, std::vector<BufShard*>& shardOf);
+
+	/**
+	 * Reads the pages of a batch that missed in one shard.  Frames are allocated for all of them first, then
+	 * each run of consecutive page numbers is read with one File::tryReadPages() call.  The latch of the shard
+	 * must be held by the caller.
+	 *
+	 * @param shard   Shard owning the pages
+	 * @param file   	File object
+	 * @param pageNos Page numbers of the batch
+	 * @param misses  Indexes into pageNos of the pages to read, in page order
+	 * @param pages  	Pages of the batch, set for the pages read
+	 * @param statuses  Statuses of the batch, set for all pages in misses
+	 */
+  void readMisses(BufShard& shard, File* file, const PageId* pageNos, const std::vector<std::uint32_t>& misses,
+                  Page** pages, PageStatus* statuses);
+
+	/**
+	 * Body of the background writer thread: runs writeBehind() over all shards until stopped.  Errors are reported
+	 * on std::cerr and never end the thread.
+	 */
+  void runWriter();
+
+	/**
+	 * Writes out the dirty, unpinned pages among the next victims of a shard.  Each frame is locked while its page
+	 * is written, so the latch of the shard is only held to ask the policy for the victims.
+	 *
+	 * @param shard   Shard to clean
+	 * @param frames  Scratch vector for the victims
+	 */
+  void writeBehind(BufShard& shard, std::vector<FrameId>& frames);
+
+	/**
+	 * Records a request for a page for sequential read-ahead and queues the pages following it if the request
+	 * continues a sequential run.  Called without any latch held.
+	 *
+	 * @param file   	File object
+	 * @param pageNo  Page number in the file
+	 */
+  void noteAccess(File* file, const PageId pageNo);
+
+	/**
+	 * Tells the replacement policy about a hit on a page that has just been pinned.  Counts the first request for
+	 * a page that was read ahead, widening the read-ahead window of its file, and takes a page out of its
+	 * ScanRing when it is requested without one.
+	 *
+	 * @param shard   Shard owning the frame
+	 * @param frameNo Frame that has just been pinned
+	 * @param ring    Ring the page was requested through, or NULL
+	 */
+  void noteHit(BufShard& shard, const FrameId frameNo, const ScanRing* ring);
+
+	/**
+	 * Grows the read-ahead window of a file by one page if a page read ahead was used, halves it otherwise.
+	 */
+  void adjustReadAhead(const File* file, const bool used);
+
+	/**
+	 * Body of the prefetch thread: reads the queued pages until stopped.
+	 */
+  void runPrefetcher();
+
+	/**
+	 * Reads pages of a file into unpinned frames unless they are in the buffer pool already, submitting all reads
+	 * together.  Pages which are no longer ahead of the reader of their file, which do not exist or for which no
+	 * frame can be allocated are skipped.
+	 */
+  void prefetchPages(File* file, std::vector<PageId>& pageNos);
+
+ public:
+	/**
+   * Actual buffer pool from which frames are allocated
+	 */
+  Page* bufPool;
+
+	/**
+   * Constructor of BufMgr class
+	 *
+	 * @param bufs    Number of frames in the buffer pool
+	 * @param shardCount  Number of shards the frames are partitioned into.  With more than one shard, threads
+	 *                    reading pages of different shards do not block each other, but a page can only be cached
+	 *                    in one of the bufs/shardCount frames of its own shard.
+	 * @param policy  Replacement policy used by every shard.  Resident pages are only pinned without the latch of
+	 *                their shard if the policy is latch-free (see ReplacementPolicy::isLatchFree()).
+	 * @param pages   Kind of memory pages to map the buffer pool with, falling back to smaller ones when they are
+	 *                not available (see PageArena)
+	 * @param prefault  True to touch all memory of the buffer pool in the constructor rather than when frames are
+	 *                  first used
+	 * @param maxBufs  Number of frames resize() may grow the buffer pool to, or 0 for bufs.  Address space for all
+	 *                 of them is reserved up front, but memory is only used by frames in use (unless prefaulted).
+	 */
+  BufMgr(std::uint32_t bufs, std::uint32_t shardCount = 1, PolicyKind policy = PolicyKind::CLOCK,
+         ArenaPages pages = ArenaPages::TRANSPARENT_HUGE, bool prefault = false, std::uint32_t maxBufs = 0);
+	
+	/**
+   * Destructor of BufMgr class.  Writes back the dirty pages of files which are still open; since it cannot throw,
+   * a failed write is only reported on std::cerr, and flushFile() should be called first to have it thrown.
+	 */
+  ~BufMgr();
+
+	/**
+	 * Starts a background writer thread which writes out dirty, unpinned pages shortly before the replacement
+	 * policy would evict them, so that readPage() and allocPage() mostly find clean victims.  Restarts the writer
+	 * with the new settings if it is running already.  Not threadsafe with stopBackgroundWriter().
+	 *
+	 * @param cleanFrames  Number of next victims, over all shards, kept clean
+	 * @param batchSize    Maximum number of pages of one shard written per pass
+	 * @param intervalMs   Milliseconds between passes; a pass starts early when an eviction has to write
+	 */
+  void startBackgroundWriter(std::uint32_t cleanFrames, std::uint32_t batchSize = 32, std::uint32_t intervalMs = 10);
+
+	/**
+	 * Stops the background writer thread, if it runs, and waits for it to finish its pass.
+	 */
+  void stopBackgroundWriter();
+
+	/**
+	 * Makes readPage(), tryReadPage() and allocPage() wait for a frame to be unpinned when every frame a page could
+	 * be placed in is pinned, instead of failing at once.  Threads waiting for a frame of the same shard get one in
+	 * the order they started waiting.  A request fails with BufferExceededException (or BUFFER_EXCEEDED) once it
+	 * waited for timeout.  readPages() and read-ahead never wait.  Threads which wait while holding pins can block
+	 * each other until the timeout if their pins together fill the shard.
+	 *
+	 * @param timeout  Longest time a request waits for a frame; 0, the default, makes requests fail at once
+	 */
+  void setFrameWait(std::chrono::microseconds timeout);
+
+	/**
+	 * Changes the number of frames of the buffer pool while other operations go on, keeping the pages cached in
+	 * frames that stay.  Every shard keeps its share of the frames.
+	 *
+	 * Growing adds frames the replacement policy hands out to missing pages; the tables mapping pages to frames
+	 * grow incrementally.  Shrinking takes frames away from the end of every shard: their unpinned pages are
+	 * evicted, and pages pinned in them are evicted once they are unpinned.  Only requests for those pages wait
+	 * meanwhile, and then read them into a frame that stays.  Replacement policies start over with the pages cached
+	 * when a shard is resized.
+	 *
+	 * @param newBufs Number of frames wanted; at least one per shard, and at most maxBufs as passed to the
+	 *                constructor
+	 * @return 				Number of frames of the buffer pool afterwards
+	 */
+  std::uint32_t resize(std::uint32_t newBufs);
+
+	/**
+   * Returns the number of frames of the buffer pool
+	 */
+  std::uint32_t getNumBufs() const
+  {
+    return numBufs.load();
+  }
+
+	/**
+	 * Turns on sequential read-ahead.  When a page of a file is requested right after the page before it, a
+	 * prefetch thread reads the following pages into unpinned frames.  The window of pages read ahead starts at
+	 * READ_AHEAD_MIN pages for every file, grows by one for each page read ahead that is then requested, up to
+	 * maxPages, and is halved whenever a page read ahead is evicted unused.  Pages read ahead are evicted before
+	 * requested ones (see ReplacementPolicy::onLoadCold()).  Not threadsafe with stopReadAhead().
+	 *
+	 * @param maxPages  Maximum read-ahead window in pages
+	 */
+  void startReadAhead(std::uint32_t maxPages = 32);
+
+	/**
+	 * Turns off sequential read-ahead and waits for the prefetch thread to finish the page it is reading.
+	 */
+  void stopReadAhead();
+
+	/**
+	 * Reads the given page from the file into a frame and returns the pointer to page.
+	 * If the requested page is already present in the buffer pool pointer to that frame is returned
+	 * otherwise a new frame is allocated from the buffer pool for reading the page.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+	 * @param ring  	Access strategy of a large scan, or NULL.  If given and the page is not in the buffer pool, it is
+	 *              	read into a frame of the ring (see ScanRing).
+   * @throws  InvalidPageException If the page does not exist in the file or is not in use
+   * @throws  BufferExceededException If the page is not in the buffer pool and no frame can be allocated for it
+	 */
+  void readPage(File* file, const PageId PageNo, Page*& page, ScanRing* ring = NULL);
+
+	/**
+	 * Like readPage(), but returns a handle which unpins the page when it is destroyed, instead of a pointer that has
+	 * to be paired with unPinPage().
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param ring  	Access strategy of a large scan, or NULL
+	 * @return 				Handle holding a pin on the page
+   * @throws  InvalidPageException If the page does not exist in the file or is not in use
+   * @throws  BufferExceededException If the page is not in the buffer pool and no frame can be allocated for it
+	 */
+  PageHandle readPage(File* file, const PageId PageNo, ScanRing* ring = NULL);
+
+	/**
+	 * Reads a page without pinning or latching it if it is resident and the shard uses a lock-free page table, so
+	 * that threads reading the same page do not write to any shared cache line.  read is called on the frame holding
+	 * the page and the read is accepted if the version of the frame latch did not change meanwhile.  After a few
+	 * failed attempts, or if the page is not resident, the page is pinned like by readPage() and read under the
+	 * shared latch instead.
+	 *
+	 * read may be called several times and on a page being modified, and must only keep the outcome of its last
+	 * call.  An exception it throws on a page that changed meanwhile is ignored.  Reads that succeed without a pin
+	 * are not counted in the buffer statistics and are not seen by the replacement policy.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param read  	Function reading the page
+	 * @return 				True if the page was read without a pin, false if it was pinned
+   * @throws  InvalidPageException If the page does not exist in the file or is not in use
+   * @throws  BufferExceededException If the page is not in the buffer pool and no frame can be allocated for it
+	 */
+  bool readOptimistic(File* file, const PageId PageNo, const std::function<void(const Page&)>& read);
+
+	/**
+	 * Like readPage(), but reports failures through the returned status instead of throwing, so that neither hits
+	 * nor misses pay for an exception.  The page is pinned unless an error status is returned.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number in the file to be read
+	 * @param page  	Reference to page pointer, set to the frame holding the page on HIT or MISS
+	 * @param ring  	Access strategy of a large scan, or NULL
+	 * @return 				HIT or MISS on success, INVALID_PAGE or BUFFER_EXCEEDED on failure
+	 */
+  PageStatus tryReadPage(File* file, const PageId PageNo, Page*& page, ScanRing* ring = NULL);
+
+	/**
+	 * Reads several pages of a file, like readPage() on each of them, but looks up all pages of a shard under
+	 * one latch and reads pages that are not in the buffer pool in page order, with one read for each run of
+	 * consecutive page numbers.  A page listed more than once is pinned once per listing.  If any page cannot be
+	 * read, none is left pinned.
+	 *
+	 * @param file   	File object
+	 * @param pageNos Page numbers to read
+	 * @param count   Number of pages to read
+	 * @param pages  	Array of count page pointers, set to the frame holding each page
+   * @throws  InvalidPageException If a page does not exist in the file or is not in use
+   * @throws  BufferExceededException If no frame can be allocated for a page that is not in the buffer pool
+	 */
+  void readPages(File* file, const PageId* pageNos, const std::uint32_t count, Page** pages);
+
+	/**
+	 * Like readPages(), but reports the outcome for every page through statuses instead of throwing.  Pages
+	 * that could be read stay pinned even if others could not.
+	 *
+	 * @param file   	File object
+	 * @param pageNos Page numbers to read
+	 * @param count   Number of pages to read
+	 * @param pages  	Array of count page pointers, set to the frame holding each page or NULL on failure
+	 * @param statuses  Array of count statuses, as returned by tryReadPage() for each page
+	 */
+  void tryReadPages(File* file, const PageId* pageNos, const std::uint32_t count, Page** pages, PageStatus* statuses);
+
+	/**
+	 * Unpin a page from memory since it is no longer required for it to remain in memory.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 * @param dirty		True if the page to be unpinned needs to be marked dirty	
+   * @throws  PageNotPinnedException If the page is not already pinned
+	 */
+  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+
+	/**
+	 * Unpins several pages of a file, like unPinPage() on each of them, taking the latch of each shard at most
+	 * once.  All pages are unpinned even if some of them are not pinned.
+	 *
+	 * @param file   	File object
+	 * @param pageNos Page numbers to unpin
+	 * @param count   Number of pages to unpin
+	 * @param dirty		True if the pages need to be marked dirty
+   * @throws  PageNotPinnedException If a page is not pinned, reporting the first one found
+	 */
+  void unPinPages(File* file, const PageId* pageNos, const std::uint32_t count, const bool dirty);
+
+	/**
+	 * Allocates a new, empty page in the file and returns the Page object.
+	 * The newly allocated page is also assigned a frame in the buffer pool.  With one shard, the file places the
+	 * page straight into the frame.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+	 */
+  void allocPage(File* file, PageId &PageNo, Page*& page);
+
+	/**
+	 * Like allocPage(), but returns a handle which unpins the new page when it is destroyed.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+	 * @return 				Handle holding a pin on the new page
+	 */
+  PageHandle allocPage(File* file, PageId &PageNo); 
+
+	/**
+	 * Writes out all dirty pages of the file to disk, in the order of their page numbers, and removes all pages of
+	 * the file from the buffer pool.  Only the frames holding pages of the file are looked at.
+	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
+	 * Otherwise Error returned, and no page of the file is written or removed.
+	 *
+	 * @param file   	File object
+   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
+   * @throws BadBufferException If any frame allocated to the file is found to be invalid
+	 */
+  void flushFile(const File* file);
+
+	/**
+	 * Delete page from file and also from buffer pool if present.
+	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
+	 *
+	 * @param file   	File object
+	 * @param PageNo  Page number
+	 */
+  void disposePage(File* file, const PageId PageNo);
+
+	/**
+   * Print member variable values. 
+	 */
+  void  printSelf();
+
+	/**
+   * Get buffer pool usage statistics
+	 */
+  BufStats & getBufStats();
+
+	/**
+   * Count the pages of a file held in the buffer pool, looking only at the frames holding them
+	 *
+	 * @param file   	File object
+	 * @param dirty   Number of those pages which are dirty, returned via this reference
+	 * @return 				Number of pages of the file in the buffer pool
+	 */
+  std::uint32_t getFilePages(const File* file, std::uint32_t& dirty);
+
+	/**
+   * Get the kind of memory pages the buffer pool is mapped with
+	 */
+  ArenaPages getPoolPages() const
+  {
+    return arena->pages();
+  }
+
+	/**
+   * Clear buffer pool usage statistics
+	 */
+  void clearBufStats();
 };
 
 }
@@ -0,0 +1,214 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "clock_policy.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The sweep reads and clears reference bits with plain, vectorized memory
+// accesses.  ThreadSanitizer builds use atomic accesses one frame at a time
+// instead, so that they only report real races.
+#if defined(__SSE2__) && !defined(__SANITIZE_THREAD__)
+#define CLOCK_SWEEP_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace badgerdb {
+
+const std::uint32_t ClockPolicy::SWEEP_WIDTH;
+
+namespace {
+
+/**
+ * Returns a mask of the lowest count bits.
+ */
+inline std::uint64_t lowBits(const std::uint32_t count) {
+  return count >= 64 ? ~static_cast<std::uint64_t>(0)
+                     : (static_cast<std::uint64_t>(1) << count) - 1;
+}
+
+/**
+ * Returns the index of the lowest set bit of a non-zero mask.
+ */
+inline std::uint32_t lowestBit(const std::uint64_t mask) {
+  return __builtin_ctzll(mask);
+}
+
+}
+
+ClockPolicy::ClockPolicy(const FrameId firstFrame,
+                         const std::uint32_t numFrames,
+                         const std::atomic<int>* pinCounts)
+    : first_frame_(firstFrame),
+      num_frames_(numFrames),
+      hand_(firstFrame + numFrames - 1),
+      ref_bits_(new std::atomic<std::uint8_t>[numFrames + SWEEP_WIDTH]),
+      pin_counts_(pinCounts) {
+  for (std::uint32_t i = 0; i < num_frames_ + SWEEP_WIDTH; ++i) {
+    ref_bits_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+ClockPolicy::~ClockPolicy() {
+  delete[] ref_bits_;
+}
+
+std::uint64_t ClockPolicy::referenced(const std::uint32_t index) const {
+#ifdef CLOCK_SWEEP_SIMD
+  // The bytes are read without atomic loads, and cleared with memset() by the
+  // sweep: std::atomic<std::uint8_t> has the layout of a plain byte, and a
+  // hit racing with the sweep may be lost either way.
+  const std::uint8_t* bytes =
+      reinterpret_cast<const std::uint8_t*>(ref_bits_ + index);
+  std::uint64_t clear = 0;
+  const __m128i zero = _mm_setzero_si128();
+  for (std::uint32_t i = 0; i < SWEEP_WIDTH; i += 16) {
+    const __m128i group =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+    clear |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(group, zero))))
+             << i;
+  }
+  return ~clear;
+#else
+  std::uint64_t set = 0;
+  for (std::uint32_t i = 0; i < SWEEP_WIDTH; ++i) {
+    if (ref_bits_[index + i].load(std::memory_order_relaxed) != 0) {
+      set |= static_cast<std::uint64_t>(1) << i;
+    }
+  }
+  return set;
+#endif
+}
+
+std::uint64_t ClockPolicy::pinned(const std::uint32_t index,
+                                  const std::uint32_t width) const {
+  if (pin_counts_ == NULL) {
+    return 0;
+  }
+  const std::atomic<int>* pins = pin_counts_ + first_frame_ + index;
+  std::uint64_t set = 0;
+  std::uint32_t i = 0;
+#ifdef CLOCK_SWEEP_SIMD
+  // Like the reference bits, the pin counts are read without atomic loads;
+  // std::atomic<int> has the layout of a plain int.
+  const int* counts = reinterpret_cast<const int*>(pins);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= width; i += 4) {
+    const __m128i group =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + i));
+    const int unpinned =
+        _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(group, zero)));
+    set |= static_cast<std::uint64_t>(~unpinned & 0xf) << i;
+  }
+#endif
+  for (; i < width; ++i) {
+    if (pins[i].load(std::memory_order_relaxed) != 0) {
+      set |= static_cast<std::uint64_t>(1) << i;
+    }
+  }
+  return set;
+}
+
+void ClockPolicy::onHit(const FrameId frame) {
+  // Hot pages are hit over and over; only write the bit if it changes, so
+  // that concurrent readers of the same page do not bounce its cache line.
+  std::atomic<std::uint8_t>& ref = ref_bits_[frame - first_frame_];
+  if (!ref.load(std::memory_order_relaxed)) {
+    ref.store(1, std::memory_order_relaxed);
+  }
+}
+
+bool ClockPolicy::pickVictim(const TakeFrame& take, FrameId& frame) {
+  // Clearing a reference bit does not count as a failed attempt: after one
+  // full sweep all bits are clear, and only pinned frames are left over.
+  // Passing a pinned frame whose bit is clear does.
+  std::uint32_t failed = 0;
+  std::uint32_t index = hand_ - first_frame_ + 1;
+  while (failed < num_frames_) {
+    if (index == num_frames_) {
+      index = 0;
+    }
+    // Most sweeps stop at the frame right after the hand.
+    if (ref_bits_[index].load(std::memory_order_relaxed) != 0 ||
+        (pin_counts_ != NULL &&
+         pin_counts_[first_frame_ + index].load(std::memory_order_relaxed) != 0)) {
+      const std::uint32_t width = std::min(SWEEP_WIDTH, num_frames_ - index);
+      const std::uint64_t clear = ~referenced(index) & lowBits(width);
+      // Pins only matter for frames whose bit is clear.
+      const std::uint64_t busy = clear != 0 ? pinned(index, width) : 0;
+      const std::uint64_t candidates = clear & ~busy;
+      // The hand passes every frame up to the first unpinned one with a clear
+      // bit, and clears them all; the bits that are clear already stay so.
+      const std::uint32_t passed =
+          candidates != 0 ? lowestBit(candidates) : width;
+      failed += __builtin_popcountll(clear & busy & lowBits(passed));
+#ifdef CLOCK_SWEEP_SIMD
+      std::memset(static_cast<void*>(ref_bits_ + index), 0, passed);
+#else
+      for (std::uint32_t i = 0; i < passed; ++i) {
+        ref_bits_[index + i].store(0, std::memory_order_relaxed);
+      }
+#endif
+      if (candidates == 0) {
+        hand_ = first_frame_ + index + width - 1;
+        index += width;
+        continue;
+      }
+      index += passed;
+    }
+    hand_ = first_frame_ + index;
+    if (take(hand_)) {
+      frame = hand_;
+      return true;
+    }
+    ++failed;
+    ++index;
+  }
+  return false;
+}
+
+void ClockPolicy::nextVictims(const std::uint32_t count,
+                              std::vector<FrameId>& frames) const {
+  // Frames whose reference bit is clear are taken in the current sweep, the
+  // others in the next one.
+  std::uint32_t listed = 0;
+  for (int sweep = 0; sweep < 2; ++sweep) {
+    FrameId frame = hand_;
+    for (std::uint32_t i = 0; i < num_frames_ && listed < count; ++i) {
+      frame = frame < first_frame_ + num_frames_ - 1 ? frame + 1 : first_frame_;
+      const bool ref =
+          ref_bits_[frame - first_frame_].load(std::memory_order_relaxed) != 0;
+      if (ref == (sweep == 1)) {
+        frames.push_back(frame);
+        ++listed;
+      }
+    }
+  }
+}
+
+void ClockPolicy::onEvict(const FrameId frame) {
+  ref_bits_[frame - first_frame_].store(0, std::memory_order_relaxed);
+}
+
+void ClockPolicy::onLoad(const FrameId frame, const File* file,
+                         const PageId pageNo) {
+  ref_bits_[frame - first_frame_].store(1, std::memory_order_relaxed);
+}
+
+void ClockPolicy::onLoadCold(const FrameId frame, const File* file,
+                             const PageId pageNo) {
+  // Taken by the next sweep unless it is requested before.
+  ref_bits_[frame - first_frame_].store(0, std::memory_order_relaxed);
+}
+
+void ClockPolicy::onRemove(const FrameId frame) {
+  ref_bits_[frame - first_frame_].store(0, std::memory_order_relaxed);
+}
+
+}
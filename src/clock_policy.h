@@ -0,0 +1,104 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Clock replacement.
+ *
+ * Each frame has a reference bit which is set whenever its page is loaded or
+ * requested.  The clock hand sweeps over the frames, clearing set bits, and
+ * takes the first frame whose bit is clear and which is not pinned.
+ *
+ * Reference bits are kept in one dense array of bytes apart from the frame
+ * descriptors, so the sweep looks at SWEEP_WIDTH frames at a time (with SSE2
+ * where available) and only touches the descriptor of a frame it tries to
+ * take.  Given the dense pin counts of the buffer manager, the sweep also
+ * skips pinned frames SWEEP_WIDTH at a time instead of trying to take them.
+ *
+ * Reference bits are atomic, so hits can be recorded without the shard latch.
+ */
+class ClockPolicy : public ReplacementPolicy {
+ public:
+  ClockPolicy(const FrameId firstFrame, const std::uint32_t numFrames,
+              const std::atomic<int>* pinCounts = NULL);
+  ~ClockPolicy();
+
+  const char* name() const { return "CLOCK"; }
+  bool isLatchFree() const { return true; }
+  void onHit(const FrameId frame);
+  bool pickVictim(const TakeFrame& take, FrameId& frame);
+  void onEvict(const FrameId frame);
+  void onLoad(const FrameId frame, const File* file, const PageId pageNo);
+  void onLoadCold(const FrameId frame, const File* file,
+                  const PageId pageNo);
+  void onRemove(const FrameId frame);
+  void nextVictims(const std::uint32_t count,
+                   std::vector<FrameId>& frames) const;
+
+ private:
+  /**
+   * Number of frames the sweep looks at at a time.
+   */
+  static const std::uint32_t SWEEP_WIDTH = 64;
+
+  /**
+   * Returns a mask with bit i set if the reference bit of the frame i places
+   * after the given index is set, for the SWEEP_WIDTH frames from index on.
+   * Bits for indices past the last frame are undefined.
+   *
+   * @param index   Index of the first frame, relative to first_frame_.
+   */
+  std::uint64_t referenced(const std::uint32_t index) const;
+
+  /**
+   * Returns a mask with bit i set if the frame i places after the given index
+   * is pinned or locked, for the width frames from index on, or 0 without pin
+   * counts.
+   *
+   * @param index   Index of the first frame, relative to first_frame_.
+   * @param width   Number of frames, at most SWEEP_WIDTH.
+   */
+  std::uint64_t pinned(const std::uint32_t index,
+                       const std::uint32_t width) const;
+
+  /**
+   * First frame managed by the policy.
+   */
+  const FrameId first_frame_;
+
+  /**
+   * Number of frames managed by the policy.
+   */
+  const std::uint32_t num_frames_;
+
+  /**
+   * Current position of the clock hand.
+   */
+  FrameId hand_;
+
+  /**
+   * Reference bit of every frame, indexed by frame - first_frame_: 1 if set,
+   * 0 if clear.  Followed by SWEEP_WIDTH bytes of padding, so the sweep can
+   * read SWEEP_WIDTH bytes from any frame on.
+   */
+  std::atomic<std::uint8_t>* ref_bits_;
+
+  /**
+   * Pin counts of all frames, indexed by frame, or NULL.  Only a hint: the
+   * frames the sweep stops at are still taken through TakeFrame.
+   */
+  const std::atomic<int>* pin_counts_;
+};
+
+}
@@ -0,0 +1,301 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "clock_pro_policy.h"
+
+namespace badgerdb {
+
+ClockProPolicy::ClockProPolicy(const FrameId firstFrame,
+                               const std::uint32_t numFrames)
+    : first_frame_(firstFrame),
+      num_frames_(numFrames),
+      cold_target_(numFrames / 10 > 0 ? numFrames / 10 : 1),
+      num_hot_(0),
+      num_cold_(0),
+      hot_hand_(clock_.end()),
+      cold_hand_(clock_.end()),
+      test_hand_(clock_.end()),
+      frames_(numFrames, clock_.end()) {
+  for (std::uint32_t i = 0; i < numFrames; ++i) {
+    free_.insert(first_frame_ + i);
+  }
+}
+
+void ClockProPolicy::advance(Clock::iterator& hand) {
+  ++hand;
+  if (hand == clock_.end()) {
+    hand = clock_.begin();
+  }
+}
+
+void ClockProPolicy::moveHandsPast(const Clock::iterator entry) {
+  if (hot_hand_ == entry) {
+    advance(hot_hand_);
+  }
+  if (cold_hand_ == entry) {
+    advance(cold_hand_);
+  }
+  if (test_hand_ == entry) {
+    advance(test_hand_);
+  }
+}
+
+ClockProPolicy::Clock::iterator ClockProPolicy::insertAtHead(
+    const Entry& entry) {
+  if (clock_.empty()) {
+    clock_.push_back(entry);
+    hot_hand_ = cold_hand_ = test_hand_ = clock_.begin();
+    return clock_.begin();
+  }
+  return clock_.insert(hot_hand_, entry);
+}
+
+void ClockProPolicy::moveToHead(const Clock::iterator entry) {
+  if (clock_.size() == 1) {
+    return;
+  }
+  moveHandsPast(entry);
+  clock_.splice(hot_hand_, clock_, entry);
+}
+
+void ClockProPolicy::erase(const Clock::iterator entry) {
+  if (clock_.size() == 1) {
+    clock_.clear();
+    hot_hand_ = cold_hand_ = test_hand_ = clock_.end();
+    return;
+  }
+  moveHandsPast(entry);
+  clock_.erase(entry);
+}
+
+void ClockProPolicy::endTest(const Clock::iterator entry) {
+  entry->test = false;
+  if (cold_target_ > 1) {
+    --cold_target_;
+  }
+  if (!entry->resident) {
+    non_resident_.erase(entry->key);
+    erase(entry);
+  }
+}
+
+void ClockProPolicy::runHotHand() {
+  // Two rounds are enough: the first one clears all reference bits.
+  std::size_t steps = 2 * clock_.size() + 1;
+  while (num_hot_ > 0 && steps-- > 0) {
+    const Clock::iterator entry = hot_hand_;
+    advance(hot_hand_);
+    if (entry->hot) {
+      if (entry->ref) {
+        entry->ref = false;
+      } else {
+        entry->hot = false;
+        --num_hot_;
+        ++num_cold_;
+        return;
+      }
+    } else if (entry->test) {
+      endTest(entry);
+    }
+  }
+}
+
+void ClockProPolicy::runTestHand() {
+  std::size_t steps = clock_.size() + 1;
+  while (!non_resident_.empty() && steps-- > 0) {
+    const Clock::iterator entry = test_hand_;
+    advance(test_hand_);
+    if (!entry->hot && entry->test) {
+      const bool dropped = !entry->resident;
+      endTest(entry);
+      if (dropped) {
+        return;
+      }
+    }
+  }
+}
+
+void ClockProPolicy::onHit(const FrameId frame) {
+  frames_[frame - first_frame_]->ref = true;
+}
+
+bool ClockProPolicy::pickVictim(const TakeFrame& take, FrameId& frame) {
+  for (std::set<FrameId>::const_iterator it = free_.begin();
+       it != free_.end(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+
+  // Pinned cold pages are passed over.  Once as many of them have been
+  // passed as there are cold pages, a hot page is turned cold to give the
+  // cold hand another candidate; every frame gets that chance before giving
+  // up.
+  std::size_t passed = 0;
+  std::size_t failed = 0;
+  std::size_t steps = 8 * (clock_.size() + num_frames_);
+  while (steps-- > 0) {
+    if (num_cold_ == 0 || passed >= num_cold_) {
+      if (num_hot_ == 0 || failed > num_frames_) {
+        return false;
+      }
+      runHotHand();
+      passed = 0;
+      continue;
+    }
+    const Clock::iterator entry = cold_hand_;
+    advance(cold_hand_);
+    if (!entry->resident || entry->hot) {
+      continue;
+    }
+    if (entry->ref) {
+      entry->ref = false;
+      if (entry->test) {
+        // Referenced again within its test period: the page is hot.
+        entry->hot = true;
+        entry->test = false;
+        --num_cold_;
+        ++num_hot_;
+        if (cold_target_ + 1 < num_frames_) {
+          ++cold_target_;
+        }
+        moveToHead(entry);
+        while (num_hot_ > hotTarget()) {
+          runHotHand();
+        }
+      } else {
+        entry->test = true;
+        moveToHead(entry);
+      }
+      continue;
+    }
+    if (take(entry->frame)) {
+      frame = entry->frame;
+      return true;
+    }
+    ++passed;
+    ++failed;
+  }
+  return false;
+}
+
+void ClockProPolicy::nextVictims(const std::uint32_t count,
+                                 std::vector<FrameId>& frames) const {
+  // Unreferenced cold pages, in the order the cold hand reaches them.
+  Clock::const_iterator entry = cold_hand_;
+  std::uint32_t listed = 0;
+  for (std::size_t i = 0; i < clock_.size() && listed < count; ++i) {
+    if (entry->resident && !entry->hot && !entry->ref) {
+      frames.push_back(entry->frame);
+      ++listed;
+    }
+    ++entry;
+    if (entry == clock_.end()) {
+      entry = clock_.begin();
+    }
+  }
+}
+
+void ClockProPolicy::onEvict(const FrameId frame) {
+  const Clock::iterator entry = frames_[frame - first_frame_];
+  frames_[frame - first_frame_] = clock_.end();
+  free_.insert(frame);
+  if (entry->hot) {
+    --num_hot_;
+  } else {
+    --num_cold_;
+  }
+  if (entry->hot || !entry->test) {
+    erase(entry);
+    return;
+  }
+  // The page stays on the list until its test period is over.
+  entry->resident = false;
+  non_resident_[entry->key] = entry;
+  while (non_resident_.size() > num_frames_) {
+    runTestHand();
+  }
+}
+
+void ClockProPolicy::onLoad(const FrameId frame, const File* file,
+                            const PageId pageNo) {
+  free_.erase(frame);
+  Entry entry;
+  entry.key = pageKey(file, pageNo);
+  entry.frame = frame;
+  entry.resident = true;
+  entry.ref = false;
+  entry.test = false;
+
+  std::unordered_map<std::uint64_t, Clock::iterator>::iterator ghost =
+      non_resident_.find(entry.key);
+  if (ghost != non_resident_.end()) {
+    // Reloaded within its test period: cold pages are evicted too early.
+    erase(ghost->second);
+    non_resident_.erase(ghost);
+    if (cold_target_ + 1 < num_frames_) {
+      ++cold_target_;
+    }
+    entry.hot = true;
+  } else {
+    // While the pool fills up, pages are hot until the hot target is met.
+    entry.hot = !free_.empty() && num_hot_ < hotTarget();
+    entry.test = !entry.hot;
+  }
+
+  frames_[frame - first_frame_] = insertAtHead(entry);
+  if (entry.hot) {
+    ++num_hot_;
+    while (num_hot_ > hotTarget()) {
+      runHotHand();
+    }
+  } else {
+    ++num_cold_;
+  }
+}
+
+void ClockProPolicy::onLoadCold(const FrameId frame, const File* file,
+                                const PageId pageNo) {
+  // A cold page without a test period, placed where the cold hand looks next.
+  free_.erase(frame);
+  Entry entry;
+  entry.key = pageKey(file, pageNo);
+  entry.frame = frame;
+  entry.resident = true;
+  entry.hot = false;
+  entry.ref = false;
+  entry.test = false;
+
+  std::unordered_map<std::uint64_t, Clock::iterator>::iterator ghost =
+      non_resident_.find(entry.key);
+  if (ghost != non_resident_.end()) {
+    erase(ghost->second);
+    non_resident_.erase(ghost);
+  }
+  if (clock_.empty()) {
+    frames_[frame - first_frame_] = insertAtHead(entry);
+  } else {
+    cold_hand_ = clock_.insert(cold_hand_, entry);
+    frames_[frame - first_frame_] = cold_hand_;
+  }
+  ++num_cold_;
+}
+
+void ClockProPolicy::onRemove(const FrameId frame) {
+  const Clock::iterator entry = frames_[frame - first_frame_];
+  frames_[frame - first_frame_] = clock_.end();
+  free_.insert(frame);
+  if (entry->hot) {
+    --num_hot_;
+  } else {
+    --num_cold_;
+  }
+  erase(entry);
+}
+
+}
@@ -0,0 +1,148 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief CLOCK-Pro replacement (Jiang, Chen and Zhang).
+ *
+ * Resident pages are hot or cold.  All pages, together with recently evicted
+ * cold pages that are still in their test period, sit on one clock list which
+ * three hands move over:
+ *  - the cold hand looks for a victim among the resident cold pages.  A cold
+ *    page that was referenced during its test period becomes hot; one that
+ *    was referenced after it starts a new test period.  An unreferenced cold
+ *    page is evicted, and stays on the list as a non-resident page if its
+ *    test period is not over.
+ *  - the hot hand turns unreferenced hot pages cold whenever there are more
+ *    hot pages than the hot target, and ends the test periods it passes.
+ *  - the test hand ends test periods, dropping non-resident pages, so that no
+ *    more non-resident pages are kept than there are frames.
+ * A cold page that is reloaded during its test period proves that cold pages
+ * are evicted too early, so the target number of cold frames grows; a test
+ * period that ends without a reference shrinks it.
+ */
+class ClockProPolicy : public ReplacementPolicy {
+ public:
+  ClockProPolicy(const FrameId firstFrame, const std::uint32_t numFrames);
+
+  const char* name() const { return "CLOCK-Pro"; }
+  void onHit(const FrameId frame);
+  bool pickVictim(const TakeFrame& take, FrameId& frame);
+  void onEvict(const FrameId frame);
+  void onLoad(const FrameId frame, const File* file, const PageId pageNo);
+  void onLoadCold(const FrameId frame, const File* file,
+                  const PageId pageNo);
+  void onRemove(const FrameId frame);
+  void nextVictims(const std::uint32_t count,
+                   std::vector<FrameId>& frames) const;
+
+ private:
+  /**
+   * @brief Entry of the clock list.
+   */
+  struct Entry {
+    std::uint64_t key;
+    FrameId frame;
+    bool resident;
+    bool hot;
+    bool ref;
+    bool test;
+  };
+
+  typedef std::list<Entry> Clock;
+
+  /**
+   * Moves a hand one entry further, wrapping around at the end of the list.
+   */
+  void advance(Clock::iterator& hand);
+
+  /**
+   * Moves every hand pointing at the entry to the next one.
+   */
+  void moveHandsPast(const Clock::iterator entry);
+
+  /**
+   * Inserts an entry at the head of the list, just behind the hot hand.
+   */
+  Clock::iterator insertAtHead(const Entry& entry);
+
+  /**
+   * Moves an entry to the head of the list.
+   */
+  void moveToHead(const Clock::iterator entry);
+
+  /**
+   * Removes an entry from the list.
+   */
+  void erase(const Clock::iterator entry);
+
+  /**
+   * Ends the test period of a cold page, dropping it if it is not resident.
+   */
+  void endTest(const Clock::iterator entry);
+
+  /**
+   * Runs the hot hand until one hot page has been turned cold.
+   */
+  void runHotHand();
+
+  /**
+   * Runs the test hand until one non-resident page has been dropped.
+   */
+  void runTestHand();
+
+  /**
+   * Returns the target number of hot pages.
+   */
+  std::size_t hotTarget() const { return num_frames_ - cold_target_; }
+
+  const FrameId first_frame_;
+  const std::size_t num_frames_;
+
+  /**
+   * Target number of resident cold pages.
+   */
+  std::size_t cold_target_;
+
+  /**
+   * Number of resident hot and cold pages.
+   */
+  std::size_t num_hot_;
+  std::size_t num_cold_;
+
+  Clock clock_;
+  Clock::iterator hot_hand_;
+  Clock::iterator cold_hand_;
+  Clock::iterator test_hand_;
+
+  /**
+   * Entry of every resident frame, indexed by frame - first_frame_.
+   */
+  std::vector<Clock::iterator> frames_;
+
+  /**
+   * Frames not holding a page.
+   */
+  std::set<FrameId> free_;
+
+  /**
+   * Entries of non-resident pages by page key.
+   */
+  std::unordered_map<std::uint64_t, Clock::iterator> non_resident_;
+};
+
+}
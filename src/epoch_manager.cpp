@@ -0,0 +1,143 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "epoch_manager.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace badgerdb {
+
+/**
+ * Releases the record of a thread when the thread exits so that it can be
+ * reused by threads created later.
+ */
+class ThreadRecordOwner {
+ public:
+  ThreadRecordOwner() : record(NULL) {}
+
+  ~ThreadRecordOwner() {
+    if (record != NULL) {
+      record->epoch.store(0);
+      record->in_use.store(false);
+    }
+  }
+
+  EpochManager::ThreadRecord* record;
+};
+
+namespace {
+
+thread_local ThreadRecordOwner thread_record_owner;
+
+}
+
+EpochManager& EpochManager::instance() {
+  static EpochManager manager;
+  return manager;
+}
+
+EpochManager::EpochManager()
+    : global_epoch_(1),
+      records_(NULL) {
+}
+
+EpochManager::~EpochManager() {
+  // Thread records are intentionally not freed; threads which outlive static
+  // destruction may still release theirs.
+  for (std::size_t i = 0; i < retired_.size(); ++i) {
+    retired_[i].deleter(retired_[i].object);
+  }
+  retired_.clear();
+}
+
+EpochManager::ThreadRecord* EpochManager::threadRecord() {
+  if (thread_record_owner.record != NULL) {
+    return thread_record_owner.record;
+  }
+  // Try to reuse the record of a thread that has exited.
+  for (ThreadRecord* record = records_.load(); record != NULL;
+       record = record->next) {
+    bool expected = false;
+    if (!record->in_use.load() &&
+        record->in_use.compare_exchange_strong(expected, true)) {
+      record->depth = 0;
+      thread_record_owner.record = record;
+      return record;
+    }
+  }
+  ThreadRecord* record = new ThreadRecord;
+  record->epoch.store(0);
+  record->depth = 0;
+  record->in_use.store(true);
+  record->next = records_.load();
+  while (!records_.compare_exchange_weak(record->next, record)) {
+  }
+  thread_record_owner.record = record;
+  return record;
+}
+
+void EpochManager::enter() {
+  ThreadRecord* record = threadRecord();
+  if (record->depth++ == 0) {
+    // Sequentially consistent so that the announcement is ordered before any
+    // load of shared pointers inside the critical section.
+    record->epoch.store(global_epoch_.load());
+  }
+}
+
+void EpochManager::exit() {
+  ThreadRecord* record = thread_record_owner.record;
+  if (--record->depth == 0) {
+    record->epoch.store(0, std::memory_order_release);
+  }
+}
+
+void EpochManager::retire(void* object, Deleter deleter) {
+  {
+    std::lock_guard<std::mutex> guard(retired_mutex_);
+    // Readers that can still reach the object entered no later than the
+    // current epoch; advancing it lets later readers be told apart.
+    Retired retired = {object, deleter, global_epoch_.fetch_add(1)};
+    retired_.push_back(retired);
+  }
+  reclaim();
+}
+
+void EpochManager::reclaim() {
+  std::vector<Retired> to_free;
+  {
+    std::lock_guard<std::mutex> guard(retired_mutex_);
+    const std::uint64_t min_epoch = minActiveEpoch();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < retired_.size(); ++i) {
+      if (retired_[i].epoch < min_epoch) {
+        to_free.push_back(retired_[i]);
+      } else {
+        retired_[kept++] = retired_[i];
+      }
+    }
+    retired_.resize(kept);
+  }
+  for (std::size_t i = 0; i < to_free.size(); ++i) {
+    to_free[i].deleter(to_free[i].object);
+  }
+}
+
+std::uint64_t EpochManager::minActiveEpoch() const {
+  std::uint64_t min_epoch = std::numeric_limits<std::uint64_t>::max();
+  for (ThreadRecord* record = records_.load(); record != NULL;
+       record = record->next) {
+    const std::uint64_t epoch = record->epoch.load();
+    if (epoch != 0 && epoch < min_epoch) {
+      min_epoch = epoch;
+    }
+  }
+  return min_epoch;
+}
+
+}
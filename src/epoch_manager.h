@@ -0,0 +1,171 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Epoch-based reclamation of memory shared with lock-free readers.
+ *
+ * Lock-free data structures cannot free memory that has been unlinked as long
+ * as a concurrent reader might still hold a pointer to it.  Readers therefore
+ * announce themselves by holding an EpochGuard while they access shared
+ * memory, and writers hand unlinked memory to retire() instead of freeing it.
+ * Retired memory is freed once every thread that could have seen it has left
+ * its critical section.
+ *
+ * Entering and leaving a critical section only writes to a record private to
+ * the calling thread, so readers never write to shared cache lines.
+ */
+class EpochManager {
+ public:
+  /**
+   * Function used to free a retired object.
+   */
+  typedef void (*Deleter)(void*);
+
+  /**
+   * Returns the epoch manager shared by all lock-free structures.
+   *
+   * @return  The process wide epoch manager.
+   */
+  static EpochManager& instance();
+
+  /**
+   * Frees everything that is still retired.
+   */
+  ~EpochManager();
+
+  /**
+   * Enters a critical section for the calling thread.  Critical sections may
+   * be nested.
+   */
+  void enter();
+
+  /**
+   * Leaves the innermost critical section of the calling thread.
+   */
+  void exit();
+
+  /**
+   * Hands memory which is no longer reachable from any shared pointer to the
+   * epoch manager.  It will be freed with the given deleter once no reader can
+   * hold a reference to it anymore.
+   *
+   * @param object    Memory to free.
+   * @param deleter   Function which frees the memory.
+   */
+  void retire(void* object, Deleter deleter);
+
+  /**
+   * Frees all retired memory which can no longer be referenced by readers.
+   */
+  void reclaim();
+
+ private:
+  /**
+   * Per-thread record announcing the epoch in which the thread entered its
+   * critical section.
+   */
+  struct ThreadRecord {
+    /**
+     * Epoch observed when entering the outermost critical section, or 0 if the
+     * thread is not inside a critical section.
+     */
+    std::atomic<std::uint64_t> epoch;
+
+    /**
+     * Nesting depth of critical sections.  Only accessed by the owning thread.
+     */
+    int depth;
+
+    /**
+     * True while the record belongs to a live thread.
+     */
+    std::atomic<bool> in_use;
+
+    /**
+     * Next record in the list of all records.  Never changes once published.
+     */
+    ThreadRecord* next;
+
+    /**
+     * Keeps records of different threads on separate cache lines.
+     */
+    char padding[40];
+  };
+
+  /**
+   * Memory waiting to be freed.
+   */
+  struct Retired {
+    void* object;
+    Deleter deleter;
+    std::uint64_t epoch;
+  };
+
+  /**
+   * Returns the record of the calling thread, acquiring one if needed.
+   */
+  ThreadRecord* threadRecord();
+
+  /**
+   * Returns the smallest epoch any thread is currently inside of, or
+   * UINT64_MAX if no thread is inside a critical section.
+   */
+  std::uint64_t minActiveEpoch() const;
+
+  EpochManager();
+
+  /**
+   * Global epoch, advanced every time memory is retired.  Starts at 1 so that
+   * 0 can mark threads outside of critical sections.
+   */
+  std::atomic<std::uint64_t> global_epoch_;
+
+  /**
+   * Head of the list of thread records.  Records are never freed, but are
+   * reused after their thread exits.
+   */
+  std::atomic<ThreadRecord*> records_;
+
+  /**
+   * Memory waiting to be freed, protected by retired_mutex_.
+   */
+  std::vector<Retired> retired_;
+
+  /**
+   * Protects retired_.
+   */
+  std::mutex retired_mutex_;
+
+  friend class ThreadRecordOwner;
+};
+
+/**
+ * @brief RAII critical section of the epoch manager.
+ *
+ * Shared memory read by lock-free readers must only be dereferenced while an
+ * EpochGuard is alive.
+ */
+class EpochGuard {
+ public:
+  EpochGuard() { EpochManager::instance().enter(); }
+  ~EpochGuard() { EpochManager::instance().exit(); }
+
+ private:
+  EpochGuard(const EpochGuard&);
+  EpochGuard& operator=(const EpochGuard&);
+};
+
+}
@@ -7,16 +7,17 @@
 
 #include "bad_buffer_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 BadBufferException::BadBufferException(FrameId frameNoIn, bool dirtyIn, bool validIn, bool refbitIn)
-    : BadgerDbException(""), frameNo(frameNoIn), dirty(dirtyIn), valid(validIn), refbit(refbitIn) {
-  std::stringstream ss;
-  ss << "This buffer is bad: " << frameNo;
-  message_.assign(ss.str());
+    : BadgerDbException(), frameNo(frameNoIn), dirty(dirtyIn), valid(validIn), refbit(refbitIn) {
+}
+
+void BadBufferException::formatMessage(std::ostream& out) const {
+  out << "This buffer is bad: " << frameNo;
 }
 
 }
@@ -25,6 +25,11 @@ class BadBufferException : public BadgerDbException {
   explicit BadBufferException(FrameId frameNoIn, bool dirtyIn, bool validIn, bool refbitIn);
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Frame number of bad buffer
    */
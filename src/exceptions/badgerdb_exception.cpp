@@ -7,10 +7,39 @@
 
 #include "badgerdb_exception.h"
 
+#include <sstream>
+#include <string>
+
 namespace badgerdb {
 
 BadgerDbException::BadgerDbException(const std::string& msg)
-    : message_(msg) {
+    : message_(msg),
+      formatted_(true) {
+}
+
+BadgerDbException::BadgerDbException()
+    : formatted_(false) {
+}
+
+const std::string& BadgerDbException::message() const {
+  if (!formatted_) {
+    std::stringstream ss;
+    formatMessage(ss);
+    message_.assign(ss.str());
+    formatted_ = true;
+  }
+  return message_;
+}
+
+const char* BadgerDbException::what() const throw() {
+  try {
+    return message().c_str();
+  } catch (...) {
+    return "BadgerDB exception";
+  }
+}
+
+void BadgerDbException::formatMessage(std::ostream& out) const {
 }
 
 }
@@ -8,12 +8,18 @@
 #pragma once
 
 #include <exception>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 /**
  * @brief Base class for all BadgerDB-specific exceptions.
+ *
+ * Most exceptions only store the values describing the problem when they are
+ * constructed and format their message the first time message() or what() is
+ * called, so that throwing an exception which is caught and handled without
+ * looking at its message does not pay for building the string.
  */
 class BadgerDbException : public std::exception {
  public:
@@ -35,14 +41,14 @@ class BadgerDbException : public std::exception {
    *
    * @return  Message describing the problem that caused this exception.
    */
-  virtual const std::string& message() const { return message_; }
+  virtual const std::string& message() const;
 
   /**
    * Returns a description of the exception.
    *
    * @return  Description of the exception.
    */
-  virtual const char* what() const throw() { return message_.c_str(); }
+  virtual const char* what() const throw();
 
   /**
    * Formats this exception for printing on the given stream.
@@ -58,10 +64,30 @@ class BadgerDbException : public std::exception {
   }
 
  protected:
+  /**
+   * Constructs a new exception whose message is built by formatMessage() when
+   * it is first needed.
+   */
+  BadgerDbException();
+
+  /**
+   * Writes the message describing the problem to the given stream.  Called at
+   * most once, by the first call to message() or what().
+   *
+   * @param out Stream to write the message to.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Message describing the problem that caused this exception.
    */
-  std::string message_;
+  mutable std::string message_;
+
+ private:
+  /**
+   * True once message_ holds the message.
+   */
+  mutable bool formatted_;
 };
 
 }
@@ -7,16 +7,17 @@
 
 #include "buffer_exceeded_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 BufferExceededException::BufferExceededException()
-    : BadgerDbException(""){
-  std::stringstream ss;
-  ss << "Exceeded the buffer pool capacity";
-  message_.assign(ss.str());
+    : BadgerDbException(){
+}
+
+void BufferExceededException::formatMessage(std::ostream& out) const {
+  out << "Exceeded the buffer pool capacity";
 }
 
 }
@@ -22,6 +22,12 @@ class BufferExceededException : public BadgerDbException {
    * Constructs a buffer exceeded exception.
    */
   explicit BufferExceededException();
+
+ protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
 };
 
 }
@@ -7,16 +7,17 @@
 
 #include "file_exists_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 FileExistsException::FileExistsException(const std::string& name)
-    : BadgerDbException(""), filename_(name) {
-  std::stringstream ss;
-  ss << "File already exists: " << filename_;
-  message_.assign(ss.str());
+    : BadgerDbException(), filename_(name) {
+}
+
+void FileExistsException::formatMessage(std::ostream& out) const {
+  out << "File already exists: " << filename_;
 }
 
 }
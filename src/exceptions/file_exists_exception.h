@@ -32,10 +32,15 @@ class FileExistsException : public BadgerDbException {
   virtual const std::string& filename() const { return filename_; }
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Name of file that caused this exception.
    */
-  const std::string& filename_;
+  const std::string filename_;
 };
 
 }
@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "file_full_exception.h"
+
+#include <ostream>
+#include <string>
+
+namespace badgerdb {
+
+FileFullException::FileFullException(const std::string& name)
+    : BadgerDbException(), filename_(name) {
+}
+
+void FileFullException::formatMessage(std::ostream& out) const {
+  out << "File cannot hold more pages: " << filename_;
+}
+
+}
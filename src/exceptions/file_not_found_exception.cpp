@@ -7,16 +7,17 @@
 
 #include "file_not_found_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 FileNotFoundException::FileNotFoundException(const std::string& name)
-    : BadgerDbException(""), filename_(name) {
-  std::stringstream ss;
-  ss << "File not found: " << filename_;
-  message_.assign(ss.str());
+    : BadgerDbException(), filename_(name) {
+}
+
+void FileNotFoundException::formatMessage(std::ostream& out) const {
+  out << "File not found: " << filename_;
 }
 
 }
@@ -7,16 +7,17 @@
 
 #include "file_open_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 FileOpenException::FileOpenException(const std::string& name)
-    : BadgerDbException(""), filename_(name) {
-  std::stringstream ss;
-  ss << "File is currently open: " << filename_;
-  message_.assign(ss.str());
+    : BadgerDbException(), filename_(name) {
+}
+
+void FileOpenException::formatMessage(std::ostream& out) const {
+  out << "File is currently open: " << filename_;
 }
 
 }
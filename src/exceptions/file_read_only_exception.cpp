@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "file_read_only_exception.h"
+
+#include <ostream>
+#include <string>
+
+namespace badgerdb {
+
+FileReadOnlyException::FileReadOnlyException(const std::string& name)
+    : BadgerDbException(), filename_(name) {
+}
+
+void FileReadOnlyException::formatMessage(std::ostream& out) const {
+  out << "File is open read-only: " << filename_;
+}
+
+}
@@ -0,0 +1,46 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a change is requested to a file
+ *        that is open read-only.
+ */
+class FileReadOnlyException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a file read-only exception for the given file.
+   *
+   * @param name  Name of file that's open read-only.
+   */
+  explicit FileReadOnlyException(const std::string& name);
+
+  /**
+   * Returns the name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+ protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
+  /**
+   * Name of file that caused this exception.
+   */
+  const std::string filename_;
+};
+
+}
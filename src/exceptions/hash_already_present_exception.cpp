@@ -7,16 +7,17 @@
 
 #include "hash_already_present_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 HashAlreadyPresentException::HashAlreadyPresentException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn)
-    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
-  std::stringstream ss;
-  ss << "Entry corresponding to the hash value of file:" << name << "page:" << pageNo << "is already present in the hash table.";
-  message_.assign(ss.str());
+    : BadgerDbException(), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
+}
+
+void HashAlreadyPresentException::formatMessage(std::ostream& out) const {
+  out << "Entry corresponding to the hash value of file:" << name << "page:" << pageNo << "is already present in the hash table.";
 }
 
 }
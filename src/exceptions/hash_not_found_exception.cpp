@@ -7,16 +7,17 @@
 
 #include "hash_not_found_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 HashNotFoundException::HashNotFoundException(const std::string& nameIn, PageId pageNoIn)
-    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn) {
-  std::stringstream ss;
-  ss << "The hash value is not present in the hash table for file: " << name << "page: " << pageNo;
-  message_.assign(ss.str());
+    : BadgerDbException(), name(nameIn), pageNo(pageNoIn) {
+}
+
+void HashNotFoundException::formatMessage(std::ostream& out) const {
+  out << "The hash value is not present in the hash table for file: " << name << "page: " << pageNo;
 }
 
 }
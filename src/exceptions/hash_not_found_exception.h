@@ -25,10 +25,15 @@ class HashNotFoundException : public BadgerDbException {
   explicit HashNotFoundException(const std::string& nameIn, PageId pageNoIn);
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Name of file that caused this exception.
    */
-  const std::string& name;
+  const std::string name;
 
   /**
    * Page number in file
@@ -7,16 +7,17 @@
 
 #include "hash_table_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 HashTableException::HashTableException()
-    : BadgerDbException(""){
-  std::stringstream ss;
-  ss << "Error occurred in buffer hash table.";
-  message_.assign(ss.str());
+    : BadgerDbException(){
+}
+
+void HashTableException::formatMessage(std::ostream& out) const {
+  out << "Error occurred in buffer hash table.";
 }
 
 }
@@ -22,6 +22,12 @@ class HashTableException : public BadgerDbException {
    * Constructs a hash table exception.
    */
   explicit HashTableException();
+
+ protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
 };
 
 }
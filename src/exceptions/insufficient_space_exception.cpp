@@ -7,7 +7,7 @@
 
 #include "insufficient_space_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
@@ -15,15 +15,16 @@ namespace badgerdb {
 InsufficientSpaceException::InsufficientSpaceException(
     const PageId page_num, const std::size_t requested,
     const std::size_t available)
-    : BadgerDbException(""),
+    : BadgerDbException(),
       page_number_(page_num),
       space_requested_(requested),
       space_available_(available) {
-  std::stringstream ss;
-  ss << "Insufficient space in page " << page_number_
-     << "to hold record.  Requested: " << space_requested_ << " bytes."
-     << " Available: " << space_available_ << " bytes.";
-  message_.assign(ss.str());
+}
+
+void InsufficientSpaceException::formatMessage(std::ostream& out) const {
+  out << "Insufficient space in page " << page_number_
+      << "to hold record.  Requested: " << space_requested_ << " bytes."
+      << " Available: " << space_available_ << " bytes.";
 }
 
 }
@@ -48,6 +48,11 @@ class InsufficientSpaceException : public BadgerDbException {
   std::size_t space_available() const { return space_available_; }
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Page number of the page that caused this exception.
    */
@@ -7,21 +7,22 @@
 
 #include "invalid_page_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 InvalidPageException::InvalidPageException(
     const PageId requested_number, const std::string& file)
-    : BadgerDbException(""),
+    : BadgerDbException(),
       page_number_(requested_number),
       filename_(file) {
-  std::stringstream ss;
-  ss << "Request made for an invalid page."
-     << " Requested page " << page_number_
-     << " from file '" << filename_ << "'";
-  message_.assign(ss.str());
+}
+
+void InvalidPageException::formatMessage(std::ostream& out) const {
+  out << "Request made for an invalid page."
+      << " Requested page " << page_number_
+      << " from file '" << filename_ << "'";
 }
 
 }
@@ -50,6 +50,11 @@ class InvalidPageException : public BadgerDbException {
   virtual const std::string& filename() const { return filename_; }
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Requested page number which caused this exception.
    */
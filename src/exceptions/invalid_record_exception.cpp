@@ -7,22 +7,23 @@
 
 #include "invalid_record_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 InvalidRecordException::InvalidRecordException(
     const RecordId& rec_id, const PageId page_num)
-    : BadgerDbException(""),
+    : BadgerDbException(),
       record_id_(rec_id),
       page_number_(page_num) {
-  std::stringstream ss;
-  ss << "Request made for an invalid record."
-     << " Record {page=" << record_id_.page_number
-     << ", slot=" << record_id_.slot_number
-     << "} from page " << page_number_;
-  message_.assign(ss.str());
+}
+
+void InvalidRecordException::formatMessage(std::ostream& out) const {
+  out << "Request made for an invalid record."
+      << " Record {page=" << record_id_.page_number
+      << ", slot=" << record_id_.slot_number
+      << "} from page " << page_number_;
 }
 
 }
@@ -41,6 +41,11 @@ class InvalidRecordException : public BadgerDbException {
   virtual PageId page_number() const { return page_number_; }
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Record ID which caused this exception.
    */
@@ -7,20 +7,21 @@
 
 #include "invalid_slot_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 InvalidSlotException::InvalidSlotException(const PageId page_num,
                                            const SlotId slot_num)
-    : BadgerDbException(""),
+    : BadgerDbException(),
       page_number_(page_num),
       slot_number_(slot_num) {
-  std::stringstream ss;
-  ss << "Attempt to access a slot which is not currently in use."
-     << " Page: " << page_number_ << " Slot: " << slot_number_;
-  message_.assign(ss.str());
+}
+
+void InvalidSlotException::formatMessage(std::ostream& out) const {
+  out << "Attempt to access a slot which is not currently in use."
+      << " Page: " << page_number_ << " Slot: " << slot_number_;
 }
 
 }
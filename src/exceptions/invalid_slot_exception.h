@@ -40,6 +40,11 @@ class InvalidSlotException : public BadgerDbException {
   virtual SlotId slot_number() const { return slot_number_; }
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Page number of the page containing the slot which caused this exception.
    */
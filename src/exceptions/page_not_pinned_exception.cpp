@@ -7,16 +7,17 @@
 
 #include "page_not_pinned_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 PageNotPinnedException::PageNotPinnedException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn)
-    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
-  std::stringstream ss;
-  ss << "This page is not already pinned. file:  " << name << "page: " << pageNo << "frame: " << frameNo;
-  message_.assign(ss.str());
+    : BadgerDbException(), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
+}
+
+void PageNotPinnedException::formatMessage(std::ostream& out) const {
+  out << "This page is not already pinned. file:  " << name << "page: " << pageNo << "frame: " << frameNo;
 }
 
 }
@@ -7,16 +7,17 @@
 
 #include "page_pinned_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 PagePinnedException::PagePinnedException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn)
-    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
-  std::stringstream ss;
-  ss << "This page is already pinned. file:  " << name << "page: " << pageNo << "frame: " << frameNo;
-  message_.assign(ss.str());
+    : BadgerDbException(), name(nameIn), pageNo(pageNoIn), frameNo(frameNoIn) {
+}
+
+void PagePinnedException::formatMessage(std::ostream& out) const {
+  out << "This page is already pinned. file:  " << name << "page: " << pageNo << "frame: " << frameNo;
 }
 
 }
@@ -25,10 +25,15 @@ class PagePinnedException : public BadgerDbException {
   explicit PagePinnedException(const std::string& nameIn, PageId pageNoIn, FrameId frameNoIn);
 
  protected:
+  /**
+   * Writes the message describing this exception to the given stream.
+   */
+  virtual void formatMessage(std::ostream& out) const;
+
   /**
    * Name of file that caused this exception.
    */
-  const std::string& name;
+  const std::string name;
 
   /**
    * Page number in file
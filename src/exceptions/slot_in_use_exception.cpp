@@ -7,20 +7,21 @@
 
 #include "slot_in_use_exception.h"
 
-#include <sstream>
+#include <ostream>
 #include <string>
 
 namespace badgerdb {
 
 SlotInUseException::SlotInUseException(const PageId page_num,
                                        const SlotId slot_num)
-    : BadgerDbException(""),
+    : BadgerDbException(),
       page_number_(page_num),
       slot_number_(slot_num) {
-  std::stringstream ss;
-  ss << "Attempt to insert data to a slot that is currently in use."
-     << " Page: " << page_number_ << " Slot: " << slot_number_;
-  message_.assign(ss.str());
+}
+
+void SlotInUseException::formatMessage(std::ostream& out) const {
+  out << "Attempt to insert data to a slot that is currently in use."
+      << " Page: " << page_number_ << " Slot: " << slot_number_;
 }
 
 }
@@ -7,31 +7,231 @@
 
 #include "file.h"
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include "exceptions/file_exists_exception.h"
+#include "exceptions/file_format_exception.h"
+#include "exceptions/file_full_exception.h"
+#include "exceptions/file_io_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
+#include "exceptions/file_read_only_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "file_iterator.h"
+#include "io_engine.h"
 #include "page.h"
 
 namespace badgerdb {
 
-File::StreamMap File::open_streams_;
+namespace {
+
+/**
+ * Skips the given number of bytes at the start of the buffers of iov, which
+ * may end within a buffer.
+ */
+void advance(struct iovec*& iov, std::size_t& count, std::size_t bytes) {
+  while (count > 0 && bytes >= iov->iov_len) {
+    bytes -= iov->iov_len;
+    ++iov;
+    --count;
+  }
+  if (bytes > 0) {
+    iov->iov_base = static_cast<char*>(iov->iov_base) + bytes;
+    iov->iov_len -= bytes;
+  }
+}
+
+/**
+ * Unit of direct I/O: buffers, lengths and offsets must be multiples of it.
+ */
+const std::size_t BLOCK = Page::ALIGNMENT;
+
+typedef std::unique_ptr<char, void (*)(void*)> AlignedBuffer;
+
+/**
+ * Allocates a buffer of the given size aligned for direct I/O.
+ */
+AlignedBuffer allocateAligned(const std::size_t size) {
+  void* buffer;
+  if (posix_memalign(&buffer, BLOCK, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return AlignedBuffer(static_cast<char*>(buffer), std::free);
+}
+
+/**
+ * Returns true if the buffers and offset can be used for direct I/O as they
+ * are.
+ */
+bool aligned(const struct iovec* iov, const std::size_t count,
+             const off_t position) {
+  std::uintptr_t bits = position;
+  for (std::size_t i = 0; i < count; ++i) {
+    bits |= reinterpret_cast<std::uintptr_t>(iov[i].iov_base) | iov[i].iov_len;
+  }
+  return bits % BLOCK == 0;
+}
+
+/**
+ * Writes length bytes at the given offset of a descriptor other than the
+ * one of a File, retrying writes interrupted by a signal.
+ */
+void writeFully(const int fd, const char* data, std::size_t length,
+                off_t position, const std::string& name) {
+  while (length > 0) {
+    const ssize_t done = ::pwrite(fd, data, length, position);
+    if (done < 0 && errno == EINTR) {
+      continue;
+    }
+    if (done <= 0) {
+      throw FileIoException(name, done < 0 ? errno : EIO);
+    }
+    data += done;
+    length -= done;
+    position += done;
+  }
+}
+
+/**
+ * Returns true if all length bytes at data are zero.
+ */
+bool allZero(const char* data, const std::size_t length) {
+  return length == 0 ||
+      (data[0] == 0 && std::memcmp(data, data + 1, length - 1) == 0);
+}
+
+/**
+ * Value of FileHeader::magic in files written by File, "BgdB" on disk.
+ */
+const std::uint32_t FILE_MAGIC = 0x42646742;
+
+/**
+ * Version of the layout of the files written by this code.
+ */
+const std::uint32_t FORMAT_VERSION = 1;
+
+/**
+ * Header of the files in the original layout, which the pages follow.
+ */
+struct OriginalHeader {
+  PageId num_pages;
+  PageId first_used_page;
+  PageId num_free_pages;
+  PageId first_free_page;
+};
+
+/**
+ * Bytes copied at a time when a file is migrated from the original layout.
+ */
+const std::size_t MIGRATION_CHUNK = 256 * Page::SIZE;
+
+/**
+ * Pages a scan of a mapped file advises the kernel to read ahead at a time.
+ */
+const PageId READ_AHEAD_PAGES = 256;
+
+/**
+ * Version of the page directory written by this code.
+ */
+const PageId DIRECTORY_VERSION = 1;
+
+/**
+ * Directory version of files which link their used pages in a list, as the
+ * files migrated from the original layout do until they are converted.
+ */
+const PageId LIST_DIRECTORY_VERSION = 0;
+
+/**
+ * Offset in page 0 of the numbers of the directory pages, after the file
+ * header.
+ */
+const std::size_t DIRECTORY_LIST_OFFSET = 64;
+
+/**
+ * Most directory pages besides page 0; their numbers fill the first block of
+ * page 0.
+ */
+const std::size_t MAX_DIRECTORY_PAGES =
+    (BLOCK - DIRECTORY_LIST_OFFSET) / sizeof(PageId);
+
+/**
+ * Offset in page 0 of the bits of the first pages, in its second block.
+ */
+const std::size_t FIRST_BITS_OFFSET = BLOCK;
+
+/**
+ * Pages whose bits are held by page 0.
+ */
+const PageId FIRST_BITS_PAGES = (Page::SIZE - FIRST_BITS_OFFSET) * 8;
+
+/**
+ * Pages whose bits are held by a directory page.
+ */
+const PageId DIRECTORY_PAGE_PAGES = Page::SIZE * 8;
+
+static_assert(sizeof(FileHeader) <= DIRECTORY_LIST_OFFSET,
+              "File header must fit before the list of directory pages.");
+
+/**
+ * Returns the first page whose bit is held by the given part of the
+ * directory: 0 for page 0, k for the k-th directory page.
+ */
+PageId firstPageOfBits(const std::size_t part) {
+  return part == 0 ? 0 : FIRST_BITS_PAGES + (part - 1) * DIRECTORY_PAGE_PAGES;
+}
+
+/**
+ * Returns the part of the directory holding the bit of the given page.
+ */
+std::size_t bitsOfPage(const PageId page_number) {
+  return page_number < FIRST_BITS_PAGES
+      ? 0
+      : 1 + (page_number - FIRST_BITS_PAGES) / DIRECTORY_PAGE_PAGES;
+}
+
+std::size_t totalLength(const struct iovec* iov, const std::size_t count) {
+  std::size_t length = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    length += iov[i].iov_len;
+  }
+  return length;
+}
+
+}
+
 File::CountMap File::open_counts_;
+File::LockMap File::open_locks_;
+File::DescriptorMap File::open_descriptors_;
+File::DirectMap File::open_direct_;
+File::MappingMap File::open_mappings_;
+File::HeaderMap File::open_headers_;
+std::mutex File::open_files_mutex_;
+std::atomic<std::uint32_t> File::next_id_(1);
 
-File File::create(const std::string& filename) {
-  return File(filename, true /* create_new */);
+File File::create(const std::string& filename, const FileMode mode) {
+  return File(filename, true /* create_new */,
+              mode == FileMode::MAPPED ? FileMode::BUFFERED : mode);
 }
 
-File File::open(const std::string& filename) {
-  return File(filename, false /* create_new */);
+File File::open(const std::string& filename, const FileMode mode) {
+  return File(filename, false /* create_new */, mode);
 }
 
 void File::remove(const std::string& filename) {
@@ -48,23 +248,25 @@ bool File::isOpen(const std::string& filename) {
   if (!exists(filename)) {
     return false;
   }
+  std::lock_guard<std::mutex> guard(open_files_mutex_);
   return open_counts_.find(filename) != open_counts_.end();
 }
 
 bool File::exists(const std::string& filename) {
-	std::fstream file(filename);
-	if(file)
-	{
-		file.close();
-		return true;
-	}
-
-	return false;
+	struct stat status;
+	return ::stat(filename.c_str(), &status) == 0;
 }
 
 File::File(const File& other)
   : filename_(other.filename_),
-    stream_(open_streams_[filename_]) {
+    id_(next_id_++) {
+  std::lock_guard<std::mutex> guard(open_files_mutex_);
+  lock_ = open_locks_[filename_];
+  header_ = open_headers_[filename_];
+  fd_ = open_descriptors_[filename_];
+  direct_ = open_direct_[filename_];
+  mapping_ = open_mappings_[filename_].first;
+  mapping_size_ = open_mappings_[filename_].second;
   ++open_counts_[filename_];
 }
 
@@ -73,7 +275,10 @@ File& File::operator=(const File& rhs) {
   // same file.
   close();	//close my file and associate me with the new one
   filename_ = rhs.filename_;
-  openIfNeeded(false /* create_new */);
+  openIfNeeded(false /* create_new */,
+               rhs.mapped() ? FileMode::MAPPED
+                            : rhs.direct_ ? FileMode::DIRECT
+                                          : FileMode::BUFFERED);
   return *this;
 }
 
@@ -82,136 +287,284 @@ File::~File() {
 }
 
 Page File::allocatePage() {
-  FileHeader header = readHeader();
   Page new_page;
-  Page existing_page;
-  if (header.num_free_pages > 0) {
-    new_page = readPage(header.first_free_page, true /* allow_free */);
-    new_page.set_page_number(header.first_free_page);
-    header.first_free_page = new_page.next_page_number();
-    --header.num_free_pages;
+  allocatePage(new_page);
+  return new_page;
+}
 
-    if (header.first_used_page == Page::INVALID_NUMBER ||
-        header.first_used_page > new_page.page_number()) {
-      // Either have no pages used or the head of the used list is a page later
-      // than the one we just allocated, so add the new page to the head.
-      if (header.first_used_page > new_page.page_number()) {
-        new_page.set_next_page_number(header.first_used_page);
-      }
-      header.first_used_page = new_page.page_number();
+void File::allocatePage(Page& new_page) {
+  checkWritable();
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  // Changes are serialized by lock_, so the page can be chosen first, written,
+  // and only then marked used, so that readers never see it unwritten.
+  PageId page_number;
+  bool add_directory_page = false;
+  {
+    std::lock_guard<std::mutex> header_guard(header_->mutex);
+    if (!header_->free_pages.empty()) {
+      // Reuse the page freed last.
+      page_number = header_->free_pages.back();
     } else {
-      // New page is reused from somewhere after the beginning, so we need to
-      // find where in the used list to insert it.
-      PageId next_page_number = Page::INVALID_NUMBER;
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        next_page_number = (*iter).next_page_number();
-        if (next_page_number > new_page.page_number() ||
-            next_page_number == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
+      page_number = header_->header.num_pages;
+      if (page_number == header_->coveredPages()) {
+        // The page becomes a directory page for the pages after it, unless
+        // page 0 has no room left for its number.
+        if (header_->directory.size() == MAX_DIRECTORY_PAGES) {
+          throw FileFullException(filename_);
         }
+        add_directory_page = true;
+        ++page_number;
       }
-      existing_page.set_next_page_number(new_page.page_number());
-      new_page.set_next_page_number(next_page_number);
     }
+  }
+  new_page.initialize();
+  new_page.set_page_number(page_number);
+  writePage(page_number, new_page);
 
-    assert((header.num_free_pages == 0) ==
-           (header.first_free_page == Page::INVALID_NUMBER));
-  } else {
-    new_page.set_page_number(header.num_pages);
-    if (header.first_used_page == Page::INVALID_NUMBER) {
-      header.first_used_page = new_page.page_number();
+  bool write_back;
+  {
+    std::lock_guard<std::mutex> header_guard(header_->mutex);
+    FileHeader& header = header_->header;
+    if (!header_->free_pages.empty()) {
+      header_->free_pages.pop_back();
+      --header.num_free_pages;
+      header.first_free_page = header_->free_pages.empty()
+          ? Page::INVALID_NUMBER : header_->free_pages.back();
     } else {
-      // If we have pages allocated, we need to add the new page to the tail
-      // of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
+      if (add_directory_page) {
+        header_->addDirectoryPage(header.num_pages++);
+        ++header.num_directory_pages;
       }
-      assert(existing_page.isUsed());
-      existing_page.set_next_page_number(new_page.page_number());
+      ++header.num_pages;
+    }
+    header_->setUsed(page_number, true);
+    if (header.first_used_page == Page::INVALID_NUMBER ||
+        header.first_used_page > page_number) {
+      header.first_used_page = page_number;
     }
-    ++header.num_pages;
+    write_back = header_->changed();
   }
-  writePage(new_page.page_number(), new_page);
-  if (existing_page.page_number() != Page::INVALID_NUMBER) {
-    // If we updated an existing page by inserting the new page into the
-    // used list, we need to write it out.
-    writePage(existing_page.page_number(), existing_page);
+  if (write_back) {
+    writeBackHeader();
   }
-  writeHeader(header);
-
-  return new_page;
 }
 
 Page File::readPage(const PageId page_number) const {
-  FileHeader header = readHeader(); 
-  if (page_number >= header.num_pages) {
+  Page page;
+  if (!tryReadPage(page_number, page)) {
     throw InvalidPageException(page_number, filename_);
   }
-  return readPage(page_number, false /* allow_free */);
+  return page;
+}
+
+bool File::tryReadPage(const PageId page_number, Page& page) const {
+  if (!isPageUsed(page_number)) {
+    return false;
+  }
+  return readPage(page_number, true /* allow_free */, page);
+}
+
+void File::tryReadPages(const PageId first, const std::uint32_t count,
+                        Page* const* pages, bool* found) const {
+  FileHeader header = readHeader();
+  std::uint32_t available = 0;
+  if (first < header.num_pages) {
+    available = std::min<std::uint32_t>(count, header.num_pages - first);
+  }
+  // One read for all pages.
+  std::vector<struct iovec> iov;
+  for (std::uint32_t i = 0; i < available; ++i) {
+    struct iovec page = {pages[i], Page::SIZE};
+    iov.push_back(page);
+  }
+  readAt(iov.data(), iov.size(), pagePosition(first));
+  for (std::uint32_t i = 0; i < available; ++i) {
+    found[i] = isPageUsed(first + i);
+  }
+  for (std::uint32_t i = available; i < count; ++i) {
+    found[i] = false;
+  }
+}
+
+void File::tryReadPages(const PageId* page_numbers, const std::uint32_t count,
+                        Page* const* pages, bool* found) const {
+  FileHeader header = readHeader();
+  std::uint32_t available = 0;
+  while (available < count && page_numbers[available] < header.num_pages) {
+    ++available;
+  }
+  if (mapped()) {
+    // Copying out of the mapping needs no requests.
+    for (std::uint32_t i = 0; i < available; ++i) {
+      found[i] = tryReadPage(page_numbers[i], *pages[i]);
+    }
+    for (std::uint32_t i = available; i < count; ++i) {
+      found[i] = false;
+    }
+    return;
+  }
+  std::vector<struct iovec> iov(available);
+  std::vector<IoRequest> requests;
+  for (std::uint32_t i = 0; i < available; ++i) {
+    iov[i].iov_base = pages[i];
+    iov[i].iov_len = Page::SIZE;
+    if (i > 0 && page_numbers[i] == page_numbers[i - 1] + 1 &&
+        requests.back().iovcnt < IOV_MAX) {
+      ++requests.back().iovcnt;
+      continue;
+    }
+    IoRequest request = {false /* write */, fd_, &iov[i], 1,
+                         pagePosition(page_numbers[i]), 0};
+    requests.push_back(request);
+  }
+  IoEngine::instance().run(requests.data(), requests.size());
+  for (std::size_t r = 0; r < requests.size(); ++r) {
+    // Finish short or failed reads one at a time, which throws on errors and
+    // reads the pages past the end of the file as unused.
+    const ssize_t length = requests[r].iovcnt * Page::SIZE;
+    if (requests[r].result == length) {
+      continue;
+    }
+    std::vector<struct iovec> rest(requests[r].iov,
+                                   requests[r].iov + requests[r].iovcnt);
+    struct iovec* next = rest.data();
+    std::size_t left = rest.size();
+    off_t position = requests[r].offset;
+    if (requests[r].result > 0) {
+      advance(next, left, requests[r].result);
+      position += requests[r].result;
+    }
+    readAt(next, left, position);
+  }
+  for (std::uint32_t i = 0; i < available; ++i) {
+    found[i] = isPageUsed(page_numbers[i]);
+  }
+  for (std::uint32_t i = available; i < count; ++i) {
+    found[i] = false;
+  }
 }
 
 Page File::readPage(const PageId page_number, const bool allow_free) const {
   Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
-  if (!allow_free && !page.isUsed()) {
+  if (!readPage(page_number, allow_free, page)) {
     throw InvalidPageException(page_number, filename_);
   }
 
   return page;
 }
 
+bool File::readPage(const PageId page_number, const bool allow_free,
+                    Page& page) const {
+  readAt(&page, Page::SIZE, pagePosition(page_number));
+  return allow_free || page.isUsed();
+}
+
 void File::writePage(const Page& new_page) {
-  PageHeader header = readPageHeader(new_page.page_number());
-  if (header.current_page_number == Page::INVALID_NUMBER) {
+  checkWritable();
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  if (!isPageUsed(new_page.page_number())) {
     // Page has been deleted since it was read.
     throw InvalidPageException(new_page.page_number(), filename_);
   }
-  // Page on disk may have had its next page pointer updated since it was read;
-  // we don't modify that, but we do keep all the other modifications to the
-  // page header.
-  const PageId next_page_number = header.next_page_number;
-  header = new_page.header_;
-  header.next_page_number = next_page_number;
-  writePage(new_page.page_number(), header, new_page);
+  writePage(new_page.page_number(), new_page);
 }
 
-void File::deletePage(const PageId page_number) {
-  FileHeader header = readHeader();
-  Page existing_page = readPage(page_number);
-  Page previous_page;
-  // If this page is the head of the used list, update the header to point to
-  // the next page in line.
-  if (page_number == header.first_used_page) {
-    header.first_used_page = existing_page.next_page_number();
-  } else {
-    // Walk the used list so we can update the page that points to this one.
-    for (FileIterator iter = begin(); iter != end(); ++iter) {
-      previous_page = *iter;
-      if (previous_page.next_page_number() == existing_page.page_number()) {
-        previous_page.set_next_page_number(existing_page.next_page_number());
-        break;
-      }
+void File::writePages(const Page* const* pages, const std::uint32_t count) {
+  checkWritable();
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  // Like writePage(), check all pages before writing any of them.
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (!isPageUsed(pages[i]->page_number())) {
+      throw InvalidPageException(pages[i]->page_number(), filename_);
     }
   }
-  // Clear the page and add it to the head of the free list.
-  existing_page.initialize();
-  existing_page.set_next_page_number(header.first_free_page);
-  header.first_free_page = page_number;
-  ++header.num_free_pages;
-  if (previous_page.isUsed()) {
-    writePage(previous_page.page_number(), previous_page);
+
+  std::vector<struct iovec> iov(count);
+  std::vector<IoRequest> requests;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    iov[i].iov_base = const_cast<Page*>(pages[i]);
+    iov[i].iov_len = Page::SIZE;
+    if (i > 0 && pages[i]->page_number() == pages[i - 1]->page_number() + 1 &&
+        requests.back().iovcnt < IOV_MAX) {
+      ++requests.back().iovcnt;
+      continue;
+    }
+    IoRequest request = {true /* write */, fd_, &iov[i], 1,
+                         pagePosition(pages[i]->page_number()), 0};
+    requests.push_back(request);
+  }
+  IoEngine::instance().run(requests.data(), requests.size());
+  for (std::size_t r = 0; r < requests.size(); ++r) {
+    // Finish short or failed writes one at a time.
+    const ssize_t length = requests[r].iovcnt * Page::SIZE;
+    if (requests[r].result == length) {
+      continue;
+    }
+    std::vector<struct iovec> rest(requests[r].iov,
+                                   requests[r].iov + requests[r].iovcnt);
+    struct iovec* next = rest.data();
+    std::size_t left = rest.size();
+    off_t position = requests[r].offset;
+    if (requests[r].result > 0) {
+      advance(next, left, requests[r].result);
+      position += requests[r].result;
+    }
+    writeAt(next, left, position);
   }
+}
+
+void File::deletePage(const PageId page_number) {
+  checkWritable();
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  if (!isPageUsed(page_number)) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  bool write_back;
+  {
+    std::lock_guard<std::mutex> header_guard(header_->mutex);
+    FileHeader& header = header_->header;
+    header_->setUsed(page_number, false);
+    header_->free_pages.push_back(page_number);
+    ++header.num_free_pages;
+    header.first_free_page = page_number;
+    if (header.first_used_page == page_number) {
+      header.first_used_page = header_->nextUsed(page_number);
+    }
+    write_back = header_->changed();
+  }
+  // Clear the page on disk too.
+  Page existing_page;
   writePage(page_number, existing_page);
-  writeHeader(header);
+  if (write_back) {
+    writeBackHeader();
+  }
+}
+
+const Page& File::viewPage(const PageId page_number) const {
+  if (!mapped() || !isPageUsed(page_number) ||
+      pagePosition(page_number) + Page::SIZE > mapping_size_) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  return *reinterpret_cast<const Page*>(mapping_ + pagePosition(page_number));
+}
+
+void File::sync() {
+  writeBackHeader();
+  if (::fdatasync(fd_) != 0) {
+    throw FileIoException(filename_, errno);
+  }
+}
+
+void File::setHeaderWriteInterval(const std::uint32_t changes) {
+  std::lock_guard<std::mutex> guard(header_->mutex);
+  header_->write_interval = changes;
 }
 
 FileIterator File::begin() {
+  if (mapped()) {
+    // Scans visit the used pages in file order.
+    ::madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+  }
   const FileHeader& header = readHeader();
   return FileIterator(this, header.first_used_page);
 }
@@ -220,86 +573,548 @@ FileIterator File::end() {
   return FileIterator(this, Page::INVALID_NUMBER);
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
-  openIfNeeded(create_new);
-
-  if (create_new) {
-    // File starts with 1 page (the header).
-    FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
-    writeHeader(header);
-  }
+File::File(const std::string& name, const bool create_new,
+           const FileMode mode)
+    : filename_(name),
+      id_(next_id_++) {
+  openIfNeeded(create_new, mode);
 }
 
-void File::openIfNeeded(const bool create_new) {
+void File::openIfNeeded(const bool create_new, const FileMode mode) {
+  std::lock_guard<std::mutex> guard(open_files_mutex_);
   if (open_counts_.find(filename_) != open_counts_.end()) {	//exists an entry already
     ++open_counts_[filename_];
-    stream_ = open_streams_[filename_];
+    lock_ = open_locks_[filename_];
+    header_ = open_headers_[filename_];
+    fd_ = open_descriptors_[filename_];
+    direct_ = open_direct_[filename_];
+    mapping_ = open_mappings_[filename_].first;
+    mapping_size_ = open_mappings_[filename_].second;
   } else {
-    std::ios_base::openmode mode =
-        std::fstream::in | std::fstream::out | std::fstream::binary;
+    int flags = mode == FileMode::MAPPED ? O_RDONLY : O_RDWR;
     const bool already_exists = exists(filename_);
     if (create_new) {
       // Error if we try to overwrite an existing file.
       if (already_exists) {
         throw FileExistsException(filename_);
       }
-      // New files have to be truncated on open.
-      mode = mode | std::fstream::trunc;
+      flags |= O_CREAT | O_TRUNC;
     } else {
       // Error if we try to open a file that doesn't exist.
       if (!already_exists) {
         throw FileNotFoundException(filename_);
       }
     }
-    stream_.reset(new std::fstream(filename_, mode));
-    open_streams_[filename_] = stream_;
+    direct_ = false;
+    if (mode == FileMode::DIRECT) {
+      fd_ = ::open(filename_.c_str(), flags | O_DIRECT, 0666);
+      // Filesystems without direct I/O reject O_DIRECT with EINVAL.
+      direct_ = fd_ >= 0;
+    }
+    if (!direct_) {
+      fd_ = ::open(filename_.c_str(), flags, 0666);
+    }
+    if (fd_ < 0) {
+      throw FileNotFoundException(filename_);
+    }
+    mapping_ = NULL;
+    mapping_size_ = 0;
+    if (mode == FileMode::MAPPED) {
+      map();
+    }
+    // The header on disk is only read once, while the file is open.
+    header_.reset(new CachedHeader());
+    header_->dirty = false;
+    header_->changes = 0;
+    header_->write_interval = 0;
+    lock_.reset(new std::recursive_mutex());
+    try {
+      if (create_new) {
+        // File starts with 1 page (the header) and an empty directory.
+        const FileHeader header = {FILE_MAGIC, FORMAT_VERSION,
+                                   1 /* num_pages */, 0 /* first_used_page */,
+                                   0 /* num_free_pages */, 0 /* first_free_page */,
+                                   DIRECTORY_VERSION /* directory_version */,
+                                   0 /* num_directory_pages */};
+        header_->header = header;
+        header_->used.assign(FIRST_BITS_PAGES / 64, 0);
+        header_->dirty_bits.assign(1, true);
+        header_->dirty = true;
+      } else {
+        readAt(&header_->header, sizeof(header_->header), 0 /* position */);
+        if (header_->header.magic != FILE_MAGIC) {
+          // Only files in the original layout are migrated; nothing is
+          // written to files in a layout that is not known.
+          if (!isOriginalLayout()) {
+            throw FileFormatException(filename_);
+          }
+          if (mode == FileMode::MAPPED) {
+            throw FileReadOnlyException(filename_);
+          }
+          migrate(direct_ ? flags | O_DIRECT : flags);
+          readAt(&header_->header, sizeof(header_->header), 0 /* position */);
+        } else if (header_->header.format_version != FORMAT_VERSION) {
+          throw FileFormatException(filename_);
+        }
+      }
+      loadDirectory();
+    } catch (...) {
+      // The file is not registered as open yet; nothing else refers to it.
+      if (mapping_ != NULL) {
+        ::munmap(mapping_, mapping_size_);
+      }
+      ::close(fd_);
+      lock_.reset();
+      header_.reset();
+      throw;
+    }
+    open_locks_[filename_] = lock_;
+    open_headers_[filename_] = header_;
+    open_descriptors_[filename_] = fd_;
+    open_direct_[filename_] = direct_;
+    open_mappings_[filename_] = std::make_pair(mapping_, mapping_size_);
     open_counts_[filename_] = 1;
   }
 }
 
+bool File::isOriginalLayout() const {
+  OriginalHeader header;
+  readAt(&header, sizeof(header), 0 /* position */);
+  struct stat status;
+  if (::fstat(fd_, &status) != 0) {
+    throw FileIoException(filename_, errno);
+  }
+  // The header counts itself as page 0, and the lists start at used pages.
+  if (header.num_pages == 0 || header.first_used_page >= header.num_pages ||
+      header.first_free_page >= header.num_pages ||
+      header.num_free_pages >= header.num_pages) {
+    return false;
+  }
+  const off_t pages_size = static_cast<off_t>(header.num_pages - 1) *
+      static_cast<off_t>(Page::SIZE);
+  return status.st_size ==
+      static_cast<off_t>(sizeof(OriginalHeader)) + pages_size;
+}
+
+void File::migrate(const int flags) {
+  OriginalHeader original;
+  readAt(&original, sizeof(original), 0 /* position */);
+  const std::string temporary = filename_ + ".migrating";
+  const int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (out < 0) {
+    throw FileIoException(temporary, errno);
+  }
+  try {
+    // The pages follow each other in both layouts, so they are copied in
+    // chunks; chunks of zeros, such as holes, are left holes.
+    const off_t length = static_cast<off_t>(original.num_pages - 1) * Page::SIZE;
+    std::vector<char> chunk(MIGRATION_CHUNK);
+    for (off_t done = 0; done < length; done += chunk.size()) {
+      const std::size_t size = std::min<off_t>(chunk.size(), length - done);
+      readAt(chunk.data(), size, sizeof(OriginalHeader) + done);
+      if (!allZero(chunk.data(), size)) {
+        writeFully(out, chunk.data(), size, Page::SIZE + done, temporary);
+      }
+    }
+    // The used pages are still linked in a list, until loadDirectory()
+    // converts it.
+    const FileHeader header = {FILE_MAGIC, FORMAT_VERSION,
+                               original.num_pages, original.first_used_page,
+                               original.num_free_pages,
+                               original.first_free_page,
+                               LIST_DIRECTORY_VERSION,
+                               0 /* num_directory_pages */};
+    std::vector<char> first(BLOCK, 0);
+    std::memcpy(first.data(), &header, sizeof(header));
+    writeFully(out, first.data(), first.size(), 0 /* position */, temporary);
+    if (::ftruncate(out, static_cast<off_t>(original.num_pages) * Page::SIZE) != 0 ||
+        ::fdatasync(out) != 0) {
+      throw FileIoException(temporary, errno);
+    }
+  } catch (...) {
+    ::close(out);
+    ::unlink(temporary.c_str());
+    throw;
+  }
+  ::close(out);
+  if (::rename(temporary.c_str(), filename_.c_str()) != 0) {
+    const int error = errno;
+    ::unlink(temporary.c_str());
+    throw FileIoException(filename_, error);
+  }
+  // fd_ still refers to the original file, which is gone now.
+  ::close(fd_);
+  fd_ = ::open(filename_.c_str(), flags, 0666);
+  if (fd_ < 0) {
+    throw FileNotFoundException(filename_);
+  }
+}
+
+void File::map() {
+  struct stat status;
+  if (::fstat(fd_, &status) != 0) {
+    ::close(fd_);
+    throw FileNotFoundException(filename_);
+  }
+  mapping_size_ = status.st_size;
+  void* mapping = ::mmap(NULL, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    ::close(fd_);
+    throw FileNotFoundException(filename_);
+  }
+  mapping_ = static_cast<char*>(mapping);
+}
+
+void File::checkWritable() const {
+  if (mapped()) {
+    throw FileReadOnlyException(filename_);
+  }
+}
+
+PageId File::adviseReadAhead(const PageId page_number) const {
+  const PageId end = page_number + READ_AHEAD_PAGES;
+  const std::size_t start = pagePosition(page_number);
+  if (mapped() && start < mapping_size_) {
+    const std::size_t length =
+        std::min<std::size_t>(pagePosition(end), mapping_size_) - start;
+    ::madvise(mapping_ + start, length, MADV_WILLNEED);
+  }
+  return end;
+}
+
 void File::close() {
+  std::lock_guard<std::mutex> guard(open_files_mutex_);
   --open_counts_[filename_];
-  stream_.reset();
   if (open_counts_[filename_] == 0) {
-    open_streams_.erase(filename_);
+    // Closing is part of destroying a File, which must not throw; sync()
+    // reports errors writing the header back to its caller.
+    try {
+      writeBackHeader();
+    } catch (const FileIoException& e) {
+      std::cerr << e.message() << std::endl;
+    }
+  }
+  lock_.reset();
+  header_.reset();
+  if (open_counts_[filename_] == 0) {
+    if (mapping_ != NULL) {
+      ::munmap(mapping_, mapping_size_);
+    }
+    ::close(fd_);
+    open_locks_.erase(filename_);
+    open_descriptors_.erase(filename_);
+    open_direct_.erase(filename_);
+    open_mappings_.erase(filename_);
+    open_headers_.erase(filename_);
     open_counts_.erase(filename_);
   }
 }
 
 void File::writePage(const PageId page_number, const Page& new_page) {
-  writePage(page_number, new_page.header_, new_page);
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  writeAt(&new_page, Page::SIZE, pagePosition(page_number));
 }
 
-void File::writePage(const PageId page_number, const PageHeader& header,
-                     const Page& new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->write(reinterpret_cast<const char*>(&new_page.data_[0]),
-                 Page::DATA_SIZE);
-  stream_->flush();
+FileHeader File::readHeader() const {
+  std::lock_guard<std::mutex> guard(header_->mutex);
+  return header_->header;
 }
 
-FileHeader File::readHeader() const {
-  FileHeader header;
-  stream_->seekg(0 /* pos */, std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+void File::writeHeader(const FileHeader& header) {
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  bool write_back;
+  {
+    std::lock_guard<std::mutex> header_guard(header_->mutex);
+    header_->header = header;
+    header_->dirty = true;
+    ++header_->changes;
+    write_back = header_->write_interval > 0 &&
+        header_->changes >= header_->write_interval;
+  }
+  if (write_back) {
+    writeBackHeader();
+  }
+}
 
-  return header;
+void File::writeBackHeader() {
+  if (mapped()) {
+    // Read-only files never change their header.
+    return;
+  }
+  // Changes to the header are serialized by lock_, so none can come between
+  // taking the copies and writing them.
+  std::lock_guard<std::recursive_mutex> guard(*lock_);
+  std::vector<char> first_block;
+  std::vector<std::pair<off_t, std::vector<std::uint64_t> > > bits;
+  {
+    std::lock_guard<std::mutex> header_guard(header_->mutex);
+    for (std::size_t part = 0; part < header_->dirty_bits.size(); ++part) {
+      if (!header_->dirty_bits[part]) {
+        continue;
+      }
+      const std::size_t begin = firstPageOfBits(part) / 64;
+      const std::size_t end = firstPageOfBits(part + 1) / 64;
+      const off_t position = part == 0
+          ? FIRST_BITS_OFFSET : pagePosition(header_->directory[part - 1]);
+      bits.push_back(std::make_pair(position, std::vector<std::uint64_t>(
+          header_->used.begin() + begin, header_->used.begin() + end)));
+      header_->dirty_bits[part] = false;
+    }
+    if (header_->dirty) {
+      first_block.assign(BLOCK, 0);
+      std::memcpy(first_block.data(), &header_->header, sizeof(FileHeader));
+      std::memcpy(first_block.data() + DIRECTORY_LIST_OFFSET,
+                  header_->directory.data(),
+                  header_->directory.size() * sizeof(PageId));
+      header_->dirty = false;
+    }
+    header_->changes = 0;
+  }
+  // The bits go first, so that the header never refers to directory pages
+  // which have not been written.
+  for (std::size_t i = 0; i < bits.size(); ++i) {
+    writeAt(bits[i].second.data(), bits[i].second.size() * sizeof(std::uint64_t),
+            bits[i].first);
+  }
+  if (!first_block.empty()) {
+    writeAt(first_block.data(), first_block.size(), 0 /* position */);
+  }
 }
 
-void File::writeHeader(const FileHeader& header) {
-  stream_->seekp(0 /* pos */, std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->flush();
+void File::loadDirectory() {
+  CachedHeader& cached = *header_;
+  FileHeader& header = cached.header;
+  // Nothing is written to files whose directory is not known, or whose
+  // directory does not cover their pages.
+  const bool listed = header.directory_version == LIST_DIRECTORY_VERSION;
+  if ((!listed && header.directory_version != DIRECTORY_VERSION) ||
+      header.num_pages == 0 ||
+      (listed && header.num_directory_pages != 0) ||
+      header.num_directory_pages > MAX_DIRECTORY_PAGES ||
+      (!listed &&
+       header.num_pages > firstPageOfBits(header.num_directory_pages + 1))) {
+    throw FileFormatException(filename_);
+  }
+  if (listed) {
+    // The file links its used pages in a list; all others are free.  The
+    // directory pages needed are added after the last page.
+    header.directory_version = DIRECTORY_VERSION;
+    header.num_directory_pages = 0;
+    cached.used.assign(FIRST_BITS_PAGES / 64, 0);
+    cached.dirty_bits.assign(1, true);
+    cached.dirty = true;
+    const PageId num_pages = header.num_pages;
+    while (header.num_pages > cached.coveredPages()) {
+      if (cached.directory.size() == MAX_DIRECTORY_PAGES) {
+        throw FileFullException(filename_);
+      }
+      cached.addDirectoryPage(header.num_pages++);
+      ++header.num_directory_pages;
+    }
+    PageId listed = 0;
+    for (PageId page_number = header.first_used_page;
+         page_number != Page::INVALID_NUMBER && page_number < num_pages &&
+         listed < num_pages;
+         page_number = readPageHeader(page_number).next_page_number, ++listed) {
+      cached.setUsed(page_number, true);
+    }
+  } else if (!cached.dirty) {
+    // New files come with their empty directory set up; others read theirs.
+    cached.directory.resize(header.num_directory_pages);
+    readAt(cached.directory.data(), cached.directory.size() * sizeof(PageId),
+           DIRECTORY_LIST_OFFSET);
+    cached.used.assign(cached.coveredPages() / 64, 0);
+    cached.dirty_bits.assign(cached.directory.size() + 1, false);
+    for (std::size_t part = 0; part <= cached.directory.size(); ++part) {
+      const std::size_t begin = firstPageOfBits(part) / 64;
+      const std::size_t end = firstPageOfBits(part + 1) / 64;
+      readAt(&cached.used[begin], (end - begin) * sizeof(std::uint64_t),
+             part == 0 ? FIRST_BITS_OFFSET
+                       : pagePosition(cached.directory[part - 1]));
+    }
+  }
+  // Every page which is neither used nor a directory page is free.
+  std::vector<std::uint64_t> taken(cached.used);
+  for (std::size_t i = 0; i < cached.directory.size(); ++i) {
+    taken[cached.directory[i] / 64] |= std::uint64_t(1) << (cached.directory[i] % 64);
+  }
+  cached.free_pages.clear();
+  for (PageId page_number = header.num_pages; page_number-- > 1;) {
+    if (!(taken[page_number / 64] >> (page_number % 64) & 1)) {
+      cached.free_pages.push_back(page_number);
+    }
+  }
+  header.num_free_pages = cached.free_pages.size();
+  header.first_free_page = cached.free_pages.empty()
+      ? Page::INVALID_NUMBER : cached.free_pages.back();
+  header.first_used_page = cached.nextUsed(Page::INVALID_NUMBER);
+  if (cached.dirty && !mapped()) {
+    writeBackHeader();
+  }
+}
+
+bool File::isPageUsed(const PageId page_number) const {
+  std::lock_guard<std::mutex> guard(header_->mutex);
+  return header_->isUsed(page_number);
+}
+
+PageId File::nextUsedPage(const PageId page_number) const {
+  std::lock_guard<std::mutex> guard(header_->mutex);
+  return header_->nextUsed(page_number);
+}
+
+PageId File::CachedHeader::coveredPages() const {
+  return firstPageOfBits(directory.size() + 1);
+}
+
+bool File::CachedHeader::isUsed(const PageId page_number) const {
+  return page_number < header.num_pages &&
+      (used[page_number / 64] >> (page_number % 64) & 1);
+}
+
+void File::CachedHeader::setUsed(const PageId page_number,
+                                 const bool page_used) {
+  const std::uint64_t bit = std::uint64_t(1) << (page_number % 64);
+  if (page_used) {
+    used[page_number / 64] |= bit;
+  } else {
+    used[page_number / 64] &= ~bit;
+  }
+  dirty_bits[bitsOfPage(page_number)] = true;
+}
+
+PageId File::CachedHeader::nextUsed(const PageId page_number) const {
+  PageId next = page_number + 1;
+  while (next < header.num_pages) {
+    const std::uint64_t word = used[next / 64] >> (next % 64);
+    if (word != 0) {
+      next += __builtin_ctzll(word);
+      return next < header.num_pages ? next : Page::INVALID_NUMBER;
+    }
+    next = (next / 64 + 1) * 64;
+  }
+  return Page::INVALID_NUMBER;
+}
+
+void File::CachedHeader::addDirectoryPage(const PageId page_number) {
+  directory.push_back(page_number);
+  used.resize(coveredPages() / 64, 0);
+  // The bits of the new directory page are written even if none is set.
+  dirty_bits.push_back(true);
+}
+
+bool File::CachedHeader::changed() {
+  dirty = true;
+  ++changes;
+  return write_interval > 0 && changes >= write_interval;
 }
 
 PageHeader File::readPageHeader(PageId page_number) const {
   PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+  readAt(&header, sizeof(header), pagePosition(page_number));
 
   return header;
 }
 
+void File::readAt(void* buffer, const std::size_t length,
+                  const off_t position) const {
+  struct iovec iov = {buffer, length};
+  readAt(&iov, 1, position);
+}
+
+void File::readAt(struct iovec* iov, std::size_t count,
+                  off_t position) const {
+  if (mapped()) {
+    // Copy out of the mapping; bytes past its end read as zero.
+    for (std::size_t i = 0; i < count; ++i) {
+      const std::size_t length = iov[i].iov_len;
+      const std::size_t start = std::min<std::size_t>(position, mapping_size_);
+      const std::size_t copied = std::min(length, mapping_size_ - start);
+      std::memcpy(iov[i].iov_base, mapping_ + start, copied);
+      std::memset(static_cast<char*>(iov[i].iov_base) + copied, 0,
+                  length - copied);
+      position += length;
+    }
+    return;
+  }
+  if (direct_ && !aligned(iov, count, position)) {
+    // Read the whole blocks covering the range and copy the bytes asked for.
+    const off_t start = position - position % BLOCK;
+    const std::size_t end = position + totalLength(iov, count);
+    const std::size_t span = (end + BLOCK - 1) / BLOCK * BLOCK - start;
+    AlignedBuffer buffer = allocateAligned(span);
+    struct iovec blocks = {buffer.get(), span};
+    readAt(&blocks, 1, start);
+    const char* next = buffer.get() + (position - start);
+    for (std::size_t i = 0; i < count; ++i) {
+      std::memcpy(iov[i].iov_base, next, iov[i].iov_len);
+      next += iov[i].iov_len;
+    }
+    return;
+  }
+  while (count > 0) {
+    const ssize_t done = ::preadv(fd_, iov, std::min<std::size_t>(count, IOV_MAX),
+                                  position);
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIoException(filename_, errno);
+    }
+    if (done == 0) {
+      // Past the end of the file.
+      for (; count > 0; ++iov, --count) {
+        std::memset(iov->iov_base, 0, iov->iov_len);
+      }
+      return;
+    }
+    position += done;
+    advance(iov, count, done);
+  }
+}
+
+void File::writeAt(const void* buffer, const std::size_t length,
+                   const off_t position) {
+  struct iovec iov = {const_cast<void*>(buffer), length};
+  writeAt(&iov, 1, position);
+}
+
+void File::writeAt(struct iovec* iov, std::size_t count, off_t position) {
+  if (direct_ && !aligned(iov, count, position)) {
+    // Write the whole blocks covering the range, reading them first unless
+    // the range covers them entirely.
+    const off_t start = position - position % BLOCK;
+    const std::size_t end = position + totalLength(iov, count);
+    const std::size_t span = (end + BLOCK - 1) / BLOCK * BLOCK - start;
+    AlignedBuffer buffer = allocateAligned(span);
+    struct iovec blocks = {buffer.get(), span};
+    if (start != position || end != start + span) {
+      readAt(&blocks, 1, start);
+    }
+    char* next = buffer.get() + (position - start);
+    for (std::size_t i = 0; i < count; ++i) {
+      std::memcpy(next, iov[i].iov_base, iov[i].iov_len);
+      next += iov[i].iov_len;
+    }
+    writeAt(&blocks, 1, start);
+    return;
+  }
+  while (count > 0) {
+    const ssize_t done = ::pwritev(fd_, iov, std::min<std::size_t>(count, IOV_MAX),
+                                   position);
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIoException(filename_, errno);
+    }
+    if (done == 0) {
+      // Nothing written although there was room: no progress would be made.
+      throw FileIoException(filename_, EIO);
+    }
+    position += done;
+    advance(iov, count, done);
+  }
+}
+
 }
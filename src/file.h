@@ -7,10 +7,15 @@
 
 #pragma once
 
-#include <fstream>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #include "page.h"
 
@@ -22,6 +27,18 @@ class FileIterator;
  * @brief Header metadata for files on disk which contain pages.
  */
 struct FileHeader {
+  /**
+   * Identifies files written by File, which set it to a fixed value.
+   */
+  std::uint32_t magic;
+
+  /**
+   * Version of the layout of the file on disk.  Files of another version,
+   * and files without the magic number, are not read as they are: files in
+   * the original layout are migrated when they are opened, others rejected.
+   */
+  std::uint32_t format_version;
+
   /**
    * Number of pages allocated in the file.
    */
@@ -42,6 +59,19 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Version of the page directory of the file; 0 in files which still link
+   * their used pages in a list, as migrated files do until they are
+   * converted when they are opened.
+   */
+  PageId directory_version;
+
+  /**
+   * Number of directory pages, besides page 0 which also holds the bits of
+   * the first pages.
+   */
+  PageId num_directory_pages;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -49,26 +79,95 @@ struct FileHeader {
    * @return  True if the other header is equal to this one.
    */
   bool operator==(const FileHeader& rhs) const {
-    return num_pages == rhs.num_pages &&
+    return magic == rhs.magic &&
+        format_version == rhs.format_version &&
+        num_pages == rhs.num_pages &&
         num_free_pages == rhs.num_free_pages &&
         first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
+        first_free_page == rhs.first_free_page &&
+        directory_version == rhs.directory_version &&
+        num_directory_pages == rhs.num_directory_pages;
   }
 };
 
+/**
+ * @brief Ways File reads and writes the underlying file.
+ */
+enum class FileMode {
+  /**
+   * Reads and writes go through the page cache of the kernel.
+   */
+  BUFFERED,
+
+  /**
+   * The file is opened with O_DIRECT, so pages move between the disk and the
+   * page objects, such as frames of a buffer pool, without being cached by
+   * the kernel as well.  Where the filesystem rejects O_DIRECT the file is
+   * opened BUFFERED instead.
+   */
+  DIRECT,
+
+  /**
+   * The file is opened read-only and mapped into memory as a whole, for
+   * scanning files which do not change.  Pages are read from the mapping
+   * without system calls, and File::viewPage() hands out pages in place.
+   * Calls which would change the file throw FileReadOnlyException.  Only for
+   * File::open(); File::create() opens the new file BUFFERED instead.
+   */
+  MAPPED
+};
+
 /**
  * @brief Class which represents a file in the filesystem containing database
  *        pages.
  *
- * The File class wraps a stream to an underlying file on disk.  Files contain
- * fixed-sized pages, and they never deallocate space (though they do reuse
- * deleted pages if possible).  If multiple File objects refer to the same
- * underlying file, they will share the stream in memory.
+ * The File class wraps a descriptor of an underlying file on disk.  Files
+ * contain fixed-sized pages, and they never deallocate space (though they do
+ * reuse deleted pages if possible).  If multiple File objects refer to the same
+ * underlying file, they will share the descriptor.
  * If a file that has already been opened (possibly by another query), then the File class
- * detects this (by looking in the open_streams_ map) and just returns a file object with
- * the already created stream for the file without actually opening the UNIX file again. 
+ * detects this (by looking in the open_descriptors_ map) and just returns a file object with
+ * the already opened descriptor for the file without actually opening the UNIX file again. 
+ *
+ * Pages are read and written with pread()/pwrite() at their offset in the
+ * file, so there is no shared file position.  Calls which change the file
+ * (writePage()/allocatePage()/deletePage()) are serialized through a recursive
+ * mutex that is shared by all File objects for the same underlying file; reads
+ * do not take it, so several threads can read the same file at once.  Each
+ * call is atomic with respect to the calls which change the file, but a
+ * sequence of calls is not.
+ *
+ * Page n is stored at offset n * Page::SIZE, the file header taking the place
+ * of page 0, so pages are aligned on disk as they are in memory.  The header
+ * starts with a magic number and the version of this layout.  Files in the
+ * original layout, a 16-byte header followed by page n at offset
+ * 16 + (n - 1) * Page::SIZE, are migrated when they are opened: the pages are
+ * copied into a new file in this layout, which then replaces the original.
+ * Files in no known layout are not opened, and never written.  A file
+ * opened with FileMode::DIRECT reads and writes whole pages from and into the
+ * given page objects directly; smaller reads and writes, such as of the file
+ * header, go through an aligned buffer covering the blocks they touch.  A
+ * file opened with FileMode::MAPPED is read from a mapping of the file as it
+ * was when opened; FileIterator advises the kernel to read ahead of a scan.
+ *
+ * The file header is read from disk once, when the file is opened, and kept
+ * in memory shared by all File objects for the file, so page reads check
+ * their bounds without I/O.  Changes to it are written back on sync(), when
+ * the file is closed, or as set by setHeaderWriteInterval().
+ *
+ * Reads and writes which fail throw FileIoException.  Closing the file cannot
+ * throw, so it only reports a failure to write the header back on std::cerr;
+ * call sync() first to have it thrown.
  *
- * @warning This class is not threadsafe.
+ * Which pages are used is recorded in a page directory: a bitmap with one bit
+ * per page, of which page 0 holds the bits of the first pages after the file
+ * header, and dedicated directory pages the bits of the pages after them.
+ * The directory is kept in memory with the header and written back with it,
+ * so allocating, deleting and checking a page take no extra I/O, and
+ * FileIterator visits the used pages in the order of their numbers.  Files
+ * migrated from the original layout, which linked their used and free pages
+ * in lists through the pages, are converted when they are opened; files with
+ * a directory of another version are rejected.
  */
 class File {
  public:
@@ -76,21 +175,32 @@ class File {
    * Creates a new file.
    *
    * @param filename  Name of the file.
+   * @param mode      How to read and write the file.
    * @throws  FileExistsException     If the requested file already exists.
    */
-  static File create(const std::string& filename);
+  static File create(const std::string& filename,
+                     const FileMode mode = FileMode::BUFFERED);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
-	 * It first checks if the file is already open. If so, then the new File object created uses the same input-output stream to read to or write fom
-	 * that already open file. Reference count (open_counts_ static variable inside the File object) is incremented whenever an already open file is
-	 * opened again. Otherwise the UNIX file is actually opened. The fileName and the stream associated with this File object are inserted into the
-	 * open_streams_ map.
+	 * It first checks if the file is already open. If so, then the new File object created shares the file descriptor of that already open file
+	 * to read from and write to it. Reference count (open_counts_ static variable inside the File object) is incremented whenever an already open
+	 * file is opened again. Otherwise the UNIX file is actually opened, its descriptor is kept in open_descriptors_ and its count in open_counts_
+	 * starts at one.  A file which is open already keeps the mode it was
+	 * opened with.
    *
    * @param filename  Name of the file.
+   * @param mode      How to read and write the file.
    * @throws  FileNotFoundException   If the requested file doesn't exist.
+   * @throws  FileFormatException     If the file is in no known layout.
+   * @throws  FileReadOnlyException   If the file is in the original layout,
+   *                                  which cannot be migrated in
+   *                                  FileMode::MAPPED.
+   * @throws  FileFullException       If the file links more pages in a list
+   *                                  than a page directory can cover.
    */
-  static File open(const std::string& filename);
+  static File open(const std::string& filename,
+                   const FileMode mode = FileMode::BUFFERED);
 
   /**
    * Deletes an existing file.
@@ -142,9 +252,23 @@ class File {
    * Allocates a new page in the file.
    *
    * @return The new page.
+   * @throws  FileReadOnlyException If the file is open read-only.
+   * @throws  FileFullException     If the page directory of the file cannot
+   *                                cover any more pages.
    */
   Page allocatePage();
 
+  /**
+   * Allocates a new page in the file and places it into the given page
+   * object, such as a frame of a buffer pool, instead of returning a copy.
+   *
+   * @param new_page  Page object the new page is placed into.
+   * @throws  FileReadOnlyException If the file is open read-only.
+   * @throws  FileFullException     If the page directory of the file cannot
+   *                                cover any more pages.
+   */
+  void allocatePage(Page& new_page);
+
   /**
    * Reads an existing page from the file.
    *
@@ -155,22 +279,111 @@ class File {
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page from the file into the given page object, such as
+   * a frame of a buffer pool, without an intermediate copy.  Unlike
+   * readPage(), a page that does not exist is reported through the return
+   * value instead of an exception.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page object to read the page into.
+   * @return  False if the page doesn't exist in the file or is not currently
+   *          used; the contents of page are undefined in that case.
+   */
+  bool tryReadPage(const PageId page_number, Page& page) const;
+
+  /**
+   * Reads consecutive existing pages with one seek, like tryReadPage() on
+   * each of them.
+   *
+   * @param first   Number of the first page to read.
+   * @param count   Number of pages to read.
+   * @param pages   Page objects to read the pages into, one per page.
+   * @param found   Set to false for every page which doesn't exist in the file
+   *                or is not currently used, true for the others.
+   */
+  void tryReadPages(const PageId first, const std::uint32_t count,
+                    Page* const* pages, bool* found) const;
+
+  /**
+   * Reads existing pages like tryReadPage() on each of them, reading every run
+   * of consecutive pages with one request and submitting all runs to
+   * IoEngine::instance() together, so that they are in flight at once.
+   *
+   * @param page_numbers  Numbers of the pages to read, increasing.
+   * @param count         Number of pages to read.
+   * @param pages         Page objects to read the pages into, one per page.
+   * @param found         Set to false for every page which doesn't exist in
+   *                      the file or is not currently used, true for the
+   *                      others.
+   */
+  void tryReadPages(const PageId* page_numbers, const std::uint32_t count,
+                    Page* const* pages, bool* found) const;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
    *
    * @see allocatePage()
    * @param new_page  Page to write.
+   * @throws  FileReadOnlyException If the file is open read-only.
    */
   void writePage(const Page& new_page);
 
+  /**
+   * Writes several pages into the file like writePage() on each of them, but
+   * with one vectored write for every run of consecutive page numbers.  The
+   * writes are submitted to IoEngine::instance() together.
+   *
+   * @param pages   Pages to write, in increasing order of page number.
+   * @param count   Number of pages.
+   * @throws  InvalidPageException  If one of the pages has been deleted from
+   *                                the file; no page is written then.
+   * @throws  FileReadOnlyException If the file is open read-only.
+   */
+  void writePages(const Page* const* pages, const std::uint32_t count);
+
   /**
    * Deletes a page from the file.
    *
    * @param page_number   Number of page to delete.
+   * @throws  FileReadOnlyException If the file is open read-only.
    */
   void deletePage(const PageId page_number);
 
+  /**
+   * Writes the file header back to disk if it changed since it was last
+   * written, and waits until the file is on disk.
+   *
+   * @throws  FileIoException If writing the header or the file fails.
+   */
+  void sync();
+
+  /**
+   * Sets after how many changes of the file header, such as pages allocated
+   * or deleted, it is written back to disk.  With 0, the default, the header
+   * is only written by sync() and when the last File object for the file is
+   * closed; after a crash the header on disk may then miss the pages
+   * allocated or deleted since.  The setting is shared with every other File
+   * object for the same file.
+   *
+   * @param changes   Changes after which to write the header, or 0.
+   */
+  void setHeaderWriteInterval(const std::uint32_t changes);
+
+  /**
+   * Returns an existing page of a file opened with FileMode::MAPPED in place,
+   * without copying it out of the mapping.  The page stays valid as long as
+   * the file is open.
+   *
+   * @param page_number   Number of page to view.
+   * @return  The page, in the mapping of the file.
+   * @throws  InvalidPageException  If the page doesn't exist in the file, is
+   *                                not currently used, or the file is not
+   *                                mapped.
+   */
+  const Page& viewPage(const PageId page_number) const;
+
   /**
    * Returns the name of the file this object represents.
    *
@@ -178,6 +391,31 @@ class File {
    */
   const std::string& filename() const { return filename_; }
 
+  /**
+   * Returns a number identifying this File object.  Ids are unique among all
+   * File objects created by the process and never change during the lifetime
+   * of an object (even when another file is assigned to it), so they can
+   * stand in for the address of the object in compact keys.
+   *
+   * @return Id of this object.
+   */
+  std::uint32_t id() const { return id_; }
+
+  /**
+   * Returns true if the file is read and written with direct I/O, false if it
+   * was opened with FileMode::BUFFERED or the filesystem rejected O_DIRECT.
+   *
+   * @return True if the file bypasses the page cache.
+   */
+  bool direct() const { return direct_; }
+
+  /**
+   * Returns true if the file was opened with FileMode::MAPPED.
+   *
+   * @return True if the file is read from a mapping.
+   */
+  bool mapped() const { return mapping_ != NULL; }
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -201,8 +439,8 @@ class File {
    * @param page_number   Number of page.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  static off_t pagePosition(const PageId page_number) {
+    return static_cast<off_t>(page_number) * Page::SIZE;
   }
 
   /**
@@ -214,28 +452,73 @@ class File {
    * @see File::open()
    * @param name        Name of file.
    * @param create_new  Whether to create a new file.
+   * @param mode        How to read and write the file.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  File(const std::string& name, const bool create_new);
+  File(const std::string& name, const bool create_new, const FileMode mode);
 
   /**
    * Opens the underlying file named in filename_.
    * This method only opens the file if no other File objects exist that access
-   * the same filesystem file; otherwise, it reuses the existing stream.
+   * the same filesystem file; otherwise, it shares their file descriptor and
+   * increments the file's count in open_counts_.
    *
    * @param create_new  Whether to create a new file.
+   * @param mode        How to read and write the file if it is not open yet.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
+   * @throws  FileFormatException     If the file is in no known layout.
+   */
+  void openIfNeeded(const bool create_new, const FileMode mode);
+
+  /**
+   * Returns true if the file opened in fd_, whose header does not carry the
+   * magic number, is in the original layout: a 16-byte header followed by
+   * pages of Page::SIZE bytes, as many as the header counts.
+   */
+  bool isOriginalLayout() const;
+
+  /**
+   * Migrates the file opened in fd_ from the original layout.  The pages are
+   * copied into a new file at their offsets in the current layout, behind a
+   * header listing the used pages as before, which loadDirectory() converts.
+   * The new file replaces the original once it is on disk, and is opened in
+   * fd_ with the given flags.
+   *
+   * @param flags   Flags the file was opened with.
+   * @throws  FileIoException If reading the file or writing the new one fails.
+   */
+  void migrate(const int flags);
+
+  /**
+   * Maps the file opened in fd_ into memory, read-only.
+   *
+   * @throws  FileNotFoundException   If the file cannot be mapped.
+   */
+  void map();
+
+  /**
+   * Throws FileReadOnlyException if the file is open read-only.
    */
-  void openIfNeeded(const bool create_new);
+  void checkWritable() const;
 
   /**
-   * Closes the underlying file stream in <stream_>.
+   * Advises the kernel that pages starting at the given one will be read
+   * soon, when the file is mapped.
+   *
+   * @param page_number   Number of the first page to read ahead.
+   * @return  Number of the page after the last one advised.
+   */
+  PageId adviseReadAhead(const PageId page_number) const;
+
+  /**
+   * Closes the underlying file descriptor in <fd_> once no other File object
+   * uses it.
    * This method only closes the file if no other File objects exist that access
    * the same file.
    */
@@ -245,17 +528,32 @@ class File {
    * Reads a page from the file.  If <allow_free> is not set, an exception
    * will be thrown if the page read from disk is not currently in use.
    *
-   * No bounds checking is performed; the underlying file stream will throw
-   * an exception if the page is past the end of the file.
+   * No bounds checking is performed.  The page is read with readAt(), which
+   * throws FileIoException if the read fails; a page past the end of the file
+   * reads as zero, so it is free.
    *
    * @param page_number   Number of page to read.
    * @param allow_free    Whether to allow reading a free (unused) page.
    * @return  The page.
+   * @throws  FileIoException       If the page cannot be read.
    * @throws  InvalidPageException  If the page is free (unused) and
    *                                allow_free is false.
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
+  /**
+   * Reads a page from the file into the given page object.  Like
+   * readPage(page_number, allow_free), but reports a free page through the
+   * return value.
+   *
+   * @param page_number   Number of page to read.
+   * @param allow_free    Whether to allow reading a free (unused) page.
+   * @param page          Page object to read the page into.
+   * @return  False if the page is free (unused) and allow_free is false.
+   */
+  bool readPage(const PageId page_number, const bool allow_free,
+                Page& page) const;
+
   /**
    * Writes a page into the file at the given page number.  This does not
    * update ensure that the number in the header equals the position on disk.
@@ -267,30 +565,53 @@ class File {
   void writePage(const PageId page_number, const Page& new_page);
 
   /**
-   * Writes a page into the file at the given page number with the given header.
-   * This does not ensure that the number in the header equals the position on
-   * disk.  No bounds checking is performed.
+   * Returns the header for this file, as kept in memory.
    *
-   * @param page_number Number of page whose contents to replace.
-   * @param header      Header of page to write.
-   * @param new_page    Page to write.
+   * @return  The file header.
    */
-  void writePage(const PageId page_number, const PageHeader& header,
-                 const Page& new_page);
+  FileHeader readHeader() const;
 
   /**
-   * Reads the header for this file from disk.
+   * Replaces the header for this file in memory.  It is written to disk when
+   * the write interval of the header is reached.
    *
-   * @return  The file header.
+   * @param header  New file header.
    */
-  FileHeader readHeader() const;
+  void writeHeader(const FileHeader& header);
 
   /**
-   * Writes the given header to the disk as the header for this file.
+   * Writes the header and the page directory for this file to disk where they
+   * changed since they were last written.
+   */
+  void writeBackHeader();
+
+  /**
+   * Reads the page directory of the file just opened into header_, or builds
+   * it from the list of used pages of a file migrated from the original
+   * layout.
    *
-   * @param header  File header to write.
+   * @throws  FileFormatException     If the file has a directory of another
+   *                                  version, or one not covering its pages.
+   * @throws  FileFullException       If the directory of a file linking its
+   *                                  pages in a list cannot cover them.
    */
-  void writeHeader(const FileHeader& header);
+  void loadDirectory();
+
+  /**
+   * Returns true if the page exists in the file and is currently used.
+   *
+   * @param page_number   Number of page.
+   */
+  bool isPageUsed(const PageId page_number) const;
+
+  /**
+   * Returns the number of the first used page after the given one.
+   *
+   * @param page_number   Number of page.
+   * @return  Number of next used page, or Page::INVALID_NUMBER if there is
+   *          none.
+   */
+  PageId nextUsedPage(const PageId page_number) const;
 
   /**
    * Reads only the header of the given page from disk (not the record data
@@ -301,29 +622,231 @@ class File {
    */
   PageHeader readPageHeader(const PageId page_number) const;
 
-  typedef std::map<std::string,
-                   std::shared_ptr<std::fstream> > StreamMap;
-  typedef std::map<std::string, int> CountMap;
+  /**
+   * Reads length bytes at the given offset in the file.  Bytes past the end
+   * of the file read as zero.  Like the other readAt() and writeAt() methods,
+   * it goes through an aligned buffer if the file uses direct I/O and the
+   * memory, length or offset are not aligned, retries reads and writes
+   * interrupted by a signal, and throws on any other error.
+   *
+   * @param buffer    Memory to read into.
+   * @param length    Number of bytes to read.
+   * @param position  Offset in the file.
+   * @throws  FileIoException If the read fails.
+   */
+  void readAt(void* buffer, const std::size_t length,
+              const off_t position) const;
 
   /**
-   * Streams for opened files.
+   * Writes length bytes at the given offset in the file.
+   *
+   * @param buffer    Memory to write from.
+   * @param length    Number of bytes to write.
+   * @param position  Offset in the file.
+   * @throws  FileIoException If the write fails.
    */
-  static StreamMap open_streams_;
+  void writeAt(const void* buffer, const std::size_t length,
+               const off_t position);
+
+  /**
+   * Reads into several buffers, one after the other, starting at the given
+   * offset in the file.  Bytes past the end of the file read as zero.
+   *
+   * @param iov       Buffers to read into; changed by the call.
+   * @param count     Number of buffers.
+   * @param position  Offset in the file.
+   * @throws  FileIoException If the read fails.
+   */
+  void readAt(struct iovec* iov, std::size_t count, off_t position) const;
+
+  /**
+   * Writes several buffers, one after the other, starting at the given offset
+   * in the file.
+   *
+   * @param iov       Buffers to write; changed by the call.
+   * @param count     Number of buffers.
+   * @param position  Offset in the file.
+   * @throws  FileIoException If the write fails.
+   */
+  void writeAt(struct iovec* iov, std::size_t count, off_t position);
+
+  typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, int> DescriptorMap;
+  typedef std::map<std::string, bool> DirectMap;
+
+  /**
+   * Header and page directory of an opened file kept in memory.
+   */
+  struct CachedHeader {
+    /**
+     * Returns the number of pages the directory has bits for.
+     */
+    PageId coveredPages() const;
+
+    /**
+     * Returns true if the page is used.
+     */
+    bool isUsed(const PageId page_number) const;
+
+    /**
+     * Sets whether the page is used.
+     */
+    void setUsed(const PageId page_number, const bool page_used);
+
+    /**
+     * Returns the first used page after the given one, or
+     * Page::INVALID_NUMBER.
+     */
+    PageId nextUsed(const PageId page_number) const;
+
+    /**
+     * Makes the given page a directory page for the pages after the ones
+     * covered so far.
+     */
+    void addDirectoryPage(const PageId page_number);
+
+    /**
+     * Records a change of header, and returns true if the write interval has
+     * been reached.
+     */
+    bool changed();
+
+    /**
+     * Protects the other members.
+     */
+    std::mutex mutex;
+
+    /**
+     * The authoritative header of the file.
+     */
+    FileHeader header;
+
+    /**
+     * Numbers of the directory pages besides page 0.
+     */
+    std::vector<PageId> directory;
+
+    /**
+     * One bit per page, set for used pages.
+     */
+    std::vector<std::uint64_t> used;
+
+    /**
+     * Free pages, the page freed last at the back.
+     */
+    std::vector<PageId> free_pages;
+
+    /**
+     * Whether the bits stored in page 0 (0) or in a directory page (1 and up)
+     * differ from the ones on disk.
+     */
+    std::vector<bool> dirty_bits;
+
+    /**
+     * Whether header or directory differs from the ones on disk.
+     */
+    bool dirty;
+
+    /**
+     * Changes to header since it was last written to disk.
+     */
+    std::uint32_t changes;
+
+    /**
+     * Changes after which header is written to disk, or 0.
+     */
+    std::uint32_t write_interval;
+  };
+  typedef std::map<std::string, std::shared_ptr<CachedHeader> > HeaderMap;
+  typedef std::map<std::string, std::pair<char*, std::size_t> > MappingMap;
+  typedef std::map<std::string,
+                   std::shared_ptr<std::recursive_mutex> > LockMap;
 
   /**
    * Counts for opened files.
    */
   static CountMap open_counts_;
 
+  /**
+   * Locks serializing changes to opened files.
+   */
+  static LockMap open_locks_;
+
+  /**
+   * File descriptors of opened files.
+   */
+  static DescriptorMap open_descriptors_;
+
+  /**
+   * Whether opened files use direct I/O.
+   */
+  static DirectMap open_direct_;
+
+  /**
+   * Mappings and their sizes of files opened with FileMode::MAPPED.
+   */
+  static MappingMap open_mappings_;
+
+  /**
+   * Headers of opened files.
+   */
+  static HeaderMap open_headers_;
+
+  /**
+   * Protects open_counts_, open_locks_, open_descriptors_, open_direct_,
+   * open_mappings_ and open_headers_.
+   */
+  static std::mutex open_files_mutex_;
+
+  /**
+   * Id handed out to the next File object constructed.
+   */
+  static std::atomic<std::uint32_t> next_id_;
+
   /**
    * Name of the file this object represents.
    */
   std::string filename_;
 
   /**
-   * Stream for underlying filesystem object.
+   * Lock serializing changes to the file; shared with every other File object
+   * for the same underlying file.
+   */
+  std::shared_ptr<std::recursive_mutex> lock_;
+
+  /**
+   * Header of the file kept in memory; shared with every other File object
+   * for the same underlying file.
+   */
+  std::shared_ptr<CachedHeader> header_;
+
+  /**
+   * File descriptor of the underlying filesystem object; shared with every
+   * other File object for the same underlying file.
+   */
+  int fd_;
+
+  /**
+   * Whether fd_ was opened with O_DIRECT.
+   */
+  bool direct_;
+
+  /**
+   * Mapping of the whole file if it was opened with FileMode::MAPPED, NULL
+   * otherwise; shared with every other File object for the same underlying
+   * file.
+   */
+  char* mapping_;
+
+  /**
+   * Size of mapping_ in bytes, the size of the file when it was opened.
+   */
+  std::size_t mapping_size_;
+
+  /**
+   * Id of this object.
    */
-  std::shared_ptr<std::fstream> stream_;
+  std::uint32_t id_;
 
   friend class FileIterator;
   friend class FileTest;
@@ -18,7 +18,7 @@ namespace badgerdb {
  * @brief Iterator for iterating over the pages in a file.
  *
  * This class provides a forward-only iterator for iterating over all of the
- * pages in a file.
+ * used pages in a file, in the order of their page numbers.
  */
 class FileIterator {
  public:
@@ -27,7 +27,9 @@ class FileIterator {
    */
   FileIterator()
       : file_(NULL),
-        current_page_number_(Page::INVALID_NUMBER) {
+        current_page_number_(Page::INVALID_NUMBER),
+        advised_begin_(Page::INVALID_NUMBER),
+        advise_next_(Page::INVALID_NUMBER) {
   }
 
   /**
@@ -37,10 +39,13 @@ class FileIterator {
    * @param file  File to iterate over.
    */
   FileIterator(File* file)
-      : file_(file) {
+      : file_(file),
+        advised_begin_(Page::INVALID_NUMBER),
+        advise_next_(Page::INVALID_NUMBER) {
     assert(file_ != NULL);
     const FileHeader& header = file_->readHeader();
     current_page_number_ = header.first_used_page;
+    adviseReadAhead();
   }
 
   /**
@@ -52,7 +57,10 @@ class FileIterator {
    */
   FileIterator(File* file, PageId page_number)
       : file_(file),
-        current_page_number_(page_number) {
+        current_page_number_(page_number),
+        advised_begin_(Page::INVALID_NUMBER),
+        advise_next_(Page::INVALID_NUMBER) {
+    adviseReadAhead();
   }
 
   /**
@@ -60,8 +68,8 @@ class FileIterator {
    */
 	inline FileIterator& operator++() {
     assert(file_ != NULL);
-    const PageHeader& header = file_->readPageHeader(current_page_number_);
-    current_page_number_ = header.next_page_number;
+    current_page_number_ = file_->nextUsedPage(current_page_number_);
+    adviseReadAhead();
 
 		return *this;
 	}
@@ -72,8 +80,8 @@ class FileIterator {
 		FileIterator tmp = *this;   // copy ourselves
 
     assert(file_ != NULL);
-    const PageHeader& header = file_->readPageHeader(current_page_number_);
-    current_page_number_ = header.next_page_number;
+    current_page_number_ = file_->nextUsedPage(current_page_number_);
+    adviseReadAhead();
 
 		return tmp;
 	}
@@ -103,7 +111,34 @@ class FileIterator {
 	inline Page operator*() const
   { return file_->readPage(current_page_number_); }
 
+  /**
+   * Returns the current page of a file opened with FileMode::MAPPED in place,
+   * without copying it.
+   *
+   * @return  Page in the mapping of the file.
+   * @see File::viewPage()
+   */
+  inline const Page& view() const
+  { return file_->viewPage(current_page_number_); }
+
  private:
+  /**
+   * When the file is mapped, advises it to read ahead of the current page
+   * once the scan passed half of the pages advised last, or left them.
+   */
+  void adviseReadAhead() {
+    if (file_ == NULL || !file_->mapped() ||
+        current_page_number_ == Page::INVALID_NUMBER) {
+      return;
+    }
+    if (current_page_number_ < advised_begin_ ||
+        current_page_number_ >= advise_next_) {
+      const PageId end = file_->adviseReadAhead(current_page_number_);
+      advised_begin_ = current_page_number_;
+      advise_next_ = current_page_number_ + (end - current_page_number_) / 2;
+    }
+  }
+
   /**
    * File we're iterating over.
    */
@@ -113,6 +148,16 @@ class FileIterator {
    * Number of page in file iterator is currently pointing to.
    */
   PageId current_page_number_;
+
+  /**
+   * First page advised to be read ahead last, when the file is mapped.
+   */
+  PageId advised_begin_;
+
+  /**
+   * Page at which to advise reading ahead again.
+   */
+  PageId advise_next_;
 };
 
 }
@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace badgerdb {
+
+/**
+ * @brief Reader/writer latch on the contents of one buffer frame, with an
+ *        optimistic read mode validated by a version counter.
+ *
+ * Threads which pinned a page may hold the latch shared or exclusive while
+ * they read or modify it.  A writer waiting for the exclusive latch keeps new
+ * readers out, so writers are not starved by a stream of readers.
+ *
+ * Optimistic readers do not take the latch at all, and so never write to the
+ * cache line holding it: they remember version(), read the page, and check
+ * with validate() that no writer changed it meanwhile, retrying otherwise.
+ * The version is odd while the contents of the frame are changing, either
+ * because a writer holds the latch exclusive or because the buffer manager
+ * is assigning the frame to another page (beginChange() and endChange()), and
+ * grows by one at every such change.
+ */
+class FrameLatch {
+ public:
+  FrameLatch() : state_(0), version_(0) {}
+
+  /**
+   * Takes the latch shared, waiting while a writer holds or waits for it.
+   */
+  void lockShared() {
+    while (!tryLockShared()) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Takes the latch shared unless a writer holds or waits for it.
+   *
+   * @return  True if the latch was taken.
+   */
+  bool tryLockShared() {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    while (!(state & EXCLUSIVE)) {
+      if (state_.compare_exchange_weak(state, state + 1,
+                                       std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Releases a shared hold of the latch.
+   */
+  void unlockShared() {
+    state_.fetch_sub(1, std::memory_order_release);
+  }
+
+  /**
+   * Takes the latch exclusive, waiting for readers to leave.
+   */
+  void lockExclusive() {
+    std::uint32_t state = state_.load(std::memory_order_relaxed);
+    for (;;) {
+      if (state & EXCLUSIVE) {
+        std::this_thread::yield();
+        state = state_.load(std::memory_order_relaxed);
+      } else if (state_.compare_exchange_weak(state, state | EXCLUSIVE,
+                                              std::memory_order_acquire)) {
+        break;
+      }
+    }
+    while (state_.load(std::memory_order_acquire) != EXCLUSIVE) {
+      std::this_thread::yield();
+    }
+    beginChange();
+  }
+
+  /**
+   * Takes the latch exclusive if nobody holds it.
+   *
+   * @return  True if the latch was taken.
+   */
+  bool tryLockExclusive() {
+    std::uint32_t unlatched = 0;
+    if (!state_.compare_exchange_strong(unlatched, EXCLUSIVE,
+                                        std::memory_order_acquire)) {
+      return false;
+    }
+    beginChange();
+    return true;
+  }
+
+  /**
+   * Releases the exclusive latch.  Optimistic reads which overlapped with it
+   * fail validation.
+   */
+  void unlockExclusive() {
+    endChange();
+    state_.store(0, std::memory_order_release);
+  }
+
+  /**
+   * Returns the version to validate an optimistic read against.  If it is odd,
+   * the frame is being changed and the read cannot succeed.
+   */
+  std::uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Checks that the frame did not change since version was returned by
+   * version().  Everything read from the frame in between is consistent if
+   * this returns true.
+   *
+   * @param version   Version returned by version() before the read.
+   * @return  True if the read is valid.
+   */
+  bool validate(const std::uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return !(version & 1) &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Makes the version odd before the contents of the frame change.  Must only
+   * be called by the single thread allowed to change the frame.
+   */
+  void beginChange() {
+    const std::uint64_t version = version_.load(std::memory_order_relaxed);
+    if (!(version & 1)) {
+      version_.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+  }
+
+  /**
+   * Makes the version even again once the frame has changed.
+   */
+  void endChange() {
+    const std::uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store((version | 1) + 1, std::memory_order_release);
+  }
+
+ private:
+  /**
+   * Bit of state_ set while a writer holds or waits for the latch.  The other
+   * bits count the readers holding it.
+   */
+  static const std::uint32_t EXCLUSIVE = 1u << 31;
+
+  std::atomic<std::uint32_t> state_;
+  std::atomic<std::uint64_t> version_;
+};
+
+}
@@ -0,0 +1,361 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "io_engine.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BADGERDB_IO_URING 1
+#endif
+#endif
+
+namespace badgerdb {
+
+const unsigned IoEngine::DEFAULT_DEPTH;
+
+namespace {
+
+/**
+ * Requests of one call to run() which have not completed yet.
+ */
+struct Batch {
+  explicit Batch(const std::size_t count) : remaining(count) {}
+
+  std::size_t remaining;
+};
+
+/**
+ * A request in flight, and the batch it belongs to.
+ */
+struct Slot {
+  IoRequest* request;
+  Batch* batch;
+};
+
+/**
+ * Carries out a request with a blocking system call.
+ */
+ssize_t perform(const IoRequest& request) {
+  for (;;) {
+    const ssize_t done = request.write
+        ? ::pwritev(request.fd, request.iov, request.iovcnt, request.offset)
+        : ::preadv(request.fd, request.iov, request.iovcnt, request.offset);
+    if (done >= 0) {
+      return done;
+    }
+    if (errno != EINTR) {
+      return -errno;
+    }
+  }
+}
+
+/**
+ * Engine whose worker threads take requests off a queue and carry them out
+ * with blocking system calls, one request per thread at a time.
+ */
+class ThreadPoolEngine : public IoEngine {
+ public:
+  explicit ThreadPoolEngine(const unsigned depth)
+      : IoEngine(depth),
+        stop_(false) {
+    for (unsigned i = 0; i < depth; ++i) {
+      workers_.push_back(std::thread(&ThreadPoolEngine::work, this));
+    }
+  }
+
+  ~ThreadPoolEngine() {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      stop_ = true;
+    }
+    queued_.notify_all();
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      workers_[i].join();
+    }
+  }
+
+  void run(IoRequest* requests, const std::size_t count) {
+    if (count == 0) {
+      return;
+    }
+    Batch batch(count);
+    std::vector<Slot> slots(count);
+    std::unique_lock<std::mutex> guard(latch_);
+    for (std::size_t i = 0; i < count; ++i) {
+      slots[i].request = &requests[i];
+      slots[i].batch = &batch;
+      queue_.push_back(&slots[i]);
+    }
+    queued_.notify_all();
+    while (batch.remaining > 0) {
+      completed_.wait(guard);
+    }
+  }
+
+  IoEngineKind kind() const { return IoEngineKind::THREAD_POOL; }
+
+ private:
+  void work() {
+    std::unique_lock<std::mutex> guard(latch_);
+    for (;;) {
+      while (!stop_ && queue_.empty()) {
+        queued_.wait(guard);
+      }
+      if (stop_) {
+        return;
+      }
+      Slot* slot = queue_.front();
+      queue_.pop_front();
+      guard.unlock();
+      const ssize_t result = perform(*slot->request);
+      guard.lock();
+      slot->request->result = result;
+      if (--slot->batch->remaining == 0) {
+        completed_.notify_all();
+      }
+    }
+  }
+
+  std::mutex latch_;
+  std::condition_variable queued_;
+  std::condition_variable completed_;
+  std::deque<Slot*> queue_;
+  std::vector<std::thread> workers_;
+  bool stop_;
+};
+
+#ifdef BADGERDB_IO_URING
+
+/**
+ * Engine submitting requests to an io_uring.  Any thread in run() may queue
+ * requests while there is room in the ring; one of them at a time waits for
+ * completions in the kernel and reaps them for all threads.
+ */
+class UringEngine : public IoEngine {
+ public:
+  /**
+   * Sets up the ring.  Returns NULL if the kernel does not provide io_uring.
+   */
+  static UringEngine* create(const unsigned depth) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+    if (fd < 0) {
+      return NULL;
+    }
+    UringEngine* engine = new UringEngine(depth, fd, params);
+    if (!engine->mapped()) {
+      delete engine;
+      return NULL;
+    }
+    return engine;
+  }
+
+  ~UringEngine() {
+    if (sqes_ != MAP_FAILED) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(fd_);
+  }
+
+  void run(IoRequest* requests, const std::size_t count) {
+    if (count == 0) {
+      return;
+    }
+    Batch batch(count);
+    std::vector<Slot> slots(count);
+    std::size_t next = 0;
+    std::unique_lock<std::mutex> guard(latch_);
+    while (batch.remaining > 0) {
+      unsigned queued = 0;
+      for (; next < count && in_flight_ < depth(); ++next, ++queued) {
+        slots[next].request = &requests[next];
+        slots[next].batch = &batch;
+        queue(slots[next]);
+      }
+      if (reaping_) {
+        if (queued > 0) {
+          enter(queued, 0, 0);
+        }
+        reaped_.wait(guard);
+        continue;
+      }
+      // Wait for completions with the latch released, so that other threads
+      // can queue their requests meanwhile.
+      reaping_ = true;
+      guard.unlock();
+      enter(queued, 1, IORING_ENTER_GETEVENTS);
+      guard.lock();
+      reaping_ = false;
+      reap();
+      reaped_.notify_all();
+    }
+  }
+
+  IoEngineKind kind() const { return IoEngineKind::URING; }
+
+ private:
+  UringEngine(const unsigned depth, const int fd,
+              const struct io_uring_params& params)
+      : IoEngine(depth),
+        fd_(fd),
+        sq_ring_(MAP_FAILED),
+        cq_ring_(MAP_FAILED),
+        sqes_(MAP_FAILED),
+        in_flight_(0),
+        reaping_(false) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes +
+                    params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+      sq_ring_size_ = cq_ring_size_;
+    }
+    sq_ring_ = ::mmap(NULL, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return;
+    }
+    cq_ring_ = single_mmap
+        ? sq_ring_
+        : ::mmap(NULL, cq_ring_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = ::mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return;
+    }
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  bool mapped() const { return sqes_ != MAP_FAILED; }
+
+  /**
+   * Places a request in the submission queue.  The latch must be held.
+   */
+  void queue(Slot& slot) {
+    const IoRequest& request = *slot.request;
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request.write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = request.fd;
+    sqe->addr = reinterpret_cast<std::uintptr_t>(request.iov);
+    sqe->len = request.iovcnt;
+    sqe->off = request.offset;
+    sqe->user_data = reinterpret_cast<std::uintptr_t>(&slot);
+    sq_array_[index] = index;
+    // The kernel may read the entry as soon as it sees the new tail.
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++in_flight_;
+  }
+
+  /**
+   * Submits the queued requests and waits for min_complete completions.
+   */
+  void enter(const unsigned to_submit, const unsigned min_complete,
+             const unsigned flags) {
+    while (::syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags,
+                     NULL, 0) < 0 &&
+           (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+    }
+  }
+
+  /**
+   * Takes all completions off the completion queue.  The latch must be held.
+   */
+  void reap() {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      Slot* slot = reinterpret_cast<Slot*>(static_cast<std::uintptr_t>(cqe.user_data));
+      slot->request->result = cqe.res;
+      --slot->batch->remaining;
+      --in_flight_;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  const int fd_;
+  void* sq_ring_;
+  void* cq_ring_;
+  void* sqes_;
+  std::size_t sq_ring_size_;
+  std::size_t cq_ring_size_;
+  std::size_t sqes_size_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  struct io_uring_cqe* cqes_;
+
+  std::mutex latch_;
+  std::condition_variable reaped_;
+  unsigned in_flight_;
+  bool reaping_;
+};
+
+#endif
+
+}
+
+IoEngine& IoEngine::instance() {
+  static IoEngine* engine = create(IoEngineKind::URING, DEFAULT_DEPTH);
+  return *engine;
+}
+
+IoEngine* IoEngine::create(const IoEngineKind kind, const unsigned depth) {
+  const unsigned clamped = depth > 0 ? depth : 1;
+#ifdef BADGERDB_IO_URING
+  if (kind == IoEngineKind::URING) {
+    IoEngine* engine = UringEngine::create(clamped);
+    if (engine) {
+      return engine;
+    }
+  }
+#endif
+  return new ThreadPoolEngine(clamped);
+}
+
+}
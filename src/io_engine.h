@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace badgerdb {
+
+/**
+ * @brief Kinds of IoEngine.
+ */
+enum class IoEngineKind {
+  /**
+   * Requests are submitted to an io_uring of the kernel.
+   */
+  URING,
+
+  /**
+   * Requests are carried out with preadv()/pwritev() by a pool of threads,
+   * one per request in flight.
+   */
+  THREAD_POOL
+};
+
+/**
+ * @brief One read or write of an IoEngine batch.
+ */
+struct IoRequest {
+  /**
+   * True to write the buffers, false to read into them.
+   */
+  bool write;
+
+  /**
+   * File descriptor to read or write.
+   */
+  int fd;
+
+  /**
+   * Buffers to read into or write from, one after the other.  They must stay
+   * valid until the request completed.
+   */
+  const struct iovec* iov;
+
+  /**
+   * Number of buffers.
+   */
+  int iovcnt;
+
+  /**
+   * Offset in the file of the first byte.
+   */
+  off_t offset;
+
+  /**
+   * Set once the request completed: the number of bytes transferred, which
+   * may be short, or minus the error number.
+   */
+  ssize_t result;
+};
+
+/**
+ * @brief Carries out batches of reads and writes with many requests in
+ *        flight at once.
+ *
+ * A single thread calling pread() keeps one request in flight, which leaves
+ * most of the bandwidth of a fast device unused.  run() submits the requests
+ * of a batch together, keeping up to depth() requests of all calling threads
+ * in flight, and reaps them as they complete.
+ *
+ * The engine uses io_uring where the kernel provides it, and otherwise falls
+ * back to a pool of threads doing blocking I/O.  All methods are thread safe.
+ */
+class IoEngine {
+ public:
+  /**
+   * Number of requests kept in flight by the engine returned by instance().
+   */
+  static const unsigned DEFAULT_DEPTH = 64;
+
+  /**
+   * Returns the engine used by File for batches of page reads and writes.
+   *
+   * @return  The process wide engine.
+   */
+  static IoEngine& instance();
+
+  /**
+   * Creates an engine of the given kind.  If the kernel does not provide
+   * io_uring, URING falls back to THREAD_POOL; kind() tells which one was
+   * created.
+   *
+   * @param kind    Kind of engine to create.
+   * @param depth   Most requests in flight at once.
+   * @return  New engine, to be deleted by the caller.
+   */
+  static IoEngine* create(const IoEngineKind kind, const unsigned depth);
+
+  /**
+   * Waits for the requests in flight and releases the engine.  No thread may
+   * be in run() anymore.
+   */
+  virtual ~IoEngine() {}
+
+  /**
+   * Carries out the requests and returns once all of them completed; their
+   * results are then set.  The requests are independent and may complete in
+   * any order.
+   *
+   * @param requests  Requests to carry out.
+   * @param count     Number of requests.
+   */
+  virtual void run(IoRequest* requests, const std::size_t count) = 0;
+
+  /**
+   * Returns the kind of the engine.
+   */
+  virtual IoEngineKind kind() const = 0;
+
+  /**
+   * Returns the most requests the engine keeps in flight at once.
+   */
+  unsigned depth() const { return depth_; }
+
+ protected:
+  explicit IoEngine(const unsigned depth) : depth_(depth) {}
+
+ private:
+  IoEngine(const IoEngine&);
+  IoEngine& operator=(const IoEngine&);
+
+  const unsigned depth_;
+};
+
+}
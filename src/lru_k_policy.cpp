@@ -0,0 +1,175 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "lru_k_policy.h"
+
+namespace badgerdb {
+
+LruKPolicy::LruKPolicy(const FrameId firstFrame,
+                       const std::uint32_t numFrames)
+    : first_frame_(firstFrame),
+      num_frames_(numFrames),
+      now_(0),
+      frames_(numFrames),
+      evictions_(0) {
+  for (std::uint32_t i = 0; i < num_frames_; ++i) {
+    FrameState& state = frames_[i];
+    for (std::uint32_t k = 0; k < K; ++k) {
+      state.history.times[k] = 0;
+    }
+    state.key = 0;
+    state.resident = false;
+    state.pinned = false;
+    free_.insert(first_frame_ + i);
+  }
+}
+
+LruKPolicy::Candidate LruKPolicy::candidate(const FrameId frame) const {
+  const History& history = frames_[frame - first_frame_].history;
+  return Candidate(std::make_pair(history.times[K - 1], history.times[0]),
+                   frame);
+}
+
+void LruKPolicy::reference(History& history) {
+  for (std::uint32_t k = K - 1; k > 0; --k) {
+    history.times[k] = history.times[k - 1];
+  }
+  history.times[0] = ++now_;
+}
+
+void LruKPolicy::onHit(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  const bool listed = state.resident && !state.pinned;
+  if (listed) {
+    candidates_.erase(candidate(frame));
+  }
+  reference(state.history);
+  if (listed) {
+    candidates_.insert(candidate(frame));
+  }
+}
+
+bool LruKPolicy::pickVictim(const TakeFrame& take, FrameId& frame) {
+  for (std::set<FrameId>::const_iterator it = free_.begin();
+       it != free_.end(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+  for (std::set<Candidate>::const_iterator it = candidates_.begin();
+       it != candidates_.end(); ++it) {
+    if (take(it->second)) {
+      frame = it->second;
+      return true;
+    }
+  }
+  return false;
+}
+
+void LruKPolicy::nextVictims(const std::uint32_t count,
+                             std::vector<FrameId>& frames) const {
+  std::uint32_t listed = 0;
+  for (std::set<Candidate>::const_iterator it = candidates_.begin();
+       it != candidates_.end() && listed < count; ++it, ++listed) {
+    frames.push_back(it->second);
+  }
+}
+
+void LruKPolicy::onEvict(const FrameId frame) {
+  const FrameState& state = frames_[frame - first_frame_];
+  ++evictions_;
+  retained_[state.key] = std::make_pair(state.history, evictions_);
+  retained_order_.push_back(std::make_pair(state.key, evictions_));
+  while (retained_.size() > num_frames_ ||
+         retained_order_.size() > 2 * static_cast<std::size_t>(num_frames_)) {
+    const std::pair<std::uint64_t, std::uint64_t> oldest =
+        retained_order_.front();
+    retained_order_.pop_front();
+    std::unordered_map<std::uint64_t,
+                       std::pair<History, std::uint64_t> >::iterator it =
+        retained_.find(oldest.first);
+    if (it != retained_.end() && it->second.second == oldest.second) {
+      retained_.erase(it);
+    }
+  }
+  release(frame);
+}
+
+void LruKPolicy::onLoad(const FrameId frame, const File* file,
+                        const PageId pageNo) {
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  std::unordered_map<std::uint64_t,
+                     std::pair<History, std::uint64_t> >::iterator retained =
+      retained_.find(state.key);
+  if (retained != retained_.end()) {
+    // The key stays in retained_order_ and is skipped when it comes up.
+    state.history = retained->second.first;
+    retained_.erase(retained);
+  } else {
+    for (std::uint32_t k = 0; k < K; ++k) {
+      state.history.times[k] = 0;
+    }
+  }
+  reference(state.history);
+  state.resident = true;
+  if (!state.pinned) {
+    candidates_.insert(candidate(frame));
+  }
+}
+
+void LruKPolicy::onRemove(const FrameId frame) {
+  release(frame);
+}
+
+void LruKPolicy::release(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.resident && !state.pinned) {
+    candidates_.erase(candidate(frame));
+  }
+  state.resident = false;
+  state.pinned = false;
+  free_.insert(frame);
+}
+
+void LruKPolicy::onLoadCold(const FrameId frame, const File* file,
+                            const PageId pageNo) {
+  // A page without references goes before all others.
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  retained_.erase(state.key);
+  for (std::uint32_t k = 0; k < K; ++k) {
+    state.history.times[k] = 0;
+  }
+  state.resident = true;
+  state.pinned = false;
+  candidates_.insert(candidate(frame));
+}
+
+void LruKPolicy::onPin(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.resident && !state.pinned) {
+    candidates_.erase(candidate(frame));
+  }
+  state.pinned = true;
+}
+
+void LruKPolicy::onUnpin(const FrameId frame, const bool unpinned) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (!unpinned || !state.pinned) {
+    return;
+  }
+  state.pinned = false;
+  if (state.resident) {
+    candidates_.insert(candidate(frame));
+  }
+}
+
+}
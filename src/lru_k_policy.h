@@ -0,0 +1,139 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief LRU-K replacement with K = 2 (O'Neil, O'Neil and Weikum).
+ *
+ * The policy remembers the times of the last K references to every page and
+ * evicts the unpinned page whose K-th most recent reference is oldest.  Pages
+ * referenced fewer than K times count as infinitely old and go first, oldest
+ * last reference first, so a page read once by a scan does not push out a page
+ * that is used repeatedly.  The reference history of evicted pages is retained
+ * for as many pages as there are frames, so a page that comes back soon keeps
+ * its history.
+ *
+ * Time is a counter incremented on every reference.  Pinned frames are kept
+ * out of the candidate set, so choosing a victim is logarithmic in the number
+ * of frames.
+ */
+class LruKPolicy : public ReplacementPolicy {
+ public:
+  /**
+   * Number of references remembered per page.
+   */
+  static const std::uint32_t K = 2;
+
+  LruKPolicy(const FrameId firstFrame, const std::uint32_t numFrames);
+
+  const char* name() const { return "LRU-2"; }
+  void onHit(const FrameId frame);
+  bool pickVictim(const TakeFrame& take, FrameId& frame);
+  void onEvict(const FrameId frame);
+  void onLoad(const FrameId frame, const File* file, const PageId pageNo);
+  void onLoadCold(const FrameId frame, const File* file,
+                  const PageId pageNo);
+  void onRemove(const FrameId frame);
+  void onPin(const FrameId frame);
+  void onUnpin(const FrameId frame, const bool unpinned);
+  void nextVictims(const std::uint32_t count,
+                   std::vector<FrameId>& frames) const;
+
+ private:
+  /**
+   * @brief Times of the last K references to a page, most recent first; 0 if
+   *        the page has been referenced fewer times.
+   */
+  struct History {
+    std::uint64_t times[K];
+  };
+
+  /**
+   * @brief State of one frame.
+   */
+  struct FrameState {
+    History history;
+    std::uint64_t key;
+    bool resident;
+    bool pinned;
+  };
+
+  /**
+   * Order of candidates: K-th most recent reference, then most recent one.
+   */
+  typedef std::pair<std::pair<std::uint64_t, std::uint64_t>, FrameId>
+      Candidate;
+
+  /**
+   * Returns the candidate entry of a frame.
+   */
+  Candidate candidate(const FrameId frame) const;
+
+  /**
+   * Records a reference in a history.
+   */
+  void reference(History& history);
+
+  /**
+   * Frees a frame whose page left the pool.
+   */
+  void release(const FrameId frame);
+
+  const FrameId first_frame_;
+  const std::uint32_t num_frames_;
+
+  /**
+   * Logical time, incremented on every reference.
+   */
+  std::uint64_t now_;
+
+  /**
+   * State of every frame, indexed by frame - first_frame_.
+   */
+  std::vector<FrameState> frames_;
+
+  /**
+   * Frames not holding a page.
+   */
+  std::set<FrameId> free_;
+
+  /**
+   * Unpinned frames holding a page, best victim first.
+   */
+  std::set<Candidate> candidates_;
+
+  /**
+   * Histories of evicted pages by page key, each with the number of the
+   * eviction which retained it.
+   */
+  std::unordered_map<std::uint64_t, std::pair<History, std::uint64_t> >
+      retained_;
+
+  /**
+   * Keys and eviction numbers of retained histories, oldest first.  Entries
+   * whose page has been loaded again or evicted again since are stale.
+   */
+  std::deque<std::pair<std::uint64_t, std::uint64_t> > retained_order_;
+
+  /**
+   * Number of evictions so far.
+   */
+  std::uint64_t evictions_;
+};
+
+}
@@ -3,11 +3,22 @@
 #include <stdio.h>
 #include <cstring>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
 #include "page.h"
 #include "buffer.h"
+#include "io_engine.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
+#include "exceptions/file_format_exception.h"
+#include "exceptions/file_full_exception.h"
 #include "exceptions/file_not_found_exception.h"
+#include "exceptions/file_read_only_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
@@ -36,7 +47,29 @@ void test3();
 void test4();
 void test5();
 void test6();
+void test7();
+void test8();
+void test9();
+void test10();
+void test11();
+void test12();
+void test13();
+void test14();
+void test15();
+void test16();
+void test17();
+void test18();
+void test19();
+void test20();
+void test21();
+void test22();
+void test23();
+void test24();
+void test25();
+void test26();
 void testBufMgr();
+void writeOriginalLayout(const std::string& filename, const PageId numPages, const PageId* listed, const int count,
+                         RecordId* rids);
 
 int main() 
 {
@@ -74,12 +107,14 @@ int main()
     for (FileIterator iter = new_file.begin();
          iter != new_file.end();
          ++iter) {
-      // Iterate through all records on the page.
-      for (PageIterator page_iter = (*iter).begin();
-           page_iter != (*iter).end();
+      // Iterate through all records on the page.  Keep the page alive for
+      // as long as the page iterators that point into it.
+      Page curr_page = *iter;
+      for (PageIterator page_iter = curr_page.begin();
+           page_iter != curr_page.end();
            ++page_iter) {
         std::cout << "Found record: " << *page_iter
-            << " on page " << (*iter).page_number() << "\n";
+            << " on page " << curr_page.page_number() << "\n";
       }
     }
     
@@ -146,6 +181,26 @@ void testBufMgr()
 	test4();
 	test5();
 	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+	test11();
+	test12();
+	test13();
+	test14();
+	test15();
+	test16();
+	test17();
+	test18();
+	test19();
+	test20();
+	test21();
+	test22();
+	test23();
+	test24();
+	test25();
+	test26();
 
 	//Close files before deleting them
 	file1.~File();
@@ -319,3 +374,1193 @@ void test6()
 
 	bufMgr->flushFile(file1ptr);
 }
+
+void test7()
+{
+	//Concurrent readers and writers on a sharded buffer manager.
+	//Every thread reads back random pages of file1 and allocates new pages in file2.
+	const int numThreads = 8;
+	const int opsPerThread = 2000;
+	BufMgr* sharedMgr = new BufMgr(num / 2, 4);
+	std::atomic<bool> failed(false);
+	std::vector<PageId> allocated[numThreads];
+	std::vector<std::thread> threads;
+
+	bufMgr->flushFile(file2ptr);
+
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			char buf[100];
+			unsigned int seed = t + 1;
+			try
+			{
+				for (int op = 0; op < opsPerThread && !failed; op++)
+				{
+					seed = seed * 1103515245 + 12345;
+					Page* p;
+					if ((seed >> 16) % 8 == 0)
+					{
+						PageId newPageNo;
+						sharedMgr->allocPage(file2ptr, newPageNo, p);
+						sprintf(buf, "test.7 Thread %d Page %d", t, newPageNo);
+						p->insertRecord(buf);
+						sharedMgr->unPinPage(file2ptr, newPageNo, true);
+						allocated[t].push_back(newPageNo);
+					}
+					else
+					{
+						PageId pageNo = (seed >> 16) % num + 1;
+						sharedMgr->readPage(file1ptr, pageNo, p);
+						sprintf(buf, "test.1 Page %d %7.1f", pageNo, (float)pageNo);
+						RecordId recordId = {pageNo, 1};
+						if(strncmp(p->getRecord(recordId).c_str(), buf, strlen(buf)) != 0)
+							failed = true;
+						sharedMgr->unPinPage(file1ptr, pageNo, false);
+					}
+				}
+			}
+			catch(BadgerDbException& e)
+			{
+				std::cerr << e << "\n";
+				failed = true;
+			}
+		}));
+	}
+	for (int t = 0; t < numThreads; t++)
+		threads[t].join();
+
+	if (failed)
+	{
+		PRINT_ERROR("ERROR :: CONCURRENT READ OR ALLOCATION FAILED");
+	}
+
+	//Every page allocated by a thread must be readable with the record written by that thread
+	for (int t = 0; t < numThreads; t++)
+	{
+		for (std::size_t j = 0; j < allocated[t].size(); j++)
+		{
+			PageId pageNo = allocated[t][j];
+			sharedMgr->readPage(file2ptr, pageNo, page);
+			sprintf((char*)tmpbuf, "test.7 Thread %d Page %d", t, pageNo);
+			RecordId recordId = {pageNo, 1};
+			if(strncmp(page->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			sharedMgr->unPinPage(file2ptr, pageNo, false);
+		}
+	}
+
+	//No pins may have leaked, so both files can be flushed
+	sharedMgr->flushFile(file1ptr);
+	sharedMgr->flushFile(file2ptr);
+	delete sharedMgr;
+
+	std::cout << "Test 7 passed" << "\n";
+}
+
+void test8()
+{
+	//Status values of the non-throwing read path on a buffer pool of two frames
+	BufMgr* smallMgr = new BufMgr(2);
+	Page* p;
+
+	if (smallMgr->tryReadPage(file1ptr, 1, p) != PageStatus::MISS)
+		PRINT_ERROR("ERROR :: First read of a page should be a miss");
+	if (smallMgr->tryReadPage(file1ptr, 1, p) != PageStatus::HIT)
+		PRINT_ERROR("ERROR :: Second read of a page should be a hit");
+	sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", 1, (float)1);
+	RecordId recordId = {1, 1};
+	if(strncmp(p->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+	if (smallMgr->tryReadPage(file1ptr, 2, p) != PageStatus::MISS)
+		PRINT_ERROR("ERROR :: First read of a page should be a miss");
+	if (smallMgr->tryReadPage(file1ptr, 3, p) != PageStatus::BUFFER_EXCEEDED)
+		PRINT_ERROR("ERROR :: All frames are pinned, no page can be read in");
+
+	smallMgr->unPinPage(file1ptr, 2, false);
+	if (smallMgr->tryReadPage(file1ptr, num + 1, p) != PageStatus::INVALID_PAGE)
+		PRINT_ERROR("ERROR :: Page does not exist in the file");
+	//The frame taken for the invalid page must have been given back
+	if (smallMgr->tryReadPage(file1ptr, 3, p) != PageStatus::MISS)
+		PRINT_ERROR("ERROR :: First read of a page should be a miss");
+
+	smallMgr->unPinPage(file1ptr, 1, false);
+	smallMgr->unPinPage(file1ptr, 1, false);
+	smallMgr->unPinPage(file1ptr, 3, false);
+	smallMgr->flushFile(file1ptr);
+	delete smallMgr;
+
+	std::cout << "Test 8 passed" << "\n";
+}
+
+void test9()
+{
+	//Every replacement policy, with one shard and with several, on a buffer pool of ten frames
+	const PolicyKind policies[] = {PolicyKind::CLOCK, PolicyKind::LRU_K, PolicyKind::TWO_Q, PolicyKind::ARC, PolicyKind::CLOCK_PRO};
+	for (PolicyKind policy : policies)
+	{
+		for (std::uint32_t shardCount = 1; shardCount <= 2; shardCount++)
+		{
+			BufMgr* policyMgr = new BufMgr(10, shardCount, policy);
+			Page* p;
+
+			//A hot page read between the pages of a scan, then a loop over more pages than there are frames
+			for (int round = 0; round < 3; round++)
+			{
+				for (PageId j = 1; j <= num; j++)
+				{
+					PageId pageNo = (j % 3 == 0) ? 1 : j;
+					policyMgr->readPage(file1ptr, pageNo, p);
+					sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pageNo, (float)pageNo);
+					RecordId recordId = {pageNo, 1};
+					if(strncmp(p->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+					{
+						PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+					}
+					policyMgr->unPinPage(file1ptr, pageNo, false);
+				}
+				for (PageId j = 1; j <= 15; j++)
+				{
+					policyMgr->readPage(file1ptr, j, p);
+					policyMgr->unPinPage(file1ptr, j, false);
+				}
+			}
+
+			//Pin pages until every frame of some shard is pinned
+			PageId pinnedUpTo = 0;
+			PageStatus status = PageStatus::HIT;
+			while (status != PageStatus::BUFFER_EXCEEDED && pinnedUpTo < num)
+			{
+				status = policyMgr->tryReadPage(file1ptr, pinnedUpTo + 1, p);
+				if (status != PageStatus::BUFFER_EXCEEDED)
+					pinnedUpTo++;
+			}
+			if (status != PageStatus::BUFFER_EXCEEDED || pinnedUpTo < 10 / shardCount)
+				PRINT_ERROR("ERROR :: All frames are pinned, no page can be read in");
+			for (PageId j = 1; j <= pinnedUpTo; j++)
+				policyMgr->unPinPage(file1ptr, j, false);
+
+			if (policyMgr->tryReadPage(file1ptr, pinnedUpTo + 1, p) == PageStatus::BUFFER_EXCEEDED)
+				PRINT_ERROR("ERROR :: Unpinned frames should be reused");
+			policyMgr->unPinPage(file1ptr, pinnedUpTo + 1, false);
+
+			policyMgr->flushFile(file1ptr);
+			delete policyMgr;
+		}
+	}
+
+	std::cout << "Test 9 passed" << "\n";
+}
+
+void test10()
+{
+	//The background writer cleans dirty pages before they are evicted
+	BufMgr* writerMgr = new BufMgr(10);
+	writerMgr->startBackgroundWriter(10, 32, 1);
+	Page* p;
+	RecordId written[10];
+	for (PageId j = 1; j <= 10; j++)
+	{
+		writerMgr->readPage(file1ptr, j, p);
+		written[j - 1] = p->insertRecord("written behind");
+		writerMgr->unPinPage(file1ptr, j, true);
+	}
+
+	for (int wait = 0; writerMgr->getBufStats().bgwrites < 10; wait++)
+	{
+		if (wait == 5000)
+			PRINT_ERROR("ERROR :: Background writer did not write the dirty pages");
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	//Evicting the written pages does not write them again
+	for (PageId j = 11; j <= 20; j++)
+	{
+		writerMgr->readPage(file1ptr, j, p);
+		writerMgr->unPinPage(file1ptr, j, false);
+	}
+	if (writerMgr->getBufStats().evictwrites != 0)
+		PRINT_ERROR("ERROR :: Evictions should only find clean pages");
+
+	for (PageId j = 1; j <= 10; j++)
+	{
+		writerMgr->readPage(file1ptr, j, p);
+		if (p->getRecord(written[j - 1]) != "written behind")
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		writerMgr->unPinPage(file1ptr, j, false);
+	}
+
+	writerMgr->stopBackgroundWriter();
+	writerMgr->flushFile(file1ptr);
+	delete writerMgr;
+
+	std::cout << "Test 10 passed" << "\n";
+}
+
+void test11()
+{
+	//Sequential reads make the buffer manager read the following pages ahead
+	BufMgr* scanMgr = new BufMgr(20);
+	scanMgr->startReadAhead(8);
+	Page* p;
+	for (PageId j = 1; j <= 2; j++)
+	{
+		scanMgr->readPage(file1ptr, j, p);
+		scanMgr->unPinPage(file1ptr, j, false);
+	}
+
+	for (int wait = 0; scanMgr->getBufStats().prefetches < 1; wait++)
+	{
+		if (wait == 5000)
+			PRINT_ERROR("ERROR :: Pages following a sequential read were not read ahead");
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	//Page 3 is the first page read ahead
+	if (scanMgr->tryReadPage(file1ptr, 3, p) != PageStatus::HIT)
+		PRINT_ERROR("ERROR :: Page read ahead should be a hit");
+	scanMgr->unPinPage(file1ptr, 3, false);
+	if (scanMgr->getBufStats().prefetchhits != 1)
+		PRINT_ERROR("ERROR :: Page read ahead should be counted as used");
+
+	//The rest of the scan reads every page correctly, whether it was read ahead or not
+	for (PageId j = 4; j <= num; j++)
+	{
+		scanMgr->readPage(file1ptr, j, p);
+		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", j, (float)j);
+		RecordId recordId = {j, 1};
+		if(strncmp(p->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		scanMgr->unPinPage(file1ptr, j, false);
+	}
+
+	scanMgr->stopReadAhead();
+	BufStats& stats = scanMgr->getBufStats();
+	if (stats.prefetchhits + stats.prefetchwaste > stats.prefetches)
+		PRINT_ERROR("ERROR :: More pages read ahead were used or wasted than read");
+	scanMgr->flushFile(file1ptr);
+	delete scanMgr;
+
+	std::cout << "Test 11 passed" << "\n";
+}
+
+void test12()
+{
+	//Batched reads and unpins, with one shard and with several
+	for (std::uint32_t shardCount = 1; shardCount <= 2; shardCount++)
+	{
+		BufMgr* batchMgr = new BufMgr(10, shardCount);
+		Page* pages[11];
+		PageStatus statuses[11];
+
+		const PageId batch[] = {5, 3, 4, 3, 50};
+		batchMgr->tryReadPages(file1ptr, batch, 5, pages, statuses);
+		const PageStatus expected[] = {PageStatus::MISS, PageStatus::MISS, PageStatus::MISS, PageStatus::HIT, PageStatus::MISS};
+		for (int j = 0; j < 5; j++)
+		{
+			if (statuses[j] != expected[j])
+				PRINT_ERROR("ERROR :: Unexpected status of a page of the batch");
+			sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", batch[j], (float)batch[j]);
+			RecordId recordId = {batch[j], 1};
+			if(strncmp(pages[j]->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+		}
+		if (pages[1] != pages[3])
+			PRINT_ERROR("ERROR :: A page listed twice should be in one frame");
+
+		//Page 3 was pinned twice, so it is unpinned twice
+		batchMgr->unPinPages(file1ptr, batch, 5, false);
+		try
+		{
+			batchMgr->unPinPage(file1ptr, 3, false);
+			PRINT_ERROR("ERROR :: Page is not pinned, exception should have been thrown");
+		}
+		catch(PageNotPinnedException&)
+		{
+		}
+
+		//A batch that does not fit leaves nothing pinned
+		PageId tooMany[11];
+		for (PageId j = 0; j < 11; j++)
+			tooMany[j] = 20 + j;
+		try
+		{
+			batchMgr->readPages(file1ptr, tooMany, 11, pages);
+			PRINT_ERROR("ERROR :: No more frames left for allocation, exception should have been thrown");
+		}
+		catch(BufferExceededException&)
+		{
+		}
+
+		const PageId invalid[] = {6, num + 5};
+		try
+		{
+			batchMgr->readPages(file1ptr, invalid, 2, pages);
+			PRINT_ERROR("ERROR :: Page does not exist, exception should have been thrown");
+		}
+		catch(InvalidPageException&)
+		{
+		}
+
+		batchMgr->flushFile(file1ptr);
+		delete batchMgr;
+	}
+
+	std::cout << "Test 12 passed" << "\n";
+}
+
+void test13()
+{
+	//A scan through a ScanRing leaves the pages read before it in the buffer pool, with every replacement policy
+	const PolicyKind policies[] = {PolicyKind::CLOCK, PolicyKind::LRU_K, PolicyKind::TWO_Q, PolicyKind::ARC, PolicyKind::CLOCK_PRO};
+	for (PolicyKind policy : policies)
+	{
+		BufMgr* ringMgr = new BufMgr(20, 1, policy);
+		Page* p;
+		for (int round = 0; round < 2; round++)
+		{
+			for (PageId j = 1; j <= 10; j++)
+			{
+				ringMgr->readPage(file1ptr, j, p);
+				ringMgr->unPinPage(file1ptr, j, false);
+			}
+		}
+
+		ScanRing ring(4);
+		for (PageId j = 11; j <= num; j++)
+		{
+			ringMgr->readPage(file1ptr, j, p, &ring);
+			sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", j, (float)j);
+			RecordId recordId = {j, 1};
+			if(strncmp(p->getRecord(recordId).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			ringMgr->unPinPage(file1ptr, j, false);
+		}
+
+		for (PageId j = 1; j <= 10; j++)
+		{
+			if (ringMgr->tryReadPage(file1ptr, j, p) != PageStatus::HIT)
+				PRINT_ERROR("ERROR :: A scan through a ring should not evict other pages");
+			ringMgr->unPinPage(file1ptr, j, false);
+		}
+
+		ringMgr->flushFile(file1ptr);
+		delete ringMgr;
+	}
+
+	std::cout << "Test 13 passed" << "\n";
+}
+
+void test14()
+{
+	//Frames are aligned, and pages keep their records through deletes and copies
+	Page* p;
+	PageId pageNo;
+	bufMgr->allocPage(file5ptr, pageNo, p);
+	if (reinterpret_cast<std::uintptr_t>(p) % Page::ALIGNMENT != 0)
+		PRINT_ERROR("ERROR :: Frames of the buffer pool should be aligned");
+	RecordId first = p->insertRecord("first record");
+	RecordId second = p->insertRecord("second record");
+	RecordId third = p->insertRecord("third record");
+	p->deleteRecord(second);
+	Page copy = *p;
+	if (copy.getRecord(first) != "first record" || copy.getRecord(third) != "third record")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	bufMgr->unPinPage(file5ptr, pageNo, true);
+	bufMgr->flushFile(file5ptr);
+
+	Page fromDisk = file5ptr->readPage(pageNo);
+	if (fromDisk.getRecord(first) != "first record" || fromDisk.getRecord(third) != "third record")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+
+	std::cout << "Test 14 passed" << "\n";
+}
+
+void test15()
+{
+	//Page handles unpin their pages when they go out of scope, and carry the dirty flag
+	BufMgr* handleMgr = new BufMgr(3);
+	PageId pageNo;
+	RecordId rid;
+	{
+		PageHandle page = handleMgr->allocPage(file5ptr, pageNo);
+		rid = page->insertRecord("written through a handle");
+		page.markDirty();
+		if (page.pageNo() != pageNo)
+			PRINT_ERROR("ERROR :: Handle should hold the allocated page");
+	}
+
+	//A handle moved from holds no pin, so only one pin is given up
+	{
+		PageHandle first = handleMgr->readPage(file5ptr, pageNo);
+		PageHandle second = std::move(first);
+		if (first || !second)
+			PRINT_ERROR("ERROR :: Moving a handle should move its pin");
+		if (second->getRecord(rid) != "written through a handle")
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		second.release();
+		try
+		{
+			handleMgr->unPinPage(file5ptr, pageNo, false);
+			PRINT_ERROR("ERROR :: Page is not pinned, exception should have been thrown");
+		}
+		catch(PageNotPinnedException&)
+		{
+		}
+	}
+
+	//Every frame can be reused once the handles are gone, and the dirty page was written back
+	for (PageId j = 1; j <= 3; j++)
+	{
+		PageHandle page = handleMgr->readPage(file1ptr, j);
+	}
+	handleMgr->flushFile(file5ptr);
+	if (file5ptr->readPage(pageNo).getRecord(rid) != "written through a handle")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	handleMgr->flushFile(file1ptr);
+	delete handleMgr;
+
+	std::cout << "Test 15 passed" << "\n";
+}
+
+void test16()
+{
+	//Frame latches: shared holders coexist, and an exclusive holder fails overlapping optimistic reads
+	BufMgr* latchMgr = new BufMgr(8, 2);
+	PageId pageNo;
+	RecordId rid;
+	{
+		PageHandle page = latchMgr->allocPage(file5ptr, pageNo);
+		page.lockExclusive();
+		rid = page->insertRecord("read optimistically");
+		page.markDirty();
+	}
+	{
+		PageHandle reader = latchMgr->readPage(file5ptr, pageNo);
+		PageHandle other = latchMgr->readPage(file5ptr, pageNo);
+		reader.lockShared();
+		other.lockShared();
+		if (reader.latched() != LatchMode::SHARED || other.latched() != LatchMode::SHARED)
+			PRINT_ERROR("ERROR :: Both handles should hold the latch shared");
+		reader.unlock();
+		other.unlock();
+
+		const std::uint64_t version = reader.readVersion();
+		if (reader->getRecord(rid) != "read optimistically" || !reader.validate(version))
+			PRINT_ERROR("ERROR :: Optimistic read without writers should validate");
+		other.lockExclusive();
+		other.unlock();
+		if (reader.validate(version))
+			PRINT_ERROR("ERROR :: Optimistic read overlapping a writer should fail validation");
+	}
+
+	//Resident pages are read without a pin, others are pinned and read under the shared latch
+	std::string record;
+	if (!latchMgr->readOptimistic(file5ptr, pageNo, [&](const Page& page) { record = page.getRecord(rid); }))
+		PRINT_ERROR("ERROR :: Resident page should be read without a pin");
+	if (record != "read optimistically")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	latchMgr->flushFile(file5ptr);
+	record.clear();
+	if (latchMgr->readOptimistic(file5ptr, pageNo, [&](const Page& page) { record = page.getRecord(rid); }))
+		PRINT_ERROR("ERROR :: Page not in the pool should be pinned");
+	if (record != "read optimistically")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	latchMgr->flushFile(file5ptr);
+	delete latchMgr;
+
+	std::cout << "Test 16 passed" << "\n";
+}
+
+void test17()
+{
+	//With frame waiting on, a request finding every frame pinned gets the frame unpinned meanwhile
+	BufMgr* waitMgr = new BufMgr(2);
+	waitMgr->setFrameWait(std::chrono::seconds(5));
+	Page* page;
+	waitMgr->readPage(file1ptr, 1, page);
+	waitMgr->readPage(file1ptr, 2, page);
+	std::thread unpinner([waitMgr]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		waitMgr->unPinPage(file1ptr, 1, false);
+	});
+	waitMgr->readPage(file1ptr, 3, page);
+	unpinner.join();
+	if (waitMgr->getBufStats().framewaits != 1 || waitMgr->getBufStats().framewaitus < 10000
+			|| waitMgr->getBufStats().frametimeouts != 0)
+		PRINT_ERROR("ERROR :: One wait for a frame should have been counted");
+
+	//Nobody unpins: the request times out
+	waitMgr->setFrameWait(std::chrono::milliseconds(10));
+	try
+	{
+		waitMgr->readPage(file1ptr, 4, page);
+		PRINT_ERROR("ERROR :: No more space in buffer pool, exception should have been thrown");
+	}
+	catch(BufferExceededException&)
+	{
+	}
+	if (waitMgr->getBufStats().framewaits != 2 || waitMgr->getBufStats().frametimeouts != 1)
+		PRINT_ERROR("ERROR :: The timeout should have been counted");
+
+	waitMgr->unPinPage(file1ptr, 2, false);
+	waitMgr->unPinPage(file1ptr, 3, false);
+	waitMgr->flushFile(file1ptr);
+	delete waitMgr;
+
+	std::cout << "Test 17 passed" << "\n";
+}
+
+void test18()
+{
+	//Growing keeps the cached pages and adds frames for new ones
+	BufMgr* sizeMgr = new BufMgr(4, 1, PolicyKind::CLOCK, ArenaPages::TRANSPARENT_HUGE, false, 16);
+	Page* page;
+	for (PageId j = 1; j <= 4; j++)
+		sizeMgr->readPage(file1ptr, j, page);
+	if (sizeMgr->resize(8) != 8 || sizeMgr->getNumBufs() != 8)
+		PRINT_ERROR("ERROR :: Buffer pool should have grown to 8 frames");
+	for (PageId j = 1; j <= 8; j++)
+		sizeMgr->readPage(file1ptr, j, page);
+	if (sizeMgr->getBufStats().diskreads != 8)
+		PRINT_ERROR("ERROR :: Pages cached before growing should have stayed in the buffer pool");
+
+	//Shrinking waits for pages pinned in the frames taken away, and keeps the others
+	for (PageId j = 1; j <= 4; j++)
+	{
+		sizeMgr->unPinPage(file1ptr, j, false);
+		sizeMgr->unPinPage(file1ptr, j, false);
+	}
+	std::thread unpinner([sizeMgr]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		for (PageId j = 5; j <= 8; j++)
+			sizeMgr->unPinPage(file1ptr, j, false);
+	});
+	if (sizeMgr->resize(4) != 4 || sizeMgr->getNumBufs() != 4)
+		PRINT_ERROR("ERROR :: Buffer pool should have shrunk to 4 frames");
+	unpinner.join();
+	for (PageId j = 1; j <= 4; j++)
+		sizeMgr->readPage(file1ptr, j, page);
+	if (sizeMgr->getBufStats().diskreads != 8)
+		PRINT_ERROR("ERROR :: Pages in frames that stay should have stayed in the buffer pool");
+	try
+	{
+		sizeMgr->readPage(file1ptr, 5, page);
+		PRINT_ERROR("ERROR :: No more space in buffer pool, exception should have been thrown");
+	}
+	catch(BufferExceededException&)
+	{
+	}
+	for (PageId j = 1; j <= 4; j++)
+		sizeMgr->unPinPage(file1ptr, j, false);
+	sizeMgr->flushFile(file1ptr);
+	delete sizeMgr;
+
+	//Dirty pages of frames taken away are written back, and the frames can be taken again
+	BufMgr* shardedMgr = new BufMgr(8, 2, PolicyKind::CLOCK, ArenaPages::TRANSPARENT_HUGE, false, 8);
+	PageId pageNo;
+	RecordId rid;
+	{
+		PageHandle handle = shardedMgr->allocPage(file5ptr, pageNo);
+		rid = handle->insertRecord("survives shrinking");
+		handle.markDirty();
+	}
+	shardedMgr->resize(0);
+	if (shardedMgr->getNumBufs() != 2)
+		PRINT_ERROR("ERROR :: Every shard should keep one frame");
+	shardedMgr->resize(8);
+	for (PageId j = 1; j <= 3; j++)
+		shardedMgr->readPage(file1ptr, j, page);
+	if (shardedMgr->readPage(file5ptr, pageNo)->getRecord(rid) != "survives shrinking")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	shardedMgr->flushFile(file5ptr);
+	for (PageId j = 1; j <= 3; j++)
+		shardedMgr->unPinPage(file1ptr, j, false);
+	shardedMgr->flushFile(file1ptr);
+	if (file5ptr->readPage(pageNo).getRecord(rid) != "survives shrinking")
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	delete shardedMgr;
+
+	std::cout << "Test 18 passed" << "\n";
+}
+
+void test19()
+{
+	//Pages of each file are counted from the frames holding them, the last frame of the pool included
+	BufMgr* fileMgr = new BufMgr(4);
+	Page* page;
+	for (PageId j = 1; j <= 2; j++)
+	{
+		fileMgr->readPage(file1ptr, j, page);
+		fileMgr->unPinPage(file1ptr, j, false);
+		fileMgr->readPage(file2ptr, j, page);
+		fileMgr->unPinPage(file2ptr, j, true);
+	}
+	std::uint32_t dirty;
+	if (fileMgr->getFilePages(file1ptr, dirty) != 2 || dirty != 0)
+		PRINT_ERROR("ERROR :: Two clean pages of the file should be in the buffer pool");
+	if (fileMgr->getFilePages(file2ptr, dirty) != 2 || dirty != 2)
+		PRINT_ERROR("ERROR :: Two dirty pages of the file should be in the buffer pool");
+
+	//A pinned page keeps every page of its file in the buffer pool
+	fileMgr->readPage(file1ptr, 2, page);
+	try
+	{
+		fileMgr->flushFile(file1ptr);
+		PRINT_ERROR("ERROR :: Page is pinned, exception should have been thrown");
+	}
+	catch(PagePinnedException&)
+	{
+	}
+	if (fileMgr->getFilePages(file1ptr, dirty) != 2)
+		PRINT_ERROR("ERROR :: No page should have been removed while one is pinned");
+	fileMgr->unPinPage(file1ptr, 2, false);
+
+	//Flushing a file leaves the pages of other files alone
+	fileMgr->flushFile(file1ptr);
+	if (fileMgr->getFilePages(file1ptr, dirty) != 0 || fileMgr->getFilePages(file2ptr, dirty) != 2)
+		PRINT_ERROR("ERROR :: Only the pages of the flushed file should have been removed");
+	fileMgr->flushFile(file2ptr);
+	if (fileMgr->getFilePages(file2ptr, dirty) != 0 || fileMgr->getBufStats().diskwrites != 2)
+		PRINT_ERROR("ERROR :: Both dirty pages should have been written and removed");
+
+	//Every frame can be taken again
+	for (PageId j = 1; j <= 4; j++)
+		fileMgr->readPage(file1ptr, j, page);
+	for (PageId j = 1; j <= 4; j++)
+		fileMgr->unPinPage(file1ptr, j, false);
+	fileMgr->flushFile(file1ptr);
+	delete fileMgr;
+
+	std::cout << "Test 19 passed" << "\n";
+}
+
+void test20()
+{
+	//Evicting a dirty page writes its dirty neighbours in the file along with it
+	BufMgr* writeMgr = new BufMgr(4);
+	Page* page;
+	for (PageId j = 1; j <= 4; j++)
+	{
+		writeMgr->readPage(file1ptr, j, page);
+		writeMgr->unPinPage(file1ptr, j, true);
+	}
+	writeMgr->readPage(file1ptr, 5, page);
+	writeMgr->unPinPage(file1ptr, 5, false);
+	std::uint32_t dirty;
+	if (writeMgr->getBufStats().diskwrites != 4 || writeMgr->getBufStats().evictwrites != 4
+			|| writeMgr->getFilePages(file1ptr, dirty) != 4 || dirty != 0)
+		PRINT_ERROR("ERROR :: All four dirty pages should have been written by one eviction");
+
+	//Pages written together keep the list of used pages in the file intact
+	PageId used = 0;
+	for (FileIterator iter = file1ptr->begin(); iter != file1ptr->end(); ++iter)
+		used++;
+	for (PageId j = 1; j <= 4; j++)
+	{
+		writeMgr->readPage(file1ptr, j, page);
+		writeMgr->unPinPage(file1ptr, j, true);
+	}
+	writeMgr->flushFile(file1ptr);
+	if (writeMgr->getBufStats().diskwrites != 8)
+		PRINT_ERROR("ERROR :: Flushing should have written the four dirty pages");
+	PageId usedAfter = 0;
+	for (FileIterator iter = file1ptr->begin(); iter != file1ptr->end(); ++iter)
+		usedAfter++;
+	if (usedAfter != used)
+		PRINT_ERROR("ERROR :: The used pages of the file should not have changed");
+	delete writeMgr;
+
+	std::cout << "Test 20 passed" << "\n";
+}
+
+void test21()
+{
+	//Several threads read the same file at once, while another one writes to it
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.push_back(std::thread([t, &mismatches]()
+		{
+			for (PageId k = 0; k < 4 * num; k++)
+			{
+				PageId pageNo = pid[(k * 7 + t) % num];
+				if (file1ptr->readPage(pageNo).page_number() != pageNo)
+					mismatches++;
+			}
+		}));
+	}
+	for (PageId k = 0; k < num; k++)
+		file1ptr->writePage(file1ptr->readPage(pid[k]));
+	for (std::size_t t = 0; t < readers.size(); t++)
+		readers[t].join();
+	if (mismatches != 0)
+		PRINT_ERROR("ERROR :: Every page read concurrently should have been the page asked for");
+
+	std::cout << "Test 21 passed" << "\n";
+}
+
+void test22()
+{
+	//Both engines carry out batches larger than their depth, and report short reads at the end of the file
+	const IoEngineKind kinds[] = {IoEngineKind::URING, IoEngineKind::THREAD_POOL};
+	for (int k = 0; k < 2; k++)
+	{
+		std::unique_ptr<IoEngine> engine(IoEngine::create(kinds[k], 4));
+		int fd = ::open("test.io", O_RDWR | O_CREAT | O_TRUNC, 0666);
+		if (fd < 0)
+			PRINT_ERROR("ERROR :: Could not create test.io");
+		const int blocks = 16;
+		char out[blocks][512], in[blocks + 1][512];
+		struct iovec iov[blocks + 1];
+		IoRequest requests[blocks + 1];
+		for (int b = 0; b < blocks; b++)
+		{
+			memset(out[b], 'a' + b, sizeof(out[b]));
+			iov[b].iov_base = out[b];
+			iov[b].iov_len = sizeof(out[b]);
+			IoRequest request = {true, fd, &iov[b], 1, (off_t)(b * sizeof(out[b])), 0};
+			requests[b] = request;
+		}
+		engine->run(requests, blocks);
+		for (int b = 0; b < blocks; b++)
+			if (requests[b].result != (ssize_t)sizeof(out[b]))
+				PRINT_ERROR("ERROR :: Every write should have been carried out in full");
+
+		for (int b = 0; b <= blocks; b++)
+		{
+			iov[b].iov_base = in[b];
+			iov[b].iov_len = sizeof(in[b]);
+			IoRequest request = {false, fd, &iov[b], 1, (off_t)(b * sizeof(in[b])), -1};
+			requests[b] = request;
+		}
+		engine->run(requests, blocks + 1);
+		for (int b = 0; b < blocks; b++)
+			if (requests[b].result != (ssize_t)sizeof(in[b]) || memcmp(in[b], out[b], sizeof(in[b])) != 0)
+				PRINT_ERROR("ERROR :: Every read should have returned the block written");
+		if (requests[blocks].result != 0)
+			PRINT_ERROR("ERROR :: A read past the end of the file should have returned nothing");
+		::close(fd);
+		::unlink("test.io");
+	}
+
+	//Pages read as one batch are the pages asked for; a page past the end of the file is not found
+	PageId pageNos[5];
+	std::unique_ptr<Page[]> pages(new Page[5]);
+	Page* targets[5];
+	bool found[5];
+	for (int j = 0; j < 4; j++)
+		pageNos[j] = pid[j];
+	std::sort(pageNos, pageNos + 4);
+	pageNos[4] = pageNos[3] + 100000;
+	for (int j = 0; j < 5; j++)
+		targets[j] = &pages[j];
+	file1ptr->tryReadPages(pageNos, 5, targets, found);
+	for (int j = 0; j < 4; j++)
+		if (!found[j] || pages[j].page_number() != pageNos[j])
+			PRINT_ERROR("ERROR :: Every page of the batch should have been read");
+	if (found[4])
+		PRINT_ERROR("ERROR :: A page past the end of the file should not have been found");
+
+	std::cout << "Test 22 passed" << "\n";
+}
+
+void writeOriginalLayout(const std::string& filename, const PageId numPages, const PageId* listed, const int count,
+                         RecordId* rids)
+{
+	//Lays the file out as File did before the format version: a 16-byte header, then page n at 16 + (n - 1) *
+	//Page::SIZE.  The listed pages are used and linked in the given order, and hold a record each
+	const int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	const PageId header[4] = {numPages, count > 0 ? listed[0] : Page::INVALID_NUMBER, 0, 0};
+	if (::pwrite(fd, header, sizeof(header), 0) != sizeof(header))
+		PRINT_ERROR("ERROR :: Could not write the header of the file");
+	for (int j = 0; j < count; j++)
+	{
+		Page original;
+		sprintf(tmpbuf, "original Page %d", listed[j]);
+		rids[j] = original.insertRecord(tmpbuf);
+		rids[j].page_number = listed[j];
+		std::vector<char> bytes(Page::SIZE);
+		memcpy(&bytes[0], &original, Page::SIZE);
+		PageHeader pageHeader;
+		memcpy(&pageHeader, &bytes[0], sizeof(pageHeader));
+		pageHeader.current_page_number = listed[j];
+		pageHeader.next_page_number = j + 1 < count ? listed[j + 1] : Page::INVALID_NUMBER;
+		memcpy(&bytes[0], &pageHeader, sizeof(pageHeader));
+		if (::pwrite(fd, &bytes[0], Page::SIZE, sizeof(header) + (off_t)(listed[j] - 1) * Page::SIZE)
+				!= (ssize_t)Page::SIZE)
+			PRINT_ERROR("ERROR :: Could not write a page of the file");
+	}
+	if (::ftruncate(fd, sizeof(header) + (off_t)(numPages - 1) * Page::SIZE) != 0)
+		PRINT_ERROR("ERROR :: Could not extend the file to its last page");
+	::close(fd);
+}
+
+void test23()
+{
+	//Pages written through a file opened for direct I/O read back the same through the page cache, and back again
+	const std::string filename = "test.6";
+	const PageId pages = 8;
+	PageId pageNos[pages];
+	RecordId rids[pages];
+	if (File::exists(filename))
+		File::remove(filename);
+	{
+		File direct = File::create(filename, FileMode::DIRECT);
+		BufMgr* directMgr = new BufMgr(num);
+		for (PageId j = 0; j < pages; j++)
+		{
+			directMgr->allocPage(&direct, pageNos[j], page);
+			sprintf(tmpbuf, "direct.%d Page %d %7.1f", j, pageNos[j], (float)pageNos[j]);
+			rids[j] = page->insertRecord(tmpbuf);
+			directMgr->unPinPage(&direct, pageNos[j], true);
+		}
+		directMgr->flushFile(&direct);
+		delete directMgr;
+		direct.deletePage(pageNos[pages - 1]);
+	}
+	{
+		File buffered = File::open(filename);
+		if (buffered.direct())
+			PRINT_ERROR("ERROR :: A file opened buffered should not use direct I/O");
+		PageId used = 0;
+		for (FileIterator iter = buffered.begin(); iter != buffered.end(); ++iter)
+			used++;
+		if (used != pages - 1)
+			PRINT_ERROR("ERROR :: The page disposed of through direct I/O should not be used anymore");
+		for (PageId j = 0; j < pages - 1; j++)
+		{
+			sprintf(tmpbuf, "direct.%d Page %d %7.1f", j, pageNos[j], (float)pageNos[j]);
+			if (strncmp(buffered.readPage(pageNos[j]).getRecord(rids[j]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				PRINT_ERROR("ERROR :: Contents of a page written with direct I/O should be on disk");
+		}
+	}
+	{
+		File direct = File::open(filename, FileMode::DIRECT);
+		BufMgr* directMgr = new BufMgr(num);
+		Page* read[pages - 1];
+		directMgr->readPages(&direct, pageNos, pages - 1, read);
+		for (PageId j = 0; j < pages - 1; j++)
+		{
+			sprintf(tmpbuf, "direct.%d Page %d %7.1f", j, pageNos[j], (float)pageNos[j]);
+			if (strncmp(read[j]->getRecord(rids[j]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				PRINT_ERROR("ERROR :: Pages read with direct I/O should be the pages written");
+			directMgr->unPinPage(&direct, pageNos[j], false);
+		}
+		delete directMgr;
+	}
+	File::remove(filename);
+
+	//Files in the original layout are migrated on open, files in no known layout are rejected untouched
+	const PageId listed[] = {1, 3, 2};
+	writeOriginalLayout(filename, 4, listed, 3, rids);
+	try
+	{
+		File::open(filename, FileMode::MAPPED);
+		PRINT_ERROR("ERROR :: A file opened read-only should not be migrated. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const FileReadOnlyException&)
+	{
+	}
+	{
+		File migrated = File::open(filename, FileMode::DIRECT);
+		PageId used = 0;
+		for (FileIterator iter = migrated.begin(); iter != migrated.end(); ++iter)
+			used++;
+		if (used != 3)
+			PRINT_ERROR("ERROR :: The used pages of a migrated file should be kept");
+		for (int j = 0; j < 3; j++)
+		{
+			sprintf(tmpbuf, "original Page %d", listed[j]);
+			if (migrated.readPage(listed[j]).getRecord(rids[j]) != tmpbuf)
+				PRINT_ERROR("ERROR :: The pages of a migrated file should be at their new offsets");
+		}
+		if (migrated.allocatePage().page_number() != 4)
+			PRINT_ERROR("ERROR :: Pages allocated in a migrated file should follow its last page");
+	}
+	if (File::exists(filename + ".migrating"))
+		PRINT_ERROR("ERROR :: The new file should have replaced the original one");
+	File::remove(filename);
+
+	std::vector<char> unknown(3 * Page::SIZE / 2, 'x');
+	int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (::pwrite(fd, &unknown[0], unknown.size(), 0) != (ssize_t)unknown.size())
+		PRINT_ERROR("ERROR :: Could not write the file");
+	::close(fd);
+	try
+	{
+		File::open(filename);
+		PRINT_ERROR("ERROR :: A file in no known layout should not be opened. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const FileFormatException&)
+	{
+	}
+	std::vector<char> after(unknown.size() + 1);
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (::pread(fd, &after[0], after.size(), 0) != (ssize_t)unknown.size()
+			|| !std::equal(unknown.begin(), unknown.end(), after.begin()))
+		PRINT_ERROR("ERROR :: A file in no known layout should be left as it was");
+	::close(fd);
+	File::remove(filename);
+
+	std::cout << "Test 23 passed" << "\n";
+}
+
+void test24()
+{
+	//A mapped file hands out its pages in place and refuses changes
+	const std::string filename = "test.7";
+	const PageId pages = 8;
+	PageId pageNos[pages];
+	RecordId rids[pages];
+	if (File::exists(filename))
+		File::remove(filename);
+	{
+		File written = File::create(filename);
+		for (PageId j = 0; j < pages; j++)
+		{
+			Page newPage = written.allocatePage();
+			pageNos[j] = newPage.page_number();
+			sprintf(tmpbuf, "mapped.%d Page %d %7.1f", j, pageNos[j], (float)pageNos[j]);
+			rids[j] = newPage.insertRecord(tmpbuf);
+			written.writePage(newPage);
+		}
+	}
+	{
+		File mapped = File::open(filename, FileMode::MAPPED);
+		if (!mapped.mapped())
+			PRINT_ERROR("ERROR :: A file opened with FileMode::MAPPED should be mapped");
+		PageId j = 0;
+		for (FileIterator iter = mapped.begin(); iter != mapped.end(); ++iter, j++)
+		{
+			sprintf(tmpbuf, "mapped.%d Page %d %7.1f", j, pageNos[j], (float)pageNos[j]);
+			if (strncmp(iter.view().getRecord(rids[j]).c_str(), tmpbuf, strlen(tmpbuf)) != 0
+					|| strncmp((*iter).getRecord(rids[j]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				PRINT_ERROR("ERROR :: Pages of a mapped file should be the pages written");
+			if (&iter.view() != &mapped.viewPage(pageNos[j]))
+				PRINT_ERROR("ERROR :: Views of a page should point to the same place in the mapping");
+		}
+		if (j != pages)
+			PRINT_ERROR("ERROR :: A scan of a mapped file should visit every used page");
+
+		try
+		{
+			mapped.viewPage(pageNos[pages - 1] + 1);
+			PRINT_ERROR("ERROR :: Page past the end of the file should not be viewed. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageException&)
+		{
+		}
+		try
+		{
+			mapped.allocatePage();
+			PRINT_ERROR("ERROR :: A mapped file should not be changed. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const FileReadOnlyException&)
+		{
+		}
+		try
+		{
+			mapped.deletePage(pageNos[0]);
+			PRINT_ERROR("ERROR :: A mapped file should not be changed. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const FileReadOnlyException&)
+		{
+		}
+
+		//The buffer manager reads a mapped file like any other
+		BufMgr* mappedMgr = new BufMgr(num);
+		mappedMgr->readPage(&mapped, pageNos[1], page);
+		sprintf(tmpbuf, "mapped.%d Page %d %7.1f", 1, pageNos[1], (float)pageNos[1]);
+		if (strncmp(page->getRecord(rids[1]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			PRINT_ERROR("ERROR :: Page read from a mapped file should be the page written");
+		mappedMgr->unPinPage(&mapped, pageNos[1], false);
+		delete mappedMgr;
+	}
+	File::remove(filename);
+
+	std::cout << "Test 24 passed" << "\n";
+}
+
+void test25()
+{
+	//The file header is written back on sync, after the write interval and on close
+	const std::string filename = "test.8";
+	if (File::exists(filename))
+		File::remove(filename);
+	FileHeader onDisk;
+	int fd;
+	{
+		File cached = File::create(filename);
+		fd = ::open(filename.c_str(), O_RDONLY);
+		for (int j = 0; j < 3; j++)
+			cached.allocatePage();
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.num_pages != 1)
+			PRINT_ERROR("ERROR :: The header should not have been written before a sync");
+		if (cached.readPage(3).page_number() != 3)
+			PRINT_ERROR("ERROR :: Pages should be read within the bounds of the header in memory");
+		cached.sync();
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.num_pages != 4)
+			PRINT_ERROR("ERROR :: The header should have been written by the sync");
+
+		cached.setHeaderWriteInterval(2);
+		cached.allocatePage();
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.num_pages != 4)
+			PRINT_ERROR("ERROR :: The header should not have been written before the write interval");
+		cached.allocatePage();
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.num_pages != 6)
+			PRINT_ERROR("ERROR :: The header should have been written after the write interval");
+		cached.deletePage(2);
+	}
+	if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.num_free_pages != 1
+			|| onDisk.first_free_page != 2)
+		PRINT_ERROR("ERROR :: The header should have been written when the file was closed");
+	::close(fd);
+	File::remove(filename);
+
+	std::cout << "Test 25 passed" << "\n";
+}
+
+void test26()
+{
+	//Files which link their used pages in a list are converted to a page directory on open
+	const std::string filename = "test.9";
+	if (File::exists(filename))
+		File::remove(filename);
+	//The list is 35000 -> 5 -> 12, all other pages of the file are free
+	const PageId listed[] = {35000, 5, 12};
+	RecordId listedRids[3];
+	writeOriginalLayout(filename, 40000, listed, 3, listedRids);
+	{
+		File converted = File::open(filename);
+		std::vector<PageId> visited;
+		for (FileIterator iter = converted.begin(); iter != converted.end(); ++iter)
+			visited.push_back((*iter).page_number());
+		if (visited.size() != 3 || visited[0] != 5 || visited[1] != 12 || visited[2] != 35000)
+			PRINT_ERROR("ERROR :: Used pages should be visited in page-number order after conversion");
+		for (int j = 0; j < 3; j++)
+		{
+			sprintf(tmpbuf, "original Page %d", listed[j]);
+			if (converted.readPage(listed[j]).getRecord(listedRids[j]) != tmpbuf)
+				PRINT_ERROR("ERROR :: The records of the listed pages should be kept by the conversion");
+		}
+		FileHeader onDisk;
+		const int fd = ::open(filename.c_str(), O_RDONLY);
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk) || onDisk.directory_version != 1
+				|| onDisk.num_directory_pages != 1 || onDisk.num_pages != 40001
+				|| onDisk.num_free_pages != 40000 - 4)
+			PRINT_ERROR("ERROR :: The directory page should have been added after the last page");
+		::close(fd);
+		if (converted.allocatePage().page_number() != 1)
+			PRINT_ERROR("ERROR :: A free page should have been reused");
+		converted.deletePage(12);
+		if (converted.allocatePage().page_number() != 12)
+			PRINT_ERROR("ERROR :: The page deleted last should be reused first");
+		converted.deletePage(5);
+		try
+		{
+			converted.deletePage(5);
+			PRINT_ERROR("ERROR :: Deleting a free page should throw InvalidPageException");
+		}
+		catch(const InvalidPageException&)
+		{
+		}
+	}
+	{
+		File reopened = File::open(filename);
+		std::vector<PageId> visited;
+		for (FileIterator iter = reopened.begin(); iter != reopened.end(); ++iter)
+			visited.push_back((*iter).page_number());
+		if (visited.size() != 3 || visited[0] != 1 || visited[1] != 12 || visited[2] != 35000)
+			PRINT_ERROR("ERROR :: The page directory should have been read back on reopen");
+		if (reopened.allocatePage().page_number() != 2)
+			PRINT_ERROR("ERROR :: The free pages should have been found in the page directory");
+	}
+	{
+		//A directory of an unknown version is neither read nor converted, and the file is left as it was
+		FileHeader onDisk;
+		int fd = ::open(filename.c_str(), O_RDWR);
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk))
+			PRINT_ERROR("ERROR :: Could not read the header of the file");
+		onDisk.directory_version = 2;
+		if (::pwrite(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk))
+			PRINT_ERROR("ERROR :: Could not write the header of the file");
+		::close(fd);
+		try
+		{
+			File::open(filename);
+			PRINT_ERROR("ERROR :: A directory of an unknown version should not be read. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const FileFormatException&)
+		{
+		}
+		FileHeader after;
+		fd = ::open(filename.c_str(), O_RDONLY);
+		if (::pread(fd, &after, sizeof(after), 0) != sizeof(after) || !(after == onDisk))
+			PRINT_ERROR("ERROR :: A file with a directory of an unknown version should be left as it was");
+		::close(fd);
+	}
+	File::remove(filename);
+	{
+		//Once page 0 holds the numbers of as many directory pages as fit, the file cannot grow any more.  The file
+		//is sparse: page 0 has room for 1008 directory numbers, which with its own bits cover 32768 + 1008 * 65536
+		//pages, all of them used
+		const PageId directoryPages = 1008;
+		const PageId covered = 32768 + directoryPages * 65536;
+		{
+			File full = File::create(filename);
+		}
+		FileHeader onDisk;
+		int fd = ::open(filename.c_str(), O_RDWR);
+		if (::pread(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk))
+			PRINT_ERROR("ERROR :: Could not read the header of the file");
+		onDisk.num_pages = covered;
+		onDisk.num_directory_pages = directoryPages;
+		std::vector<PageId> directory(directoryPages);
+		for (PageId j = 0; j < directoryPages; j++)
+			directory[j] = j + 1;
+		std::vector<char> bits(Page::SIZE, (char)0xff);
+		if (::pwrite(fd, &onDisk, sizeof(onDisk), 0) != sizeof(onDisk)
+				|| ::pwrite(fd, &directory[0], directoryPages * sizeof(PageId), 64) != (ssize_t)(directoryPages * sizeof(PageId))
+				|| ::pwrite(fd, &bits[0], Page::SIZE / 2, Page::SIZE / 2) != (ssize_t)(Page::SIZE / 2))
+			PRINT_ERROR("ERROR :: Could not write the header of the file");
+		for (PageId j = 0; j < directoryPages; j++)
+			if (::pwrite(fd, &bits[0], Page::SIZE, (off_t)directory[j] * Page::SIZE) != (ssize_t)Page::SIZE)
+				PRINT_ERROR("ERROR :: Could not write a directory page of the file");
+		if (::ftruncate(fd, (off_t)covered * Page::SIZE) != 0)
+			PRINT_ERROR("ERROR :: Could not extend the file to its last page");
+		::close(fd);
+		{
+			File full = File::open(filename);
+			try
+			{
+				full.allocatePage();
+				PRINT_ERROR("ERROR :: A file whose directory is full should not grow. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const FileFullException&)
+			{
+			}
+		}
+		FileHeader after;
+		fd = ::open(filename.c_str(), O_RDONLY);
+		if (::pread(fd, &after, sizeof(after), 0) != sizeof(after) || !(after == onDisk))
+			PRINT_ERROR("ERROR :: A failed allocation should leave the header as it was");
+		::close(fd);
+	}
+	File::remove(filename);
+
+	std::cout << "Test 26 passed" << "\n";
+}
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include "types.h"
 
@@ -53,7 +54,8 @@ struct PageHeader {
   PageId current_page_number;
 
   /**
-   * Number of the next used page in the file.
+   * Number of the next used page in the file, in files written before the
+   * page directory; File no longer maintains it.
    */
   PageId next_page_number;
 
@@ -102,9 +104,14 @@ class PageIterator;
  * slots and identified by a RecordId.  Although a record's actual contents may
  * be moved on the page, accessing a record by its slot is consistent.
  *
+ * A page is a single block of SIZE bytes, header first, aligned to ALIGNMENT
+ * bytes.  It holds no pointers, so it is copied like plain memory and is
+ * read from and written to disk as it is.  Arrays allocated with new Page[]
+ * are contiguous and aligned as well.
+ *
  * @warning This class is not threadsafe.
  */
-class Page {
+class alignas(4096) Page {
  public:
   /**
    * Page size in bytes.  If this is changed, database files created with a
@@ -117,6 +124,12 @@ class Page {
    */
   static const std::size_t DATA_SIZE = SIZE - sizeof(PageHeader);
 
+  /**
+   * Alignment of pages in memory in bytes, a multiple of the sector size of
+   * common disks.
+   */
+  static const std::size_t ALIGNMENT = 4096;
+
   /**
    * Number of page indicating that it's invalid.
    */
@@ -132,6 +145,26 @@ class Page {
    */
   Page();
 
+  /**
+   * Allocates memory for a page aligned to ALIGNMENT bytes.
+   */
+  static void* operator new(std::size_t size);
+
+  /**
+   * Allocates memory for an array of pages aligned to ALIGNMENT bytes.
+   */
+  static void* operator new[](std::size_t size);
+
+  /**
+   * Frees memory allocated by operator new.
+   */
+  static void operator delete(void* ptr);
+
+  /**
+   * Frees memory allocated by operator new[].
+   */
+  static void operator delete[](void* ptr);
+
   /**
    * Inserts a new record into the page.
    *
@@ -193,7 +226,8 @@ class Page {
   PageId page_number() const { return header_.current_page_number; }
 
   /**
-   * Returns the number of the next used page this page in its file.
+   * Returns the number of the next used page this page in its file, in files
+   * written before the page directory.
    *
    * @return  Page number of next used page in file.
    */
@@ -329,8 +363,7 @@ class Page {
    * Data stored on the page.  Includes bookkeeping information about slots as
    * well as actual content.
    */
-
-  std::string data_;
+  char data_[DATA_SIZE];
 
   friend class File;
   friend class PageIterator;
@@ -342,5 +375,11 @@ static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0,
               "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE,
+              "Page must consist of exactly its header and data.");
+static_assert(alignof(Page) == Page::ALIGNMENT,
+              "Page must be aligned as declared.");
+static_assert(std::is_trivially_copyable<Page>::value,
+              "Page must be copyable as plain memory.");
 
 }
@@ -0,0 +1,102 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <new>
+
+namespace badgerdb {
+
+const std::size_t PageArena::HUGE_PAGE_SIZE;
+
+namespace {
+
+std::size_t roundUp(const std::size_t size, const std::size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+}
+
+PageArena::PageArena(const std::size_t size, const ArenaPages pages,
+                     const bool prefault)
+    : data_(MAP_FAILED),
+      size_(size),
+      mapping_size_(0),
+      pages_(pages) {
+  const std::size_t rounded = roundUp(size > 0 ? size : 1, HUGE_PAGE_SIZE);
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+  if (pages_ == ArenaPages::HUGE) {
+    data_ = mmap(NULL, rounded, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB,
+                 -1, 0);
+    mapping_size_ = rounded;
+  }
+#endif
+  if (data_ == MAP_FAILED) {
+    if (pages_ == ArenaPages::HUGE) {
+      pages_ = ArenaPages::TRANSPARENT_HUGE;
+    }
+    // Map one huge page more than needed, so that the arena can start at a
+    // huge page boundary, and give back what is left over on either side.
+    mapping_size_ = rounded + HUGE_PAGE_SIZE;
+    void* mapping = mmap(NULL, mapping_size_, PROT_READ | PROT_WRITE, flags,
+                         -1, 0);
+    if (mapping == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapping);
+    const std::uintptr_t aligned = roundUp(start, HUGE_PAGE_SIZE);
+    if (aligned > start) {
+      munmap(mapping, aligned - start);
+    }
+    if (aligned + rounded < start + mapping_size_) {
+      munmap(reinterpret_cast<void*>(aligned + rounded),
+             start + mapping_size_ - (aligned + rounded));
+    }
+    data_ = reinterpret_cast<void*>(aligned);
+    mapping_size_ = rounded;
+#ifdef MADV_HUGEPAGE
+    if (pages_ == ArenaPages::TRANSPARENT_HUGE &&
+        madvise(data_, mapping_size_, MADV_HUGEPAGE) != 0) {
+      pages_ = ArenaPages::SMALL;
+    }
+#else
+    pages_ = ArenaPages::SMALL;
+#endif
+  }
+
+  if (prefault) {
+    // Writing a byte per base page faults in every page.  Reading would only
+    // map the shared zero page.
+    const std::size_t step = sysconf(_SC_PAGESIZE);
+    volatile char* bytes = static_cast<volatile char*>(data_);
+    for (std::size_t offset = 0; offset < mapping_size_; offset += step) {
+      bytes[offset] = 0;
+    }
+  }
+}
+
+PageArena::~PageArena() {
+  munmap(data_, mapping_size_);
+}
+
+void PageArena::discard(const std::size_t offset, const std::size_t length) {
+  const std::size_t unit = pages_ == ArenaPages::HUGE
+                               ? HUGE_PAGE_SIZE
+                               : static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t begin = roundUp(offset, unit);
+  const std::size_t end = (offset + length) / unit * unit;
+  if (begin < end) {
+    madvise(static_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+}
@@ -0,0 +1,125 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * @brief Kinds of virtual memory pages a PageArena can be mapped with.
+ */
+enum class ArenaPages {
+  /**
+   * Base pages of the system (4 KB on x86-64).
+   */
+  SMALL,
+
+  /**
+   * Base pages which the kernel may merge into transparent huge pages
+   * (madvise(MADV_HUGEPAGE)).
+   */
+  TRANSPARENT_HUGE,
+
+  /**
+   * Huge pages reserved by the administrator (MAP_HUGETLB).
+   */
+  HUGE
+};
+
+/**
+ * @brief One contiguous, zero-filled region of anonymous memory for a buffer
+ *        pool.
+ *
+ * The arena is mapped with mmap() rather than taken from the heap, so that it
+ * can be backed by huge pages, which cut the TLB misses of random accesses to
+ * a large pool.  The kinds of pages are tried from the requested one down:
+ * HUGE falls back to TRANSPARENT_HUGE if no huge pages are reserved, and
+ * TRANSPARENT_HUGE leaves the kernel free to use SMALL pages.  The arena
+ * starts at a huge page boundary in any case.
+ *
+ * Memory is normally faulted in when it is first touched.  A prefaulted arena
+ * touches all of its memory when it is constructed, so that later accesses do
+ * not pay for page faults.
+ */
+class PageArena {
+ public:
+  /**
+   * Size of the huge pages the arena is aligned to, in bytes.
+   */
+  static const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * Maps an arena.
+   *
+   * @param size      Size of the arena in bytes.
+   * @param pages     Kind of pages to try first.
+   * @param prefault  Whether to touch all memory of the arena right away.
+   * @throws  std::bad_alloc  If no memory could be mapped.
+   */
+  PageArena(const std::size_t size, const ArenaPages pages,
+            const bool prefault);
+
+  /**
+   * Unmaps the arena.
+   */
+  ~PageArena();
+
+  /**
+   * Returns the start of the arena.
+   */
+  void* data() const { return data_; }
+
+  /**
+   * Returns the size of the arena in bytes, as requested.
+   */
+  std::size_t size() const { return size_; }
+
+  /**
+   * Returns the kind of pages the arena was mapped with.
+   */
+  ArenaPages pages() const { return pages_; }
+
+  /**
+   * Gives the memory of a part of the arena back to the system.  The part
+   * stays mapped and reads as zeros afterwards; it is faulted in again when it
+   * is touched.  Only whole pages of the kind the arena was mapped with are
+   * given back.
+   *
+   * @param offset  Start of the part, in bytes from the start of the arena.
+   * @param length  Length of the part in bytes.
+   */
+  void discard(const std::size_t offset, const std::size_t length);
+
+ private:
+  PageArena(const PageArena&);
+  PageArena& operator=(const PageArena&);
+
+  /**
+   * Start of the arena, and of the mapping holding it.
+   */
+  void* data_;
+
+  /**
+   * Size of the arena in bytes, as requested.
+   */
+  std::size_t size_;
+
+  /**
+   * Size of the mapping holding the arena in bytes, a multiple of the huge
+   * page size.
+   */
+  std::size_t mapping_size_;
+
+  /**
+   * Kind of pages the arena was mapped with.
+   */
+  ArenaPages pages_;
+};
+
+}
@@ -0,0 +1,216 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_table.h"
+
+#include <thread>
+
+#include "epoch_manager.h"
+#include "exceptions/hash_already_present_exception.h"
+#include "exceptions/hash_not_found_exception.h"
+
+namespace badgerdb {
+
+PageTable::Table::Table(const std::uint64_t num_slots)
+    : mask(num_slots - 1),
+      used(0),
+      slots(new Slot[num_slots]) {
+  for (std::uint64_t i = 0; i < num_slots; ++i) {
+    slots[i].key.store(EMPTY_KEY, std::memory_order_relaxed);
+    slots[i].frame.store(0, std::memory_order_relaxed);
+  }
+}
+
+PageTable::Table::~Table() {
+  delete[] slots;
+}
+
+PageTable::PageTable(const std::uint32_t capacity)
+    : size_(0),
+      writers_(0),
+      rebuilding_(false) {
+  // Keep the table at most a quarter full so that probe sequences stay short
+  // and rebuilds to purge removed keys are rare.
+  std::uint64_t num_slots = 16;
+  while (num_slots < static_cast<std::uint64_t>(capacity) * 4) {
+    num_slots <<= 1;
+  }
+  table_.store(new Table(num_slots));
+}
+
+PageTable::~PageTable() {
+  delete table_.load();
+}
+
+std::uint64_t PageTable::hash(const std::uint64_t key) {
+  // Finalizer of splitmix64: every bit of the file id and page number affects
+  // the low bits used to pick the home slot.
+  std::uint64_t h = key;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  return h ^ (h >> 31);
+}
+
+bool PageTable::lookup(const File* file, const PageId pageNo,
+                       FrameId& frameNo) const {
+  const std::uint64_t key = makeKey(file, pageNo);
+  EpochGuard guard;
+  const Table* table = table_.load();
+  std::uint64_t index = hash(key) & table->mask;
+  for (std::uint64_t probes = 0; probes <= table->mask; ++probes) {
+    const Slot& slot = table->slots[index];
+    const std::uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+    if (slot_key == key) {
+      frameNo = slot.frame.load(std::memory_order_acquire);
+      return true;
+    }
+    if (slot_key == EMPTY_KEY || (slot_key & ~(DELETED_BIT | BUSY_BIT)) == key) {
+      // A key has at most one slot; if it is removed or still being inserted
+      // the page is not in the table.
+      return false;
+    }
+    index = (index + 1) & table->mask;
+  }
+  return false;
+}
+
+void PageTable::insert(const File* file, const PageId pageNo,
+                       const FrameId frameNo) {
+  const std::uint64_t key = makeKey(file, pageNo);
+  for (;;) {
+    beginWrite();
+    Table* table = table_.load();
+    std::uint64_t index = hash(key) & table->mask;
+    std::uint64_t probes = 0;
+    while (probes <= table->mask) {
+      Slot& slot = table->slots[index];
+      std::uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+      if (slot_key == key || slot_key == (key | BUSY_BIT)) {
+        const FrameId frame = slot.frame.load(std::memory_order_acquire);
+        endWrite();
+        throw HashAlreadyPresentException(file->filename(), pageNo, frame);
+      }
+      if (slot_key == EMPTY_KEY || slot_key == (key | DELETED_BIT)) {
+        // Claim the slot, publish the frame, then publish the key.
+        if (!slot.key.compare_exchange_strong(slot_key, key | BUSY_BIT,
+                                              std::memory_order_acq_rel)) {
+          // Lost the slot to another writer; look at it again since it may
+          // now hold our key.
+          continue;
+        }
+        slot.frame.store(frameNo, std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        bool too_full = false;
+        if (slot_key == EMPTY_KEY) {
+          const std::uint64_t used = table->used.fetch_add(1) + 1;
+          too_full = used * 2 > table->mask + 1;
+        }
+        endWrite();
+        if (too_full) {
+          rebuild(table);
+        }
+        return;
+      }
+      index = (index + 1) & table->mask;
+      ++probes;
+    }
+    // No empty slot left at all; purge the removed keys and try again.
+    endWrite();
+    rebuild(table);
+  }
+}
+
+void PageTable::remove(const File* file, const PageId pageNo) {
+  const std::uint64_t key = makeKey(file, pageNo);
+  beginWrite();
+  Table* table = table_.load();
+  std::uint64_t index = hash(key) & table->mask;
+  for (std::uint64_t probes = 0; probes <= table->mask; ++probes) {
+    Slot& slot = table->slots[index];
+    std::uint64_t slot_key = slot.key.load(std::memory_order_acquire);
+    if (slot_key == key &&
+        slot.key.compare_exchange_strong(slot_key, key | DELETED_BIT,
+                                         std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      endWrite();
+      return;
+    }
+    if (slot_key == EMPTY_KEY || (slot_key & ~(DELETED_BIT | BUSY_BIT)) == key) {
+      // Removed already, or still being inserted by another thread.
+      break;
+    }
+    index = (index + 1) & table->mask;
+  }
+  endWrite();
+  throw HashNotFoundException(file->filename(), pageNo);
+}
+
+void PageTable::beginWrite() {
+  for (;;) {
+    while (rebuilding_.load()) {
+      std::this_thread::yield();
+    }
+    writers_.fetch_add(1);
+    if (!rebuilding_.load()) {
+      return;
+    }
+    writers_.fetch_sub(1);
+  }
+}
+
+void PageTable::endWrite() {
+  writers_.fetch_sub(1);
+}
+
+void PageTable::rebuild(Table* expected) {
+  std::lock_guard<std::mutex> guard(rebuild_mutex_);
+  if (table_.load() != expected) {
+    return;
+  }
+  rebuilding_.store(true);
+  while (writers_.load() != 0) {
+    std::this_thread::yield();
+  }
+
+  // With all writers drained no slot is half-inserted, so every key without
+  // flag bits is a live entry with its frame published.
+  Table* old_table = expected;
+  std::uint64_t num_slots = old_table->mask + 1;
+  while (num_slots < static_cast<std::uint64_t>(size_.load()) * 4) {
+    num_slots <<= 1;
+  }
+  Table* new_table = new Table(num_slots);
+  for (std::uint64_t i = 0; i <= old_table->mask; ++i) {
+    const std::uint64_t key =
+        old_table->slots[i].key.load(std::memory_order_relaxed);
+    if (key == EMPTY_KEY || (key & DELETED_BIT) != 0) {
+      continue;
+    }
+    std::uint64_t index = hash(key) & new_table->mask;
+    while (new_table->slots[index].key.load(std::memory_order_relaxed) !=
+           EMPTY_KEY) {
+      index = (index + 1) & new_table->mask;
+    }
+    new_table->slots[index].frame.store(
+        old_table->slots[i].frame.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    new_table->slots[index].key.store(key, std::memory_order_relaxed);
+    new_table->used.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  table_.store(new_table);
+  rebuilding_.store(false);
+  // Readers may still be probing the old array.
+  EpochManager::instance().retire(old_table, &PageTable::deleteTable);
+}
+
+void PageTable::deleteTable(void* table) {
+  delete static_cast<Table*>(table);
+}
+
+}
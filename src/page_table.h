@@ -0,0 +1,200 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Lock-free hash table mapping (file, page) to buffer frames.
+ *
+ * The table uses open addressing with linear probing over a flat array of
+ * slots, so inserting an entry never allocates.  Every slot holds a 64-bit key
+ * built from File::id() and the page number; slots are claimed with a
+ * compare-and-swap on the key.  A removed entry keeps its key with a deleted
+ * mark, and only an insert of the same key may revive that slot, so a key
+ * occupies at most one slot of the array.  This makes insert, lookup and remove
+ * linearizable without any lock: concurrent inserts of the same page race on
+ * the same slot, and a reader can never observe a key paired with the frame of
+ * a different key.  Pages that are evicted and read back over and over keep
+ * reusing their slot.
+ *
+ * Slots left behind by removed keys are purged by rebuilding the slot array
+ * once half of it is used.  A rebuild briefly holds off writers, while readers
+ * carry on in the old array; the old array is reclaimed through the
+ * EpochManager once no reader can still be inside it.  Lookups therefore never block and never
+ * write to shared memory.
+ *
+ * A frame returned by lookup() is only a hint when other threads may remove
+ * the entry concurrently: callers that need a stable mapping have to pin the
+ * frame and validate that it still holds the page (see BufMgr::readPage()).
+ */
+class PageTable {
+ public:
+  /**
+   * Constructs a table sized for the given number of entries.
+   *
+   * @param capacity  Number of entries expected to be in the table at the
+   *                  same time.  The table grows if more are inserted.
+   */
+  explicit PageTable(const std::uint32_t capacity);
+
+  /**
+   * Destroys the table.  No other thread may access the table anymore.
+   */
+  ~PageTable();
+
+  /**
+   * Looks up the frame holding (file, pageNo).  Never blocks.
+   *
+   * @param file      File object
+   * @param pageNo    Page number in the file
+   * @param frameNo   Frame number of the page, returned via this reference
+   * @return  True if the page is in the table.
+   */
+  bool lookup(const File* file, const PageId pageNo, FrameId& frameNo) const;
+
+  /**
+   * Inserts an entry mapping (file, pageNo) to frameNo.
+   *
+   * @param file      File object
+   * @param pageNo    Page number in the file
+   * @param frameNo   Frame number assigned to that page of the file
+   * @throws  HashAlreadyPresentException if the page is already in the table
+   */
+  void insert(const File* file, const PageId pageNo, const FrameId frameNo);
+
+  /**
+   * Removes the entry of (file, pageNo).
+   *
+   * @param file      File object
+   * @param pageNo    Page number in the file
+   * @throws  HashNotFoundException if the page is not in the table
+   */
+  void remove(const File* file, const PageId pageNo);
+
+  /**
+   * Returns the number of entries in the table.
+   */
+  std::uint32_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  /**
+   * Key of a slot which has never been used.
+   */
+  static const std::uint64_t EMPTY_KEY = 0;
+
+  /**
+   * Set in the key of a slot whose entry was removed.
+   */
+  static const std::uint64_t DELETED_BIT = 1ULL << 63;
+
+  /**
+   * Set in the key of a slot which is being inserted into and whose frame has
+   * not been published yet.
+   */
+  static const std::uint64_t BUSY_BIT = 1ULL << 62;
+
+  /**
+   * @brief One entry of the table.
+   */
+  struct Slot {
+    std::atomic<std::uint64_t> key;
+    std::atomic<FrameId> frame;
+  };
+
+  /**
+   * @brief Slot array of the table together with its bookkeeping.
+   */
+  struct Table {
+    explicit Table(const std::uint64_t num_slots);
+    ~Table();
+
+    /**
+     * Number of slots minus one; the number of slots is a power of two.
+     */
+    std::uint64_t mask;
+
+    /**
+     * Number of slots which are not empty (entries plus removed keys).
+     */
+    std::atomic<std::uint64_t> used;
+
+    Slot* slots;
+  };
+
+  /**
+   * Builds the key of (file, pageNo).  File ids stay far below 2^30, so the
+   * two highest bits are free for DELETED_BIT and BUSY_BIT.
+   */
+  static std::uint64_t makeKey(const File* file, const PageId pageNo) {
+    return (static_cast<std::uint64_t>(file->id()) << 32) | pageNo;
+  }
+
+  /**
+   * Returns the home slot of a key.
+   */
+  static std::uint64_t hash(const std::uint64_t key);
+
+  /**
+   * Registers the calling thread as a writer, waiting out a rebuild.
+   */
+  void beginWrite();
+
+  /**
+   * Unregisters the calling thread as a writer.
+   */
+  void endWrite();
+
+  /**
+   * Replaces the slot array with a fresh one without removed keys, growing it
+   * if the table is more than a quarter full.
+   *
+   * @param expected  Array the caller found to be too full; nothing is done if
+   *                  it has been replaced already.
+   */
+  void rebuild(Table* expected);
+
+  /**
+   * Deletes a retired slot array.
+   */
+  static void deleteTable(void* table);
+
+  /**
+   * Current slot array.
+   */
+  std::atomic<Table*> table_;
+
+  /**
+   * Number of entries in the table.
+   */
+  std::atomic<std::uint32_t> size_;
+
+  /**
+   * Number of threads currently inserting or removing entries.
+   */
+  std::atomic<int> writers_;
+
+  /**
+   * True while a rebuild is in progress.
+   */
+  std::atomic<bool> rebuilding_;
+
+  /**
+   * Serializes rebuilds.
+   */
+  std::mutex rebuild_mutex_;
+};
+
+}
@@ -0,0 +1,37 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "replacement_policy.h"
+
+#include "arc_policy.h"
+#include "clock_policy.h"
+#include "clock_pro_policy.h"
+#include "lru_k_policy.h"
+#include "two_q_policy.h"
+
+namespace badgerdb {
+
+ReplacementPolicy* ReplacementPolicy::create(const PolicyKind kind,
+                                             const FrameId firstFrame,
+                                             const std::uint32_t numFrames,
+                                             const std::atomic<int>* pinCounts) {
+  switch (kind) {
+    case PolicyKind::LRU_K:
+      return new LruKPolicy(firstFrame, numFrames);
+    case PolicyKind::TWO_Q:
+      return new TwoQPolicy(firstFrame, numFrames);
+    case PolicyKind::ARC:
+      return new ArcPolicy(firstFrame, numFrames);
+    case PolicyKind::CLOCK_PRO:
+      return new ClockProPolicy(firstFrame, numFrames);
+    case PolicyKind::CLOCK:
+    default:
+      return new ClockPolicy(firstFrame, numFrames, pinCounts);
+  }
+}
+
+}
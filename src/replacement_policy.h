@@ -0,0 +1,212 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Replacement policies a BufMgr can be built with.
+ */
+enum class PolicyKind {
+  /**
+   * Clock with one reference bit per frame (the classic BadgerDB policy).
+   */
+  CLOCK,
+
+  /**
+   * LRU-2: evicts the page whose second most recent reference is oldest.
+   */
+  LRU_K,
+
+  /**
+   * Full 2Q with a FIFO for pages seen once and an LRU for pages seen again.
+   */
+  TWO_Q,
+
+  /**
+   * Adaptive Replacement Cache.
+   */
+  ARC,
+
+  /**
+   * CLOCK-Pro, a clock approximation of LIRS with hot and cold pages.
+   */
+  CLOCK_PRO
+};
+
+/**
+ * @brief Decides which frame of a buffer pool shard is reused for a page that
+ *        is not in the pool.
+ *
+ * Every shard of a BufMgr owns one policy for its range of frames.  The buffer
+ * manager tells the policy about every event on those frames: a page loaded
+ * into a frame (onLoad()), a resident page requested again (onHit()), a frame
+ * pinned or unpinned (onPin(), onUnpin()), and a page leaving its frame because
+ * it was evicted (onEvict()) or dropped from the pool (onRemove()).  When a page
+ * has to be read in, pickVictim() chooses the frame for it.
+ *
+ * Unless isLatchFree() returns true, all methods are called with the latch of
+ * the shard held, so implementations need no locking of their own.
+ */
+class ReplacementPolicy {
+ public:
+  /**
+   * Called by pickVictim() on candidate frames in order of preference.  Returns
+   * true if the frame could be taken: it was unpinned and is now locked for the
+   * caller.
+   */
+  typedef std::function<bool(FrameId)> TakeFrame;
+
+  /**
+   * Creates a policy of the given kind.
+   *
+   * @param kind        Policy to create.
+   * @param firstFrame  First frame managed by the policy.
+   * @param numFrames   Number of frames managed by the policy.
+   * @param pinCounts   Pin counts of all frames, indexed by frame, which
+   *                    policies may read to skip pinned frames without
+   *                    calling TakeFrame; or NULL.
+   * @return  The new policy, owned by the caller.
+   */
+  static ReplacementPolicy* create(const PolicyKind kind,
+                                   const FrameId firstFrame,
+                                   const std::uint32_t numFrames,
+                                   const std::atomic<int>* pinCounts = NULL);
+
+  virtual ~ReplacementPolicy() {}
+
+  /**
+   * Returns the name of the policy.
+   */
+  virtual const char* name() const = 0;
+
+  /**
+   * Returns true if onHit(), onPin() and onUnpin() may be called concurrently
+   * with each other and with the other methods, without the shard latch.  A
+   * concurrent BufMgr only pins resident pages without taking the latch if its
+   * policy allows it.
+   */
+  virtual bool isLatchFree() const { return false; }
+
+  /**
+   * Called when a page that is in the pool is requested again.
+   *
+   * @param frame   Frame holding the page.
+   */
+  virtual void onHit(const FrameId frame) = 0;
+
+  /**
+   * Called when a page that is not in the pool has been requested, before a
+   * frame is chosen for it.
+   *
+   * @param file    File of the page.
+   * @param pageNo  Number of the page in the file.
+   */
+  virtual void onMiss(const File* file, const PageId pageNo) {}
+
+  /**
+   * Chooses the frame a missing page is read into: a free frame if there is
+   * one, otherwise the frame of the page to evict.  Candidates are passed to
+   * take until it accepts one.  The policy is not told about the outcome until
+   * onEvict() or onLoad() is called.
+   *
+   * @param take    Tries to take a candidate frame.
+   * @param frame   Frame that was taken, returned via this reference.
+   * @return  False if no frame could be taken because all are pinned.
+   */
+  virtual bool pickVictim(const TakeFrame& take, FrameId& frame) = 0;
+
+  /**
+   * Called when the page in a frame returned by pickVictim() is evicted.  The
+   * frame is free afterwards.
+   *
+   * @param frame   Frame of the evicted page.
+   */
+  virtual void onEvict(const FrameId frame) = 0;
+
+  /**
+   * Called when a page has been placed into a free frame.
+   *
+   * @param frame   Frame now holding the page.
+   * @param file    File of the page.
+   * @param pageNo  Number of the page in the file.
+   */
+  virtual void onLoad(const FrameId frame, const File* file,
+                      const PageId pageNo) = 0;
+
+  /**
+   * Called instead of onLoad() when a page has been placed into a free frame
+   * that is not expected to be requested again soon: a page read ahead of any
+   * request, or a page read by a scan through a ScanRing.  Unless the page is
+   * requested again (onHit()), it should be evicted before the pages loaded
+   * with onLoad().  If the frame is pinned, onPin() follows.  The default
+   * treats it like any other page.
+   *
+   * @param frame   Frame now holding the page.
+   * @param file    File of the page.
+   * @param pageNo  Number of the page in the file.
+   */
+  virtual void onLoadCold(const FrameId frame, const File* file,
+                          const PageId pageNo) {
+    onLoad(frame, file, pageNo);
+  }
+
+  /**
+   * Called when a page leaves the pool other than by eviction, because it was
+   * flushed with its file or deleted.  The frame is free afterwards, and the
+   * page should not be remembered as recently evicted.
+   *
+   * @param frame   Frame that held the page.
+   */
+  virtual void onRemove(const FrameId frame) = 0;
+
+  /**
+   * Called each time the page in a frame is pinned, after onLoad() or onHit().
+   *
+   * @param frame   Pinned frame.
+   */
+  virtual void onPin(const FrameId frame) {}
+
+  /**
+   * Called each time a pin of the page in a frame is released.
+   *
+   * @param frame     Unpinned frame.
+   * @param unpinned  True if no pins are left on the frame.
+   */
+  virtual void onUnpin(const FrameId frame, const bool unpinned) {}
+
+  /**
+   * Lists frames in the order the policy expects to evict their pages, without
+   * changing its state, so that dirty pages can be written out before they
+   * are evicted.  Free frames need not be listed.  The default lists none.
+   *
+   * @param count   Maximum number of frames to list.
+   * @param frames  Vector the frames are appended to.
+   */
+  virtual void nextVictims(const std::uint32_t count,
+                           std::vector<FrameId>& frames) const {}
+
+ protected:
+  /**
+   * Builds a key identifying (file, pageNo), for policies which remember pages
+   * after they have been evicted.
+   */
+  static std::uint64_t pageKey(const File* file, const PageId pageNo) {
+    return (static_cast<std::uint64_t>(file->id()) << 32) | pageNo;
+  }
+};
+
+}
@@ -0,0 +1,146 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "two_q_policy.h"
+
+namespace badgerdb {
+
+TwoQPolicy::TwoQPolicy(const FrameId firstFrame,
+                       const std::uint32_t numFrames)
+    : first_frame_(firstFrame),
+      max_in_(numFrames / 4 > 0 ? numFrames / 4 : 1),
+      max_out_(numFrames / 2 > 0 ? numFrames / 2 : 1),
+      frames_(numFrames) {
+  for (std::uint32_t i = 0; i < numFrames; ++i) {
+    frames_[i].queue = NONE;
+    frames_[i].key = 0;
+    free_.insert(first_frame_ + i);
+  }
+}
+
+void TwoQPolicy::onHit(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == AM) {
+    am_.splice(am_.begin(), am_, state.position);
+  }
+}
+
+bool TwoQPolicy::takeFrom(const std::list<FrameId>& list,
+                          const TakeFrame& take, FrameId& frame) {
+  for (std::list<FrameId>::const_reverse_iterator it = list.rbegin();
+       it != list.rend(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwoQPolicy::listFrom(const std::list<FrameId>& list,
+                          const std::uint32_t count, std::vector<FrameId>& frames) {
+  std::uint32_t listed = 0;
+  for (std::list<FrameId>::const_reverse_iterator it = list.rbegin();
+       it != list.rend() && listed < count; ++it, ++listed) {
+    frames.push_back(*it);
+  }
+}
+
+bool TwoQPolicy::pickVictim(const TakeFrame& take, FrameId& frame) {
+  for (std::set<FrameId>::const_iterator it = free_.begin();
+       it != free_.end(); ++it) {
+    if (take(*it)) {
+      frame = *it;
+      return true;
+    }
+  }
+  if (a1in_.size() > max_in_ || am_.empty()) {
+    return takeFrom(a1in_, take, frame) || takeFrom(am_, take, frame);
+  }
+  return takeFrom(am_, take, frame) || takeFrom(a1in_, take, frame);
+}
+
+void TwoQPolicy::nextVictims(const std::uint32_t count,
+                             std::vector<FrameId>& frames) const {
+  const std::size_t before = frames.size();
+  if (a1in_.size() > max_in_ || am_.empty()) {
+    listFrom(a1in_, count, frames);
+    listFrom(am_, count - (frames.size() - before), frames);
+  } else {
+    listFrom(am_, count, frames);
+    listFrom(a1in_, count - (frames.size() - before), frames);
+  }
+}
+
+void TwoQPolicy::onEvict(const FrameId frame) {
+  const FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == A1IN) {
+    a1out_.push_front(state.key);
+    a1out_index_[state.key] = a1out_.begin();
+    if (a1out_.size() > max_out_) {
+      a1out_index_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+  release(frame);
+}
+
+void TwoQPolicy::onLoad(const FrameId frame, const File* file,
+                        const PageId pageNo) {
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  std::unordered_map<std::uint64_t,
+                     std::list<std::uint64_t>::iterator>::iterator ghost =
+      a1out_index_.find(state.key);
+  if (ghost != a1out_index_.end()) {
+    a1out_.erase(ghost->second);
+    a1out_index_.erase(ghost);
+    am_.push_front(frame);
+    state.queue = AM;
+    state.position = am_.begin();
+  } else {
+    a1in_.push_front(frame);
+    state.queue = A1IN;
+    state.position = a1in_.begin();
+  }
+}
+
+void TwoQPolicy::onLoadCold(const FrameId frame, const File* file,
+                            const PageId pageNo) {
+  // The back of A1in goes first.
+  FrameState& state = frames_[frame - first_frame_];
+  free_.erase(frame);
+  state.key = pageKey(file, pageNo);
+  std::unordered_map<std::uint64_t,
+                     std::list<std::uint64_t>::iterator>::iterator ghost =
+      a1out_index_.find(state.key);
+  if (ghost != a1out_index_.end()) {
+    a1out_.erase(ghost->second);
+    a1out_index_.erase(ghost);
+  }
+  a1in_.push_back(frame);
+  state.queue = A1IN;
+  state.position = --a1in_.end();
+}
+
+void TwoQPolicy::onRemove(const FrameId frame) {
+  release(frame);
+}
+
+void TwoQPolicy::release(const FrameId frame) {
+  FrameState& state = frames_[frame - first_frame_];
+  if (state.queue == A1IN) {
+    a1in_.erase(state.position);
+  } else if (state.queue == AM) {
+    am_.erase(state.position);
+  }
+  state.queue = NONE;
+  free_.insert(frame);
+}
+
+}
@@ -0,0 +1,119 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Full 2Q replacement (Johnson and Shasha).
+ *
+ * Pages enter the pool through A1in, a FIFO holding up to a quarter of the
+ * frames; hits on pages in A1in do not move them.  When a page is evicted from
+ * A1in its key is remembered in A1out, a FIFO of up to half as many keys as
+ * there are frames.  A page that misses while its key is in A1out has been
+ * used twice in a short time and goes to Am, an LRU list of frequently used
+ * pages.  Victims are taken from A1in while it is over its share, otherwise
+ * from the least recently used end of Am, so one long scan only cycles
+ * through A1in.
+ */
+class TwoQPolicy : public ReplacementPolicy {
+ public:
+  TwoQPolicy(const FrameId firstFrame, const std::uint32_t numFrames);
+
+  const char* name() const { return "2Q"; }
+  void onHit(const FrameId frame);
+  bool pickVictim(const TakeFrame& take, FrameId& frame);
+  void onEvict(const FrameId frame);
+  void onLoad(const FrameId frame, const File* file, const PageId pageNo);
+  void onLoadCold(const FrameId frame, const File* file,
+                  const PageId pageNo);
+  void onRemove(const FrameId frame);
+  void nextVictims(const std::uint32_t count,
+                   std::vector<FrameId>& frames) const;
+
+ private:
+  /**
+   * Lists a resident page can be in.
+   */
+  enum Queue { NONE, A1IN, AM };
+
+  /**
+   * @brief State of one frame.
+   */
+  struct FrameState {
+    Queue queue;
+    std::list<FrameId>::iterator position;
+    std::uint64_t key;
+  };
+
+  /**
+   * Takes the first frame of the list, from its back, that take accepts.
+   */
+  static bool takeFrom(const std::list<FrameId>& list, const TakeFrame& take,
+                       FrameId& frame);
+
+  /**
+   * Appends frames of the list, from its back, until count frames are listed.
+   */
+  static void listFrom(const std::list<FrameId>& list,
+                       const std::uint32_t count, std::vector<FrameId>& frames);
+
+  /**
+   * Unlinks a frame from its list and frees it.
+   */
+  void release(const FrameId frame);
+
+  const FrameId first_frame_;
+
+  /**
+   * Maximum size of A1in, in frames.
+   */
+  const std::size_t max_in_;
+
+  /**
+   * Maximum size of A1out, in keys.
+   */
+  const std::size_t max_out_;
+
+  /**
+   * State of every frame, indexed by frame - first_frame_.
+   */
+  std::vector<FrameState> frames_;
+
+  /**
+   * Frames not holding a page.
+   */
+  std::set<FrameId> free_;
+
+  /**
+   * Resident pages seen once, newest first.
+   */
+  std::list<FrameId> a1in_;
+
+  /**
+   * Resident pages seen again, most recently used first.
+   */
+  std::list<FrameId> am_;
+
+  /**
+   * Keys of pages recently evicted from A1in, newest first, and their
+   * positions in the list.
+   */
+  std::list<std::uint64_t> a1out_;
+  std::unordered_map<std::uint64_t, std::list<std::uint64_t>::iterator>
+      a1out_index_;
+};
+
+}